@@ -114,6 +114,11 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to split large batches of geometry shader invocations across threads. Shaders that carry
+# state from one invocation to the next can render incorrectly.
+# 0 (default): Off, 1: On
+parallel_geometry_shader =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -232,12 +237,18 @@ enable_dsp_lle_thread =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether or not to spread HLE DSP source processing across worker threads.
+# The mixed output is identical either way; this only helps when many voices are active.
+# 0 (default): No, 1: Yes
+hle_audio_multithread =
+
 # Output volume.
 # 1.0 (default): 100%, 0.0; mute
 volume =
 
 # Which audio output type to use.
-# 0 (default): Auto-select, 1: No audio output, 2: Cubeb (if available), 3: OpenAL (if available), 4: SDL2 (if available)
+# 0 (default): Auto-select, 1: No audio output, 2: Cubeb (if available), 3: OpenAL (if available), 4: SDL2 (if available),
+# 5: Offline (no device; audio is never stretched or padded and does not pace emulation)
 output_type =
 
 # Which audio output device to use.
@@ -45,7 +45,11 @@ void DspInterface::OutputFrame(StereoFrame16 frame) {
     if (!sink)
         return;
 
-    fifo.Push(frame.data(), frame.size());
+    if (sink->IsSynchronous()) {
+        sink->PushFrames(frame[0].data(), frame.size());
+    } else {
+        fifo.Push(frame.data(), frame.size());
+    }
 
     auto video_dumper = Core::System::GetInstance().GetVideoDumper();
     if (video_dumper && video_dumper->IsDumping()) {
@@ -57,7 +61,11 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
     if (!sink)
         return;
 
-    fifo.Push(&sample, 1);
+    if (sink->IsSynchronous()) {
+        sink->PushFrames(sample.data(), 1);
+    } else {
+        fifo.Push(&sample, 1);
+    }
 
     auto video_dumper = Core::System::GetInstance().GetVideoDumper();
     if (video_dumper && video_dumper->IsDumping()) {
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -28,6 +30,8 @@
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/perf_sections.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 
@@ -72,6 +76,8 @@ public:
 
     void SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp);
 
+    void SetMultithreaded(bool enable);
+
 private:
     void ResetPipes();
     void WriteU16(DspPipe pipe_number, u16 value);
@@ -81,6 +87,7 @@ private:
     HLE::SharedMemory& ReadRegion();
     HLE::SharedMemory& WriteRegion();
 
+    void TickSources(HLE::SharedMemory& read, HLE::SharedMemory& write);
     StereoFrame16 GenerateCurrentFrame();
     bool Tick();
     void AudioTickCallback(s64 cycles_late);
@@ -104,6 +111,8 @@ private:
 
     std::unique_ptr<HLE::DecoderBase> decoder{};
 
+    std::unique_ptr<Common::ThreadWorker> source_workers{};
+
     std::weak_ptr<DSP_DSP> dsp_dsp{};
 
     template <class Archive>
@@ -413,16 +422,56 @@ HLE::SharedMemory& DspHle::Impl::WriteRegion() {
     return CurrentRegionIndex() != 0 ? dsp_memory.region_0 : dsp_memory.region_1;
 }
 
+void DspHle::Impl::SetMultithreaded(bool enable) {
+    if (!enable) {
+        source_workers.reset();
+        return;
+    }
+    if (source_workers) {
+        return;
+    }
+
+    // Per-source work is small, so only a handful of workers is worth the wakeup cost.
+    const std::size_t num_workers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
+    source_workers = std::make_unique<Common::ThreadWorker>(num_workers, "DspHle:Sources");
+}
+
+void DspHle::Impl::TickSources(HLE::SharedMemory& read, HLE::SharedMemory& write) {
+    // Each source only touches its own configuration and status entries, so ranges of sources can
+    // be processed concurrently.
+    const auto tick_range = [this, &read, &write](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            write.source_statuses.status[i] = sources[i].Tick(read.source_configurations.config[i],
+                                                              read.adpcm_coefficients.coeff[i]);
+        }
+    };
+
+    if (!source_workers) {
+        tick_range(0, HLE::num_sources);
+        return;
+    }
+
+    const std::size_t num_workers = source_workers->NumWorkers();
+    const std::size_t chunk_size = (HLE::num_sources + num_workers - 1) / num_workers;
+    for (std::size_t begin = 0; begin < HLE::num_sources; begin += chunk_size) {
+        const std::size_t end = std::min(begin + chunk_size, HLE::num_sources);
+        source_workers->QueueWork([&tick_range, begin, end] { tick_range(begin, end); });
+    }
+    source_workers->WaitForRequests();
+}
+
 StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
     HLE::SharedMemory& read = ReadRegion();
     HLE::SharedMemory& write = WriteRegion();
 
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
-    // Generate intermediate mixes
+    TickSources(read, write);
+
+    // Generate intermediate mixes. This is always done in source order to keep the output
+    // deterministic.
     for (std::size_t i = 0; i < HLE::num_sources; i++) {
-        write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
         for (std::size_t mix = 0; mix < 3; mix++) {
             sources[i].MixInto(intermediate_mixes[mix], mix);
         }
@@ -445,6 +494,7 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
 }
 
 bool DspHle::Impl::Tick() {
+    Common::ScopedPerfSection section{Common::PerfSection::Audio};
     StereoFrame16 current_frame = {};
 
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
@@ -506,6 +556,10 @@ void DspHle::SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp) {
     impl->SetServiceToInterrupt(std::move(dsp));
 }
 
+void DspHle::SetMultithreaded(bool enable) {
+    impl->SetMultithreaded(enable);
+}
+
 void DspHle::LoadComponent(const std::vector<u8>& component_data) {
     // HLE doesn't need DSP program. Only log some info here
     LOG_INFO(Service_DSP, "Firmware hash: {:#018x}",
@@ -39,6 +39,12 @@ public:
     void LoadComponent(const std::vector<u8>& buffer) override;
     void UnloadComponent() override;
 
+    /**
+     * Enables or disables processing of sources on worker threads. Sources are independent of
+     * each other and are mixed in order afterwards, so the output is identical either way.
+     */
+    void SetMultithreaded(bool enable);
+
 private:
     struct Impl;
     friend struct Impl;
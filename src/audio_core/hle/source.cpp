@@ -30,12 +30,23 @@ void Source::MixInto(QuadFrame32& dest, std::size_t intermediate_mix_id) const {
         return;
 
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
+
+    // Most sources only feed one of the intermediate mixers; a silent send contributes nothing.
+    if (std::all_of(gains.begin(), gains.end(), [](float gain) { return gain == 0.0f; })) {
+        return;
+    }
+
+    // The gains are hoisted into locals so the loop below has no aliasing with dest and can be
+    // vectorised by the compiler.
+    const float gain0 = gains[0], gain1 = gains[1], gain2 = gains[2], gain3 = gains[3];
     for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        const float left = current_frame[samplei][0];
+        const float right = current_frame[samplei][1];
         // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
-        dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
-        dest[samplei][1] += static_cast<s32>(gains[1] * current_frame[samplei][1]);
-        dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
-        dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
+        dest[samplei][0] += static_cast<s32>(gain0 * left);
+        dest[samplei][1] += static_cast<s32>(gain1 * right);
+        dest[samplei][2] += static_cast<s32>(gain2 * left);
+        dest[samplei][3] += static_cast<s32>(gain3 * right);
     }
 }
 
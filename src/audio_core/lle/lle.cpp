@@ -13,7 +13,7 @@
 #include "common/thread.h"
 #include "core/core.h"
 #include "core/core_timing.h"
-#include "core/hle/lock.h"
+#include "core/hle/mailbox.h"
 #include "core/hle/service/dsp/dsp_dsp.h"
 
 namespace AudioCore {
@@ -413,21 +413,23 @@ void DspLle::SetServiceToInterrupt(std::weak_ptr<Service::DSP::DSP_DSP> dsp) {
         if (!impl->loaded)
             return;
 
-        std::lock_guard lock(HLE::g_hle_lock);
-        if (auto locked = dsp.lock()) {
-            locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Zero,
-                                    static_cast<DspPipe>(0));
-        }
+        HLE::PostToEmuThread([dsp] {
+            if (auto locked = dsp.lock()) {
+                locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Zero,
+                                        static_cast<DspPipe>(0));
+            }
+        });
     });
     impl->teakra.SetRecvDataHandler(1, [this, dsp]() {
         if (!impl->loaded)
             return;
 
-        std::lock_guard lock(HLE::g_hle_lock);
-        if (auto locked = dsp.lock()) {
-            locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::One,
-                                    static_cast<DspPipe>(0));
-        }
+        HLE::PostToEmuThread([dsp] {
+            if (auto locked = dsp.lock()) {
+                locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::One,
+                                        static_cast<DspPipe>(0));
+            }
+        });
     });
 
     auto ProcessPipeEvent = [this, dsp](bool event_from_data) {
@@ -455,11 +457,12 @@ void DspLle::SetServiceToInterrupt(std::weak_ptr<Service::DSP::DSP_DSP> dsp) {
                 impl->ReadPipe(static_cast<u8>(pipe),
                                impl->GetPipeReadableSize(static_cast<u8>(pipe)));
             } else {
-                std::lock_guard lock(HLE::g_hle_lock);
-                if (auto locked = dsp.lock()) {
-                    locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Pipe,
-                                            static_cast<DspPipe>(pipe));
-                }
+                HLE::PostToEmuThread([dsp, pipe] {
+                    if (auto locked = dsp.lock()) {
+                        locked->SignalInterrupt(Service::DSP::DSP_DSP::InterruptType::Pipe,
+                                                static_cast<DspPipe>(pipe));
+                    }
+                });
             }
         }
     };
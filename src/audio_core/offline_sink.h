@@ -0,0 +1,63 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include "audio_core/audio_types.h"
+#include "audio_core/sink.h"
+
+namespace AudioCore {
+
+/**
+ * A sink without an audio device. Frames are handed over synchronously as the DSP produces them,
+ * without time stretching, padding or volume scaling, so the emulator is never paced by audio and
+ * the resulting stream is bit-exact. Intended for headless runs, dumping and regression diffing.
+ */
+class OfflineSink final : public Sink {
+public:
+    using FrameConsumer = std::function<void(const s16*, std::size_t)>;
+
+    explicit OfflineSink(std::string_view) {}
+    ~OfflineSink() override = default;
+
+    unsigned int GetNativeSampleRate() const override {
+        return native_sample_rate;
+    }
+
+    void SetCallback(std::function<void(s16*, std::size_t)>) override {}
+
+    bool IsSynchronous() const override {
+        return true;
+    }
+
+    void PushFrames(const s16* samples, std::size_t num_frames) override {
+        total_frames += num_frames;
+        if (consumer) {
+            consumer(samples, num_frames);
+        }
+    }
+
+    /**
+     * Sets the function that receives every frame pushed to this sink. This is called on the
+     * thread producing audio, so it should be set before emulation starts.
+     * @param consumer_ Receives interleaved stereo PCM16 samples and the number of frames.
+     */
+    void SetFrameConsumer(FrameConsumer consumer_) {
+        consumer = std::move(consumer_);
+    }
+
+    /// Returns the number of frames pushed to this sink so far.
+    u64 GetTotalFrames() const {
+        return total_frames;
+    }
+
+private:
+    FrameConsumer consumer;
+    u64 total_frames = 0;
+};
+
+} // namespace AudioCore
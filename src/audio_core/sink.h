@@ -30,6 +30,21 @@ public:
      * @param sample_count Number of samples.
      */
     virtual void SetCallback(std::function<void(s16*, std::size_t)> cb) = 0;
+
+    /**
+     * Whether this sink receives audio through PushFrames as it is produced, instead of pulling it
+     * through the callback. Synchronous sinks get the DSP output unmodified.
+     */
+    virtual bool IsSynchronous() const {
+        return false;
+    }
+
+    /**
+     * Hands frames to a synchronous sink. Only called when IsSynchronous returns true.
+     * @param samples Samples in interleaved stereo PCM16 format.
+     * @param num_frames Number of stereo frames.
+     */
+    virtual void PushFrames(const s16* samples, std::size_t num_frames) {}
 };
 
 } // namespace AudioCore
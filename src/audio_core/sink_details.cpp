@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include "audio_core/null_sink.h"
+#include "audio_core/offline_sink.h"
 #include "audio_core/sink_details.h"
 #ifdef HAVE_SDL2
 #include "audio_core/sdl2_sink.h"
@@ -63,6 +64,11 @@ constexpr std::array sink_details = {
                     return std::make_unique<NullSink>(device_id);
                 },
                 [] { return std::vector<std::string>{"None"}; }},
+    SinkDetails{SinkType::Offline, "Offline",
+                [](std::string_view device_id) -> std::unique_ptr<Sink> {
+                    return std::make_unique<OfflineSink>(device_id);
+                },
+                [] { return std::vector<std::string>{"None"}; }},
 };
 
 const SinkDetails& GetSinkDetails(SinkType sink_type) {
@@ -11,7 +11,11 @@
 // This needs to be included before getopt.h because the latter #defines symbols used by it
 #include "common/microprofile.h"
 
+#include "audio_core/dsp_interface.h"
+#include "audio_core/offline_sink.h"
+#include "audio_core/sink_details.h"
 #include "citra/config.h"
+#include "citra/emu_window/emu_window_headless.h"
 #include "citra/emu_window/emu_window_sdl2.h"
 #include "citra/emu_window/emu_window_sdl2_gl.h"
 #include "citra/emu_window/emu_window_sdl2_sw.h"
@@ -34,6 +38,7 @@
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
+#include "core/hle/service/service.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
 #include "input_common/main.h"
@@ -71,6 +76,14 @@ static void PrintHelp(const char* argv0) {
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
+                 "-H, --headless       Run without a window on the software renderer, unthrottled\n"
+                 "-n, --frames=NUMBER  Exit after NUMBER emulated frames (headless only)\n"
+                 "-o, --hash-out=[file] Write per-frame framebuffer and audio hashes to the given "
+                 "file (headless only)\n"
+                 "-P, --ipc-profile=[file] Write per-service HLE IPC statistics to the given file "
+                 "as CSV on exit\n"
+                 "-T, --perf-log=[file] Write per-frame host times broken down by subsystem to the "
+                 "given file on exit, as JSON if it ends with .json and CSV otherwise\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
 }
@@ -178,6 +191,7 @@ static void InitializeLogging() {
     Log::Filter log_filter(Log::Level::Debug);
     log_filter.ParseFilterString(Settings::values.log_filter.GetValue());
     Log::SetGlobalFilter(log_filter);
+    Log::SetDeferredFormatting(Settings::values.log_deferred.GetValue());
 
     Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
 
@@ -200,6 +214,11 @@ int main(int argc, char** argv) {
     std::string movie_record_author;
     std::string movie_play;
     std::string dump_video;
+    bool headless = false;
+    u64 num_frames = 0;
+    std::string hash_out;
+    std::string ipc_profile;
+    std::string perf_log;
 
     InitializeLogging();
 
@@ -231,13 +250,18 @@ int main(int argc, char** argv) {
         {"movie-play", required_argument, 0, 'p'},
         {"dump-video", required_argument, 0, 'd'},
         {"fullscreen", no_argument, 0, 'f'},
+        {"headless", no_argument, 0, 'H'},
+        {"frames", required_argument, 0, 'n'},
+        {"hash-out", required_argument, 0, 'o'},
+        {"ipc-profile", required_argument, 0, 'P'},
+        {"perf-log", required_argument, 0, 'T'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:fHn:o:P:T:hv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -310,6 +334,28 @@ int main(int argc, char** argv) {
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
                 break;
+            case 'H':
+                headless = true;
+                break;
+            case 'n':
+                errno = 0;
+                num_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 'o':
+                hash_out = optarg;
+                break;
+            case 'P':
+                ipc_profile = optarg;
+                break;
+            case 'T':
+                perf_log = optarg;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -351,18 +397,43 @@ int main(int argc, char** argv) {
         Core::Movie::GetInstance().PrepareForPlayback(movie_play);
     }
 
+    if ((!hash_out.empty() || num_frames != 0) && !headless) {
+        LOG_CRITICAL(Frontend, "--frames and --hash-out require --headless");
+        return -1;
+    }
+
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (!perf_log.empty()) {
+        Settings::values.record_frame_times = true;
+    }
+    if (headless) {
+        // Run as fast as possible with a deterministic, device-less audio stream.
+        Settings::values.graphics_api = Settings::GraphicsAPI::Software;
+        Settings::values.frame_limit = 0;
+        Settings::values.output_type = AudioCore::SinkType::Offline;
+        Settings::values.enable_audio_stretching = false;
+        Settings::values.layout_option = Settings::LayoutOption::Default;
+    }
     Settings::Apply();
 
     // Register frontend applets
     Frontend::RegisterDefaultApplets();
 
-    EmuWindow_SDL2::InitializeSDL2();
+    if (headless) {
+        // There is no window, so only bring up the subsystems SDL2 would have initialized.
+        InputCommon::Init();
+        Network::Init();
+    } else {
+        EmuWindow_SDL2::InitializeSDL2();
+    }
 
-    const auto create_emu_window = [](bool fullscreen,
-                                      bool is_secondary) -> std::unique_ptr<EmuWindow_SDL2> {
+    const auto create_emu_window = [&](bool fullscreen,
+                                       bool is_secondary) -> std::unique_ptr<EmuWindow_SDL2> {
+        if (headless) {
+            return std::make_unique<EmuWindow_Headless>(num_frames, hash_out);
+        }
         switch (Settings::values.graphics_api.GetValue()) {
         case Settings::GraphicsAPI::OpenGL:
             return std::make_unique<EmuWindow_SDL2_GL>(fullscreen, is_secondary);
@@ -436,11 +507,22 @@ int main(int argc, char** argv) {
         }
     }
 
+    auto* const headless_window =
+        headless ? static_cast<EmuWindow_Headless*>(emu_window.get()) : nullptr;
+    if (headless_window) {
+        headless_window->AttachAudio(static_cast<AudioCore::OfflineSink&>(system.DSP().GetSink()));
+    }
+
     if (!movie_play.empty()) {
         auto metadata = Core::Movie::GetInstance().GetMovieMetadata(movie_play);
         LOG_INFO(Movie, "Author: {}", metadata.author);
         LOG_INFO(Movie, "Rerecord count: {}", metadata.rerecord_count);
         LOG_INFO(Movie, "Input count: {}", metadata.input_count);
+        if (headless_window && num_frames == 0) {
+            // Without an explicit frame count, a headless run ends with the movie.
+            Core::Movie::GetInstance().SetPlaybackCompletionCallback(
+                [headless_window] { headless_window->RequestClose(); });
+        }
         Core::Movie::GetInstance().StartPlayback(movie_play);
     }
     if (!movie_record.empty()) {
@@ -494,6 +576,20 @@ int main(int argc, char** argv) {
     main_render_thread.join();
     secondary_render_thread.join();
 
+    if (headless_window) {
+        const u64 frames = headless_window->GetFrameCount();
+        const double seconds = headless_window->GetElapsedTime().count();
+        std::cout << fmt::format("{}: {} frames in {:.3f}s ({:.2f} emulated FPS)\n", filepath,
+                                 frames, seconds, seconds > 0 ? frames / seconds : 0.0);
+    }
+
+    if (!ipc_profile.empty()) {
+        Service::DumpIPCProfile(ipc_profile);
+    }
+    if (!perf_log.empty() && system.perf_stats) {
+        system.perf_stats->DumpFrameRecords(perf_log);
+    }
+
     Core::Movie::GetInstance().Shutdown();
 
     auto video_dumper = system.GetVideoDumper();
@@ -118,6 +118,11 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to split large batches of geometry shader invocations across threads. Shaders that carry
+# state from one invocation to the next can render incorrectly.
+# 0 (default): Off, 1: On
+parallel_geometry_shader =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -127,6 +132,16 @@ use_vsync_new =
 # 0: Off, 1 (default. On)
 use_disk_shader_cache =
 
+# Compiles new shaders in the background instead of stalling the draw that needs them.
+# Only used on desktop OpenGL.
+# 0 (default): Off, 1: On
+async_shader_compilation =
+
+# What draws use while their shaders are being compiled in the background
+# 0 (default): A slower generic fragment shader and the software vertex shader, 1: Skip the draw,
+# 2: The previously used fragment shader
+async_shader_fallback =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -236,6 +251,12 @@ preload_textures =
 # 0: Off, 1 (default): On
 async_custom_loading =
 
+# Memory budget in MiB for decoded custom textures when they are not preloaded.
+# Textures usually needed together are decoded ahead of time and the least recently used ones are
+# freed when the budget is exceeded.
+# 0 (default): Unlimited, textures are kept in memory once loaded
+custom_texture_budget =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
@@ -251,12 +272,18 @@ enable_dsp_lle_thread =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether or not to spread HLE DSP source processing across worker threads.
+# The mixed output is identical either way; this only helps when many voices are active.
+# 0 (default): No, 1: Yes
+hle_audio_multithread =
+
 # Output volume.
 # 1.0 (default): 100%, 0.0; mute
 volume =
 
 # Which audio output type to use.
-# 0 (default): Auto-select, 1: No audio output, 2: Cubeb (if available), 3: OpenAL (if available), 4: SDL2 (if available)
+# 0 (default): Auto-select, 1: No audio output, 2: Cubeb (if available), 3: OpenAL (if available), 4: SDL2 (if available),
+# 5: Offline (no device; audio is never stretched or padded and does not pace emulation)
 output_type =
 
 # Which audio output device to use.
@@ -333,8 +360,14 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Formats log messages on the logging thread instead of the thread logging them, which makes
+# logging cheaper for the emulation. 0 (default): Off, 1: On
+log_deferred =
+
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
+# Also times the CPU, HLE services, GPU, rasterizer, presentation and audio of every frame, which
+# the --perf-log command line option writes out
 record_frame_times =
 
 # Port for listening to GDB connections.
@@ -0,0 +1,81 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <fmt/format.h>
+#include "audio_core/offline_sink.h"
+#include "citra/emu_window/emu_window_headless.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "video_core/video_core.h"
+
+class HeadlessContext : public Frontend::GraphicsContext {};
+
+EmuWindow_Headless::EmuWindow_Headless(u64 frame_limit_, const std::string& hash_path)
+    : EmuWindow_SDL2{false}, frame_limit{frame_limit_} {
+    if (!hash_path.empty()) {
+        hash_file = FileUtil::IOFile(hash_path, "w");
+        if (!hash_file.IsOpen()) {
+            LOG_CRITICAL(Frontend, "Failed to open hash output file {}", hash_path);
+            exit(1);
+        }
+        hash_file.WriteString("frame,top,bottom,audio\n");
+    }
+    start_time = std::chrono::steady_clock::now();
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() = default;
+
+std::unique_ptr<Frontend::GraphicsContext> EmuWindow_Headless::CreateSharedContext() const {
+    return std::make_unique<HeadlessContext>();
+}
+
+void EmuWindow_Headless::AttachAudio(AudioCore::OfflineSink& sink) {
+    sink.SetFrameConsumer([this](const s16* samples, std::size_t num_frames) {
+        std::scoped_lock lock{audio_mutex};
+        audio_samples.insert(audio_samples.end(), samples, samples + num_frames * 2);
+    });
+}
+
+std::chrono::duration<double> EmuWindow_Headless::GetElapsedTime() const {
+    return std::chrono::steady_clock::now() - start_time;
+}
+
+void EmuWindow_Headless::PollEvents() {
+    if (!is_open) {
+        return;
+    }
+
+    if (hash_file.IsOpen()) {
+        u64 audio_hash;
+        {
+            std::scoped_lock lock{audio_mutex};
+            audio_hash = Common::ComputeHash64(audio_samples.data(),
+                                               audio_samples.size() * sizeof(s16));
+            audio_samples.clear();
+        }
+        hash_file.WriteString(fmt::format("{},{:016x},{:016x},{:016x}\n", frame_count,
+                                          HashFramebuffer(0), HashFramebuffer(1), audio_hash));
+    }
+
+    frame_count++;
+    if (frame_limit != 0 && frame_count >= frame_limit) {
+        RequestClose();
+    }
+}
+
+u64 EmuWindow_Headless::HashFramebuffer(int fb_id) const {
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
+    const PAddr framebuffer_addr =
+        framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const u32 size = framebuffer.stride * framebuffer.height;
+
+    Memory::RasterizerFlushRegion(framebuffer_addr, size);
+    const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
+    if (!framebuffer_data) {
+        return 0;
+    }
+    return Common::ComputeHash64(framebuffer_data, size);
+}
@@ -0,0 +1,62 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "citra/emu_window/emu_window_sdl2.h"
+#include "common/file_util.h"
+
+namespace AudioCore {
+class OfflineSink;
+}
+
+/**
+ * Window without any display surface, used to run emulation on the software renderer on machines
+ * without a GPU or display server. The renderer polls the window once at the end of every emulated
+ * frame; this is used to hash the guest framebuffers and the audio produced during that frame.
+ */
+class EmuWindow_Headless : public EmuWindow_SDL2 {
+public:
+    /**
+     * @param frame_limit Number of frames after which the window requests to close, 0 to run until
+     * closed by other means.
+     * @param hash_path File to write per-frame hashes to as CSV, empty to skip hashing.
+     */
+    explicit EmuWindow_Headless(u64 frame_limit, const std::string& hash_path);
+    ~EmuWindow_Headless();
+
+    void PollEvents() override;
+    std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+
+    /// Collects the audio pushed to the sink so that it can be hashed along with each frame.
+    void AttachAudio(AudioCore::OfflineSink& sink);
+
+    /// Returns the number of frames that have been emulated so far.
+    u64 GetFrameCount() const {
+        return frame_count;
+    }
+
+    /// Returns the wall-clock time elapsed since the first frame.
+    std::chrono::duration<double> GetElapsedTime() const;
+
+private:
+    /// Hashes the active framebuffer of the given screen
+    u64 HashFramebuffer(int fb_id) const;
+
+    u64 frame_limit;
+    u64 frame_count = 0;
+    std::chrono::steady_clock::time_point start_time;
+
+    FileUtil::IOFile hash_file;
+
+    std::mutex audio_mutex;
+    std::vector<s16> audio_samples;
+};
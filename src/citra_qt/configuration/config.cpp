@@ -278,6 +278,7 @@ void Config::ReadAudioValues() {
         ReadBasicSetting(Settings::values.output_device);
         ReadBasicSetting(Settings::values.input_type);
         ReadBasicSetting(Settings::values.input_device);
+        ReadBasicSetting(Settings::values.hle_audio_multithread);
     }
 
     qt_config->endGroup();
@@ -439,6 +440,7 @@ void Config::ReadUtilityValues() {
     ReadGlobalSetting(Settings::values.custom_textures);
     ReadGlobalSetting(Settings::values.preload_textures);
     ReadGlobalSetting(Settings::values.async_custom_loading);
+    ReadGlobalSetting(Settings::values.custom_texture_budget);
 
     qt_config->endGroup();
 }
@@ -527,6 +529,7 @@ void Config::ReadMiscellaneousValues() {
     qt_config->beginGroup(QStringLiteral("Miscellaneous"));
 
     ReadBasicSetting(Settings::values.log_filter);
+    ReadBasicSetting(Settings::values.log_deferred);
 
     qt_config->endGroup();
 }
@@ -630,6 +633,8 @@ void Config::ReadRendererValues() {
     ReadGlobalSetting(Settings::values.use_hw_shader);
     ReadGlobalSetting(Settings::values.shaders_accurate_mul);
     ReadGlobalSetting(Settings::values.use_disk_shader_cache);
+    ReadGlobalSetting(Settings::values.async_shader_compilation);
+    ReadGlobalSetting(Settings::values.async_shader_fallback);
     ReadGlobalSetting(Settings::values.use_vsync_new);
     ReadGlobalSetting(Settings::values.resolution_factor);
     ReadGlobalSetting(Settings::values.frame_limit);
@@ -642,6 +647,7 @@ void Config::ReadRendererValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_shader_jit);
+        ReadBasicSetting(Settings::values.parallel_geometry_shader);
     }
 
     qt_config->endGroup();
@@ -850,6 +856,7 @@ void Config::SaveAudioValues() {
         WriteBasicSetting(Settings::values.output_device);
         WriteBasicSetting(Settings::values.input_type);
         WriteBasicSetting(Settings::values.input_device);
+        WriteBasicSetting(Settings::values.hle_audio_multithread);
     }
 
     qt_config->endGroup();
@@ -951,6 +958,7 @@ void Config::SaveUtilityValues() {
     WriteGlobalSetting(Settings::values.custom_textures);
     WriteGlobalSetting(Settings::values.preload_textures);
     WriteGlobalSetting(Settings::values.async_custom_loading);
+    WriteGlobalSetting(Settings::values.custom_texture_budget);
 
     qt_config->endGroup();
 }
@@ -1034,6 +1042,7 @@ void Config::SaveMiscellaneousValues() {
     qt_config->beginGroup(QStringLiteral("Miscellaneous"));
 
     WriteBasicSetting(Settings::values.log_filter);
+    WriteBasicSetting(Settings::values.log_deferred);
 
     qt_config->endGroup();
 }
@@ -1105,6 +1114,8 @@ void Config::SaveRendererValues() {
     WriteGlobalSetting(Settings::values.use_hw_shader);
     WriteGlobalSetting(Settings::values.shaders_accurate_mul);
     WriteGlobalSetting(Settings::values.use_disk_shader_cache);
+    WriteGlobalSetting(Settings::values.async_shader_compilation);
+    WriteGlobalSetting(Settings::values.async_shader_fallback);
     WriteGlobalSetting(Settings::values.use_vsync_new);
     WriteGlobalSetting(Settings::values.resolution_factor);
     WriteGlobalSetting(Settings::values.frame_limit);
@@ -1118,6 +1129,7 @@ void Config::SaveRendererValues() {
     if (global) {
         WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit.GetValue(),
                      true);
+        WriteBasicSetting(Settings::values.parallel_geometry_shader);
     }
 
     qt_config->endGroup();
@@ -0,0 +1,75 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <utility>
+
+namespace Common {
+
+/**
+ * Thread-safe queue holding at most a fixed number of elements, used to hand work between the
+ * stages of a pipeline so that a fast producer can't run ahead of a slow consumer. Closing the
+ * queue wakes up every waiter, producers stop being able to push and consumers drain what is left.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity_) : capacity{capacity_} {}
+
+    /// Pushes an element, blocking while the queue is full. Returns false if the queue is closed.
+    bool Push(T&& t) {
+        {
+            std::unique_lock lock{mutex};
+            not_full.wait(lock, [this] { return closed || queue.size() < capacity; });
+            if (closed) {
+                return false;
+            }
+            queue.push(std::move(t));
+        }
+        not_empty.notify_one();
+        return true;
+    }
+
+    /// Pops an element, blocking while the queue is empty. Returns nothing once the queue has been
+    /// closed and drained.
+    [[nodiscard]] std::optional<T> PopWait() {
+        std::optional<T> t;
+        {
+            std::unique_lock lock{mutex};
+            not_empty.wait(lock, [this] { return closed || !queue.empty(); });
+            if (queue.empty()) {
+                return std::nullopt;
+            }
+            t.emplace(std::move(queue.front()));
+            queue.pop();
+        }
+        not_full.notify_one();
+        return t;
+    }
+
+    void Close() {
+        {
+            std::scoped_lock lock{mutex};
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    std::queue<T> queue;
+    std::size_t capacity;
+    bool closed{false};
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+} // namespace Common
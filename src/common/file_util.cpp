@@ -51,6 +51,7 @@
 #include <dirent.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -1183,6 +1184,86 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() = default;
+
+MappedFile::MappedFile(const std::string& filename) {
+    IOFile file{filename, "rb"};
+    if (!file.IsOpen()) {
+        return;
+    }
+    is_open = true;
+    const u64 size = file.GetSize();
+    if (size == 0) {
+        return;
+    }
+
+#ifdef _WIN32
+    const auto file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.GetFd()));
+    mapping = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        if (void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) {
+            data = {static_cast<const u8*>(view), static_cast<std::size_t>(size)};
+            return;
+        }
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+#else
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.GetFd(), 0);
+    if (view != MAP_FAILED) {
+        data = {static_cast<const u8*>(view), static_cast<std::size_t>(size)};
+        return;
+    }
+#endif
+
+    LOG_WARNING(Common_Filesystem, "Unable to map {}, reading it instead", filename);
+    buffer.resize(size);
+    if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
+        LOG_ERROR(Common_Filesystem, "Failed to read {}", filename);
+        buffer.clear();
+        is_open = false;
+        return;
+    }
+    data = buffer;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) noexcept {
+    std::swap(data, other.data);
+    std::swap(buffer, other.buffer);
+    std::swap(is_open, other.is_open);
+#ifdef _WIN32
+    std::swap(mapping, other.mapping);
+#endif
+}
+
+void MappedFile::Close() {
+    if (buffer.empty() && !data.empty()) {
+#ifdef _WIN32
+        UnmapViewOfFile(data.data());
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(const_cast<u8*>(data.data()), data.size());
+#endif
+    }
+    data = {};
+    buffer.clear();
+    is_open = false;
+}
+
 template <typename T>
 using boost_iostreams = boost::iostreams::stream<T>;
 
@@ -10,6 +10,7 @@
 #include <ios>
 #include <limits>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -393,6 +394,40 @@ private:
     friend class boost::serialization::access;
 };
 
+/**
+ * Read-only view of a whole file mapped into memory. Pages are only read from disk once they are
+ * accessed, which makes opening large files cheap. Files that can not be mapped are read instead.
+ */
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    void Swap(MappedFile& other) noexcept;
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const {
+        return is_open;
+    }
+
+    [[nodiscard]] std::span<const u8> Data() const {
+        return data;
+    }
+
+private:
+    std::span<const u8> data;
+    std::vector<u8> buffer; ///< Contents of the file when it could not be mapped
+    bool is_open = false;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
 template <std::ios_base::openmode o, typename T>
 void OpenFStream(T& fstream, const std::string& filename);
 } // namespace FileUtil
@@ -3,8 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -15,6 +18,7 @@
 #else
 #define _SH_DENYWR 0
 #endif
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/logging/backend.h"
 #include "common/logging/log.h"
@@ -28,6 +32,105 @@ Filter filter;
 void SetGlobalFilter(const Filter& f) {
     filter = f;
 }
+
+std::atomic<bool> deferred_formatting{false};
+void SetDeferredFormatting(bool enabled) {
+    deferred_formatting.store(enabled, std::memory_order_relaxed);
+}
+
+namespace {
+
+/// Header of a deferred message, followed by its encoded arguments.
+struct DeferredHeader {
+    u32 size; ///< Size of the whole record, including this header and alignment padding
+    u32 line_num;
+    Class log_class;
+    Level log_level;
+    const char* filename;
+    const char* function;
+    const char* format;
+    Deferred::Formatter formatter; ///< Null for records that only skip to the start of the ring
+    std::chrono::steady_clock::time_point time;
+};
+
+/**
+ * Single producer, single consumer ring of deferred messages. Each thread logging with deferred
+ * formatting owns one, which is drained by the logging thread. Records are contiguous, when one
+ * does not fit at the end of the ring the remaining space is skipped.
+ */
+class DeferredRing {
+public:
+    static constexpr std::size_t CAPACITY = 64 * 1024;
+
+    u8* Reserve(std::size_t args_size) {
+        const std::size_t size =
+            Common::AlignUp(sizeof(DeferredHeader) + args_size, alignof(DeferredHeader));
+        const std::size_t write = write_pos.load(std::memory_order_relaxed);
+        const std::size_t offset = write % CAPACITY;
+        const std::size_t skip = offset + size > CAPACITY ? CAPACITY - offset : 0;
+        if (write + skip + size - read_pos.load(std::memory_order_acquire) > CAPACITY) {
+            return nullptr;
+        }
+        if (skip >= sizeof(DeferredHeader)) {
+            // Ends shorter than a header are skipped implicitly by the consumer.
+            DeferredHeader padding{};
+            padding.size = static_cast<u32>(skip);
+            std::memcpy(&buffer[offset], &padding, sizeof(padding));
+        }
+        pending_pos = write + skip;
+        pending_size = size;
+        return &buffer[pending_pos % CAPACITY] + sizeof(DeferredHeader);
+    }
+
+    void Commit(DeferredHeader header) {
+        header.size = static_cast<u32>(pending_size);
+        std::memcpy(&buffer[pending_pos % CAPACITY], &header, sizeof(header));
+        write_pos.store(pending_pos + pending_size, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool Empty() const {
+        return read_pos.load(std::memory_order_relaxed) ==
+               write_pos.load(std::memory_order_acquire);
+    }
+
+    /// Calls func with the header and encoded arguments of every queued message.
+    template <typename Func>
+    void Drain(Func&& func) {
+        std::size_t read = read_pos.load(std::memory_order_relaxed);
+        const std::size_t write = write_pos.load(std::memory_order_acquire);
+        while (read != write) {
+            const std::size_t offset = read % CAPACITY;
+            if (CAPACITY - offset < sizeof(DeferredHeader)) {
+                read += CAPACITY - offset;
+                continue;
+            }
+            DeferredHeader header;
+            std::memcpy(&header, &buffer[offset], sizeof(header));
+            if (header.formatter) {
+                func(header, &buffer[offset + sizeof(DeferredHeader)]);
+            }
+            read += header.size;
+        }
+        read_pos.store(read, std::memory_order_release);
+    }
+
+private:
+    alignas(DeferredHeader) std::array<u8, CAPACITY> buffer;
+    std::atomic<std::size_t> write_pos{0};
+    std::atomic<std::size_t> read_pos{0};
+    // Only accessed by the producer.
+    std::size_t pending_pos = 0;
+    std::size_t pending_size = 0;
+};
+
+/// A log entry along with the precise time it was logged, used to order the messages of threads.
+struct TimedEntry {
+    std::chrono::steady_clock::time_point time;
+    Entry entry;
+};
+
+} // Anonymous namespace
+
 /**
  * Static state as a singleton.
  */
@@ -43,8 +146,27 @@ public:
 
     void PushEntry(Class log_class, Level log_level, const char* filename, unsigned int line_num,
                    const char* function, std::string message) {
-        message_queue.Push(
-            CreateEntry(log_class, log_level, filename, line_num, function, std::move(message)));
+        message_queue.Push(CreateEntry(log_class, log_level, filename, line_num, function,
+                                       std::move(message), std::chrono::steady_clock::now()));
+        WakeBackendThread();
+    }
+
+    /// Registers a deferred message ring for the calling thread.
+    std::shared_ptr<DeferredRing> CreateDeferredRing() {
+        std::scoped_lock lock{rings_mutex};
+        return rings.emplace_back(std::make_shared<DeferredRing>());
+    }
+
+    /// Called after a message was queued, wakes the backend thread if it is waiting for messages.
+    void WakeBackendThread() {
+        // Pairs with the fence in WaitForEntries so that either the backend thread sees the new
+        // message before going idle, or this sees it idle and wakes it up.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (backend_idle.load(std::memory_order_relaxed)) {
+            std::scoped_lock lock{wait_mutex};
+            backend_idle.store(false, std::memory_order_relaxed);
+            wait_cv.notify_one();
+        }
     }
 
     void AddBackend(std::unique_ptr<Backend> backend) {
@@ -72,46 +194,134 @@ public:
 private:
     Impl() {
         backend_thread = std::thread([&] {
-            Entry entry;
-            auto write_logs = [&](Entry& e) {
-                std::lock_guard lock{writing_mutex};
-                for (const auto& backend : backends) {
-                    backend->Write(e);
+            std::vector<TimedEntry> entries;
+            bool stop = false;
+            while (!stop) {
+                // Messages are timestamped just before they are queued, so the ones older than the
+                // collection are usually already queued and can be sorted. A thread preempted in
+                // between queues its message after newer ones were written, so the order of
+                // messages from different threads is only best effort.
+                const auto cutoff = std::chrono::steady_clock::now();
+                stop = CollectEntries(entries);
+                if (entries.empty() && !stop) {
+                    WaitForEntries();
+                    continue;
                 }
-            };
-            while (true) {
-                entry = message_queue.PopWait();
-                if (entry.final_entry) {
-                    break;
-                }
-                write_logs(entry);
+                WriteEntries(entries, cutoff, entries.size());
             }
 
             // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
             // where a system is repeatedly spamming logs even on close.
-            constexpr int MAX_LOGS_TO_WRITE = 100;
-            int logs_written = 0;
-            while (logs_written++ < MAX_LOGS_TO_WRITE && message_queue.Pop(entry)) {
-                write_logs(entry);
-            }
+            constexpr std::size_t MAX_LOGS_TO_WRITE = 100;
+            CollectEntries(entries);
+            WriteEntries(entries, std::chrono::steady_clock::time_point::max(), MAX_LOGS_TO_WRITE);
         });
     }
 
     ~Impl() {
-        Entry entry;
-        entry.final_entry = true;
-        message_queue.Push(entry);
+        TimedEntry entry;
+        entry.entry.final_entry = true;
+        message_queue.Push(std::move(entry));
+        WakeBackendThread();
         backend_thread.join();
     }
 
-    Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
-                      const char* function, std::string message) const {
+    /**
+     * Moves the queued messages and the deferred messages of all threads into entries, formatting
+     * the latter. Returns true once the final entry was reached.
+     */
+    bool CollectEntries(std::vector<TimedEntry>& entries) {
+        bool stop = false;
+        TimedEntry entry;
+        while (message_queue.Pop(entry)) {
+            if (entry.entry.final_entry) {
+                stop = true;
+                break;
+            }
+            entries.push_back(std::move(entry));
+        }
+
+        std::scoped_lock lock{rings_mutex};
+        for (const auto& ring : rings) {
+            ring->Drain([&](const DeferredHeader& header, const u8* args) {
+                entries.push_back(CreateEntry(header.log_class, header.log_level, header.filename,
+                                              header.line_num, header.function,
+                                              FormatDeferred(header, args), header.time));
+            });
+        }
+        // Rings are only referenced here once their thread has exited.
+        std::erase_if(rings,
+                      [](const auto& ring) { return ring.use_count() == 1 && ring->Empty(); });
+        return stop;
+    }
+
+    /**
+     * Writes up to max_entries entries logged before cutoff in the order they were logged, and
+     * removes them from entries.
+     */
+    void WriteEntries(std::vector<TimedEntry>& entries,
+                      std::chrono::steady_clock::time_point cutoff, std::size_t max_entries) {
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const TimedEntry& a, const TimedEntry& b) { return a.time < b.time; });
+        const auto complete =
+            std::partition_point(entries.begin(), entries.end(),
+                                 [cutoff](const TimedEntry& e) { return e.time < cutoff; });
+        const auto end =
+            entries.begin() + std::min(static_cast<std::size_t>(complete - entries.begin()),
+                                       max_entries);
+        {
+            std::lock_guard lock{writing_mutex};
+            for (auto it = entries.begin(); it != end; ++it) {
+                for (const auto& backend : backends) {
+                    backend->Write(it->entry);
+                }
+            }
+        }
+        entries.erase(entries.begin(), end);
+    }
+
+    void WaitForEntries() {
+        // Deferred messages wake the backend thread only when it is idle, the timeout bounds the
+        // latency should a wake up still be missed.
+        constexpr auto MAX_IDLE_TIME = std::chrono::milliseconds{100};
+        std::unique_lock lock{wait_mutex};
+        backend_idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (HasPendingEntries()) {
+            backend_idle.store(false, std::memory_order_relaxed);
+            return;
+        }
+        wait_cv.wait_for(lock, MAX_IDLE_TIME,
+                         [this] { return !backend_idle.load(std::memory_order_relaxed); });
+        backend_idle.store(false, std::memory_order_relaxed);
+    }
+
+    bool HasPendingEntries() {
+        if (!message_queue.Empty()) {
+            return true;
+        }
+        std::scoped_lock lock{rings_mutex};
+        return std::any_of(rings.begin(), rings.end(),
+                           [](const auto& ring) { return !ring->Empty(); });
+    }
+
+    static std::string FormatDeferred(const DeferredHeader& header, const u8* args) {
+        // Format errors would throw at the call site when formatting immediately, but must not
+        // take down the logging thread.
+        try {
+            return header.formatter(header.format, args);
+        } catch (const fmt::format_error& e) {
+            return fmt::format("Failed to format \"{}\": {}", header.format, e.what());
+        }
+    }
+
+    TimedEntry CreateEntry(Class log_class, Level log_level, const char* filename,
+                           unsigned int line_nr, const char* function, std::string message,
+                           std::chrono::steady_clock::time_point time) const {
         using std::chrono::duration_cast;
-        using std::chrono::steady_clock;
 
         Entry entry;
-        entry.timestamp =
-            duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+        entry.timestamp = duration_cast<std::chrono::microseconds>(time - time_origin);
         entry.log_class = log_class;
         entry.log_level = log_level;
         entry.filename = filename;
@@ -119,13 +329,18 @@ private:
         entry.function = function;
         entry.message = std::move(message);
 
-        return entry;
+        return {time, std::move(entry)};
     }
 
     std::mutex writing_mutex;
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
-    Common::MPSCQueue<Log::Entry> message_queue;
+    Common::MPSCQueue<TimedEntry> message_queue;
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<DeferredRing>> rings;
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic<bool> backend_idle{false};
     Filter filter;
     std::chrono::steady_clock::time_point time_origin{std::chrono::steady_clock::now()};
 };
@@ -223,6 +438,7 @@ void DebuggerBackend::Write(const Entry& entry) {
     SUB(Service, SOC)                                                                              \
     SUB(Service, IR)                                                                               \
     SUB(Service, Y2R)                                                                              \
+    SUB(Service, MVD)                                                                              \
     SUB(Service, PS)                                                                               \
     SUB(Service, PLGLDR)                                                                           \
     CLS(HW)                                                                                        \
@@ -302,4 +518,29 @@ void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
     instance.PushEntry(log_class, log_level, filename, line_num, function,
                        fmt::vformat(format, args));
 }
+
+static DeferredRing& GetDeferredRing() {
+    thread_local const std::shared_ptr<DeferredRing> ring = Impl::Instance().CreateDeferredRing();
+    return *ring;
+}
+
+u8* ReserveDeferredMessage(std::size_t args_size) {
+    return GetDeferredRing().Reserve(args_size);
+}
+
+void CommitDeferredMessage(Class log_class, Level log_level, const char* filename,
+                           unsigned int line_num, const char* function, const char* format,
+                           Deferred::Formatter formatter) {
+    DeferredHeader header{};
+    header.line_num = line_num;
+    header.log_class = log_class;
+    header.log_level = log_level;
+    header.filename = filename;
+    header.function = function;
+    header.format = format;
+    header.formatter = formatter;
+    header.time = std::chrono::steady_clock::now();
+    GetDeferredRing().Commit(header);
+    Impl::Instance().WakeBackendThread();
+}
 } // namespace Log
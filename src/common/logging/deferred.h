@@ -0,0 +1,125 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <fmt/format.h>
+#include "common/common_types.h"
+
+/**
+ * Support for deferred formatting: instead of formatting a message at the call site, the format
+ * string pointer and a binary copy of the arguments are queued, and the logging thread formats
+ * them later. This only works for arguments that can be copied without running any code, messages
+ * with other arguments are formatted at the call site as usual.
+ */
+namespace Log::Deferred {
+
+/// Formats a deferred message from its format string and encoded arguments.
+using Formatter = std::string (*)(const char* format, const u8* args);
+
+/// Describes how a log argument is copied into a deferred message and read back.
+template <typename T>
+struct ArgCodec {
+    static constexpr bool supported = false;
+};
+
+template <typename T>
+concept TriviallyDeferrable =
+    std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+    (std::is_pointer_v<T> && !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>);
+
+template <TriviallyDeferrable T>
+struct ArgCodec<T> {
+    static constexpr bool supported = true;
+
+    static std::size_t Size(const T&) {
+        return sizeof(T);
+    }
+    static void Encode(u8*& dst, const T& value) {
+        std::memcpy(dst, &value, sizeof(T));
+        dst += sizeof(T);
+    }
+    static T Decode(const u8*& src) {
+        T value;
+        std::memcpy(&value, src, sizeof(T));
+        src += sizeof(T);
+        return value;
+    }
+};
+
+/// Strings are copied along with their length, and read back as views into the message.
+struct StringCodec {
+    static constexpr bool supported = true;
+
+    static std::string_view View(std::string_view value) {
+        return value;
+    }
+    static std::string_view View(const char* value) {
+        return value ? std::string_view{value} : std::string_view{};
+    }
+
+    template <typename T>
+    static std::size_t Size(const T& value) {
+        return sizeof(u32) + View(value).size();
+    }
+    template <typename T>
+    static void Encode(u8*& dst, const T& value) {
+        const std::string_view view = View(value);
+        const auto size = static_cast<u32>(view.size());
+        std::memcpy(dst, &size, sizeof(size));
+        std::memcpy(dst + sizeof(size), view.data(), size);
+        dst += sizeof(size) + size;
+    }
+    static std::string_view Decode(const u8*& src) {
+        u32 size;
+        std::memcpy(&size, src, sizeof(size));
+        const std::string_view value{reinterpret_cast<const char*>(src + sizeof(size)), size};
+        src += sizeof(size) + size;
+        return value;
+    }
+};
+
+template <>
+struct ArgCodec<std::string> : StringCodec {};
+template <>
+struct ArgCodec<std::string_view> : StringCodec {};
+template <>
+struct ArgCodec<const char*> : StringCodec {};
+template <>
+struct ArgCodec<char*> : StringCodec {};
+template <std::size_t N>
+struct ArgCodec<char[N]> : StringCodec {};
+
+template <typename... Args>
+constexpr bool IsDeferrable = (ArgCodec<Args>::supported && ...);
+
+template <typename... Args>
+std::size_t ArgsSize(const Args&... args) {
+    return (std::size_t{0} + ... + ArgCodec<Args>::Size(args));
+}
+
+template <typename... Args>
+void EncodeArgs([[maybe_unused]] u8* dst, const Args&... args) {
+    (ArgCodec<Args>::Encode(dst, args), ...);
+}
+
+template <typename... Args>
+std::string Format(const char* format, [[maybe_unused]] const u8* args) {
+    // Braced initialization decodes the arguments from left to right.
+    const std::tuple<decltype(ArgCodec<Args>::Decode(args))...> values{
+        ArgCodec<Args>::Decode(args)...};
+    return std::apply(
+        [format](const auto&... decoded) {
+            return fmt::vformat(format, fmt::make_format_args(decoded...));
+        },
+        values);
+}
+
+} // namespace Log::Deferred
@@ -6,7 +6,9 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include "common/common_types.h"
+#include "common/logging/deferred.h"
 #include "common/logging/formatter.h"
 
 namespace Log {
@@ -93,6 +95,7 @@ enum class Class : ClassType {
     Service_SOC,       ///< The SOC (Socket) service
     Service_IR,        ///< The IR service
     Service_Y2R,       ///< The Y2R (YUV to RGB conversion) service
+    Service_MVD,       ///< The MVD (Video decoder) service
     Service_PS,        ///< The PS (Process) service
     Service_PLGLDR,    ///< The PLGLDR (plugin loader) service
     HW,                ///< Low-level hardware emulation
@@ -149,7 +152,10 @@ public:
     void ParseFilterString(std::string_view filter_view);
 
     /// Matches class/level combination against the filter, returning true if it passed.
-    bool CheckMessage(Class log_class, Level level) const;
+    bool CheckMessage(Class log_class, Level level) const {
+        return static_cast<u8>(level) >=
+               static_cast<u8>(class_levels[static_cast<std::size_t>(log_class)]);
+    }
 
 private:
     std::array<Level, static_cast<std::size_t>(Class::Count)> class_levels;
@@ -158,6 +164,28 @@ extern Filter filter;
 
 void SetGlobalFilter(const Filter& f);
 
+/// Whether messages are formatted on the logging thread, see SetDeferredFormatting.
+extern std::atomic<bool> deferred_formatting;
+
+/**
+ * Enables or disables deferred formatting. When enabled, messages whose arguments can be copied
+ * as plain data are queued in binary form to a lock-free ring owned by the calling thread, and
+ * formatted on the logging thread. The format string must then outlive the message, which is the
+ * case for the string literals used by the LOG_* macros.
+ */
+void SetDeferredFormatting(bool enabled);
+
+/**
+ * Reserves space for the encoded arguments of a deferred message in the ring of the calling
+ * thread. Returns nullptr if the ring is full, the message has to be formatted right away then.
+ */
+u8* ReserveDeferredMessage(std::size_t args_size);
+
+/// Queues the deferred message whose arguments were written to the last reserved space.
+void CommitDeferredMessage(Class log_class, Level log_level, const char* filename,
+                           unsigned int line_num, const char* function, const char* format,
+                           Deferred::Formatter formatter);
+
 /// Logs a message to the global logger, using fmt
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
@@ -169,6 +197,17 @@ void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsig
     if (!filter.CheckMessage(log_class, log_level))
         return;
 
+    if constexpr (Deferred::IsDeferrable<Args...>) {
+        if (deferred_formatting.load(std::memory_order_relaxed)) {
+            if (u8* data = ReserveDeferredMessage(Deferred::ArgsSize(args...))) {
+                Deferred::EncodeArgs(data, args...);
+                CommitDeferredMessage(log_class, log_level, filename, line_num, function, format,
+                                      &Deferred::Format<Args...>);
+                return;
+            }
+        }
+    }
+
     FmtLogMessageImpl(log_class, log_level, filename, line_num, function, format,
                       fmt::make_format_args(args...));
 }
@@ -0,0 +1,72 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/perf_sections.h"
+
+namespace Common {
+
+namespace detail {
+std::atomic_bool g_perf_sections_enabled{false};
+}
+
+namespace {
+
+std::array<std::atomic<s64>, NumPerfSections> g_section_ns{};
+
+/// Innermost active section of the calling thread
+thread_local ScopedPerfSection* g_current_section = nullptr;
+
+} // Anonymous namespace
+
+std::string_view GetPerfSectionName(PerfSection section) {
+    switch (section) {
+    case PerfSection::CPU:
+        return "cpu";
+    case PerfSection::Services:
+        return "services";
+    case PerfSection::GPU:
+        return "gpu";
+    case PerfSection::Rasterizer:
+        return "rasterizer";
+    case PerfSection::Present:
+        return "present";
+    case PerfSection::Audio:
+        return "audio";
+    case PerfSection::Idle:
+        return "idle";
+    default:
+        return "unknown";
+    }
+}
+
+void SetPerfSectionsEnabled(bool enabled) {
+    detail::g_perf_sections_enabled = enabled;
+}
+
+PerfSectionTimes TakePerfSectionTimes() {
+    PerfSectionTimes times;
+    for (std::size_t i = 0; i < NumPerfSections; i++) {
+        times[i] = std::chrono::nanoseconds{g_section_ns[i].exchange(0, std::memory_order_relaxed)};
+    }
+    return times;
+}
+
+void ScopedPerfSection::Begin() {
+    active = true;
+    parent = g_current_section;
+    g_current_section = this;
+    start = std::chrono::steady_clock::now();
+}
+
+void ScopedPerfSection::End() {
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    g_section_ns[static_cast<std::size_t>(section)].fetch_add((elapsed - nested).count(),
+                                                              std::memory_order_relaxed);
+    if (parent) {
+        parent->nested += elapsed;
+    }
+    g_current_section = parent;
+}
+
+} // namespace Common
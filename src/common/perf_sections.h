@@ -0,0 +1,77 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Subsystems the host time of an emulated frame is broken down into.
+enum class PerfSection : u32 {
+    CPU,        ///< Guest code running on the ARM11 cores
+    Services,   ///< HLE service requests
+    GPU,        ///< PICA command list processing
+    Rasterizer, ///< Draws submitted to the rasterizer
+    Present,    ///< Presenting the screens
+    Audio,      ///< HLE DSP audio frames
+    Idle,       ///< Frame limiting
+    Count,
+};
+
+constexpr std::size_t NumPerfSections = static_cast<std::size_t>(PerfSection::Count);
+
+using PerfSectionTimes = std::array<std::chrono::nanoseconds, NumPerfSections>;
+
+[[nodiscard]] std::string_view GetPerfSectionName(PerfSection section);
+
+/// Enables or disables timing of perf sections. It is off by default, as reading the clock around
+/// every service request isn't free.
+void SetPerfSectionsEnabled(bool enabled);
+
+/// Returns the host time spent in each section since the previous call and resets it.
+PerfSectionTimes TakePerfSectionTimes();
+
+namespace detail {
+extern std::atomic_bool g_perf_sections_enabled;
+}
+
+/**
+ * Adds the host time spent in its scope to a perf section. Sections nest per thread, the time of
+ * an inner section, like a service request made by guest code, only counts towards the inner one.
+ */
+class ScopedPerfSection {
+public:
+    explicit ScopedPerfSection(PerfSection section_) : section{section_} {
+        if (detail::g_perf_sections_enabled.load(std::memory_order_relaxed)) {
+            Begin();
+        }
+    }
+
+    ~ScopedPerfSection() {
+        if (active) {
+            End();
+        }
+    }
+
+    ScopedPerfSection(const ScopedPerfSection&) = delete;
+    ScopedPerfSection& operator=(const ScopedPerfSection&) = delete;
+
+private:
+    void Begin();
+    void End();
+
+    PerfSection section;
+    bool active{false};
+    std::chrono::steady_clock::time_point start;
+    std::chrono::nanoseconds nested{};
+    ScopedPerfSection* parent{nullptr};
+};
+
+} // namespace Common
@@ -80,6 +80,7 @@ void Apply() {
     GDBStub::ToggleServer(values.use_gdbstub.GetValue());
 
     VideoCore::g_shader_jit_enabled = values.use_shader_jit.GetValue();
+    VideoCore::g_parallel_geometry_shader = values.parallel_geometry_shader.GetValue();
     VideoCore::g_hw_shader_enabled = values.use_hw_shader.GetValue();
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul.GetValue();
 
@@ -147,6 +148,7 @@ void LogSettings() {
     log_setting("Renderer_UseHwShader", values.use_hw_shader.GetValue());
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul.GetValue());
     log_setting("Renderer_UseShaderJit", values.use_shader_jit.GetValue());
+    log_setting("Renderer_ParallelGeometryShader", values.parallel_geometry_shader.GetValue());
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor.GetValue());
     log_setting("Renderer_FrameLimit", values.frame_limit.GetValue());
     log_setting("Renderer_VSyncNew", values.use_vsync_new.GetValue());
@@ -167,13 +169,17 @@ void LogSettings() {
     log_setting("Utility_CustomTextures", values.custom_textures.GetValue());
     log_setting("Utility_PreloadTextures", values.preload_textures.GetValue());
     log_setting("Utility_AsyncCustomLoading", values.async_custom_loading.GetValue());
+    log_setting("Utility_CustomTextureBudget", values.custom_texture_budget.GetValue());
     log_setting("Utility_UseDiskShaderCache", values.use_disk_shader_cache.GetValue());
+    log_setting("Renderer_AsyncShaderCompilation", values.async_shader_compilation.GetValue());
+    log_setting("Renderer_AsyncShaderFallback", values.async_shader_fallback.GetValue());
     log_setting("Audio_Emulation", GetAudioEmulationName(values.audio_emulation.GetValue()));
     log_setting("Audio_OutputType", values.output_type.GetValue());
     log_setting("Audio_OutputDevice", values.output_device.GetValue());
     log_setting("Audio_InputType", values.input_type.GetValue());
     log_setting("Audio_InputDevice", values.input_device.GetValue());
     log_setting("Audio_EnableAudioStretching", values.enable_audio_stretching.GetValue());
+    log_setting("Audio_HLEMultithread", values.hle_audio_multithread.GetValue());
     using namespace Service::CAM;
     log_setting("Camera_OuterRightName", values.camera_name[OuterRightCamera]);
     log_setting("Camera_OuterRightConfig", values.camera_config[OuterRightCamera]);
@@ -232,6 +238,8 @@ void RestoreGlobalState(bool is_powered_on) {
     values.graphics_api.SetGlobal(true);
     values.use_hw_shader.SetGlobal(true);
     values.use_disk_shader_cache.SetGlobal(true);
+    values.async_shader_compilation.SetGlobal(true);
+    values.async_shader_fallback.SetGlobal(true);
     values.shaders_accurate_mul.SetGlobal(true);
     values.use_vsync_new.SetGlobal(true);
     values.resolution_factor.SetGlobal(true);
@@ -252,6 +260,7 @@ void RestoreGlobalState(bool is_powered_on) {
     values.dump_textures.SetGlobal(true);
     values.custom_textures.SetGlobal(true);
     values.preload_textures.SetGlobal(true);
+    values.custom_texture_budget.SetGlobal(true);
 }
 
 void LoadProfile(int index) {
@@ -67,6 +67,13 @@ enum class AudioEmulation : u32 {
     LLEMultithreaded = 2,
 };
 
+/// What to draw with while the shaders of a draw are compiled in the background
+enum class AsyncShaderFallback : u32 {
+    Generic = 0,  ///< A generic fragment shader, or the software vertex shader
+    Skip = 1,     ///< Skip the draw
+    Previous = 2, ///< The previously used fragment shader
+};
+
 enum class TextureFilter : u32 {
     None = 0,
     Anime4K = 1,
@@ -435,9 +442,13 @@ struct Values {
     Setting<bool> dump_command_buffers{false, "dump_command_buffers"};
     SwitchableSetting<bool> use_hw_shader{true, "use_hw_shader"};
     SwitchableSetting<bool> use_disk_shader_cache{true, "use_disk_shader_cache"};
+    SwitchableSetting<bool> async_shader_compilation{false, "async_shader_compilation"};
+    SwitchableSetting<AsyncShaderFallback> async_shader_fallback{AsyncShaderFallback::Generic,
+                                                                 "async_shader_fallback"};
     SwitchableSetting<bool> shaders_accurate_mul{true, "shaders_accurate_mul"};
     SwitchableSetting<bool> use_vsync_new{true, "use_vsync_new"};
     Setting<bool> use_shader_jit{true, "use_shader_jit"};
+    Setting<bool> parallel_geometry_shader{false, "parallel_geometry_shader"};
     SwitchableSetting<u32, true> resolution_factor{1, 0, 10, "resolution_factor"};
     SwitchableSetting<u16, true> frame_limit{100, 0, 1000, "frame_limit"};
     SwitchableSetting<TextureFilter> texture_filter{TextureFilter::None, "texture_filter"};
@@ -479,11 +490,13 @@ struct Values {
     SwitchableSetting<bool> custom_textures{false, "custom_textures"};
     SwitchableSetting<bool> preload_textures{false, "preload_textures"};
     SwitchableSetting<bool> async_custom_loading{true, "async_custom_loading"};
+    SwitchableSetting<u32> custom_texture_budget{0, "custom_texture_budget"};
 
     // Audio
     bool audio_muted;
     SwitchableSetting<AudioEmulation> audio_emulation{AudioEmulation::HLE, "audio_emulation"};
     SwitchableSetting<bool> enable_audio_stretching{true, "enable_audio_stretching"};
+    Setting<bool> hle_audio_multithread{false, "hle_audio_multithread"};
     SwitchableSetting<float, true> volume{1.f, 0.f, 1.f, "volume"};
     Setting<AudioCore::SinkType> output_type{AudioCore::SinkType::Auto, "output_type"};
     Setting<std::string> output_device{"auto", "output_device"};
@@ -503,6 +516,7 @@ struct Values {
 
     // Miscellaneous
     Setting<std::string> log_filter{"*:Info", "log_filter"};
+    Setting<bool> log_deferred{false, "log_deferred"};
 
     // Video Dumping
     std::string output_format;
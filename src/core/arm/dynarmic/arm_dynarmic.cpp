@@ -190,6 +190,10 @@ void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    if (memory.IsDirtyTrackingEnabled() != jit_tracks_writes) [[unlikely]] {
+        RebuildJits();
+    }
+
     jit->Run();
 }
 
@@ -362,10 +366,27 @@ void ARM_Dynarmic::ServeBreak() {
     GDBStub::SendTrap(thread, 5);
 }
 
+void ARM_Dynarmic::RebuildJits() {
+    auto ctx{NewContext()};
+    SaveContext(ctx);
+
+    jits.clear();
+    jit_tracks_writes = memory.IsDirtyTrackingEnabled();
+
+    auto new_jit = MakeJit();
+    jit = new_jit.get();
+    LoadContext(ctx);
+    jits.emplace(current_page_table, std::move(new_jit));
+}
+
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
-    config.page_table = &current_page_table->GetPointerArray();
+    // Inline page table accesses can't be observed, so route every access through the memory
+    // callbacks while dirty tracking is enabled.
+    if (!jit_tracks_writes) {
+        config.page_table = &current_page_table->GetPointerArray();
+    }
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
 
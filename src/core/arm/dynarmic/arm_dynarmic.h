@@ -65,6 +65,9 @@ protected:
 private:
     void ServeBreak();
 
+    /// Recreates the JITs after the dirty tracking state of the memory system changed
+    void RebuildJits();
+
     friend class DynarmicUserCallbacks;
     Core::System& system;
     Memory::MemorySystem& memory;
@@ -78,4 +81,5 @@ private:
     Dynarmic::A32::Jit* jit = nullptr;
     std::shared_ptr<Memory::PageTable> current_page_table = nullptr;
     std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+    bool jit_tracks_writes = false;
 };
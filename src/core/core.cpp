@@ -11,6 +11,7 @@
 #include "audio_core/lle/lle.h"
 #include "common/arch.h"
 #include "common/logging/log.h"
+#include "common/perf_sections.h"
 #include "common/settings.h"
 #include "common/texture.h"
 #include "core/arm/arm_interface.h"
@@ -31,6 +32,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/mailbox.h"
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/fs/archive.h"
@@ -76,6 +78,8 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         return ResultStatus::ErrorNotInitialized;
     }
 
+    HLE::SetEmuThread();
+
     if (GDBStub::IsServerEnabled()) {
         Kernel::Thread* thread = kernel->GetCurrentThreadManager().GetCurrentThread();
         if (thread && running_core) {
@@ -142,6 +146,9 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         break;
     }
 
+    // Also pick up work from host threads here in case the guest doesn't make any syscalls.
+    HLE::RunPostedWork();
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -180,6 +187,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             current_core_to_execute->GetTimer().Idle();
             PrepareReschedule();
         } else {
+            Common::ScopedPerfSection section{Common::PerfSection::CPU};
             if (tight_loop) {
                 current_core_to_execute->Run();
             } else {
@@ -212,6 +220,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
                 cpu_core->GetTimer().Idle();
                 PrepareReschedule();
             } else {
+                Common::ScopedPerfSection section{Common::PerfSection::CPU};
                 if (tight_loop) {
                     cpu_core->Run();
                 } else {
@@ -398,7 +407,9 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
 
     const auto audio_emulation = Settings::values.audio_emulation.GetValue();
     if (audio_emulation == Settings::AudioEmulation::HLE) {
-        dsp_core = std::make_unique<AudioCore::DspHle>(*memory, *timing);
+        auto dsp_hle = std::make_unique<AudioCore::DspHle>(*memory, *timing);
+        dsp_hle->SetMultithreaded(Settings::values.hle_audio_multithread.GetValue());
+        dsp_core = std::move(dsp_hle);
     } else {
         const bool multithread = audio_emulation == Settings::AudioEmulation::LLEMultithreaded;
         dsp_core = std::make_unique<AudioCore::DspLle>(*memory, *timing, multithread);
@@ -561,6 +572,13 @@ void System::Shutdown(bool is_deserializing) {
 
     memory.reset();
 
+    // Every host thread that could post work was stopped along with the services above.
+    HLE::ClearPostedWork();
+    const auto mailbox_stats = HLE::GetMailboxStats();
+    LOG_DEBUG(Core, "HLE mailbox: {} inline, {} queued in {} batches, max backlog {}",
+              mailbox_stats.ran_inline, mailbox_stats.queued, mailbox_stats.batches,
+              mailbox_stats.max_backlog);
+
     if (self_delete_pending)
         FileUtil::Delete(m_filepath);
     self_delete_pending = false;
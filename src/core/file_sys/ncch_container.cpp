@@ -2,13 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/polyfill_thread.h"
 #include "core/core.h"
 #include "core/file_sys/layered_fs.h"
 #include "core/file_sys/ncch_container.h"
@@ -24,6 +28,7 @@ namespace FileSys {
 
 static const int kMaxSections = 8;   ///< Maximum number of sections (files) in an ExeFs
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
+static const std::size_t kDecryptChunkSize = 0x100000; ///< Size of ExeFS decryption chunks
 
 u64 GetModId(u64 program_id) {
     constexpr u64 UPDATE_MASK = 0x0000000e'00000000;
@@ -33,86 +38,110 @@ u64 GetModId(u64 program_id) {
     return program_id;
 }
 
-/**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
- */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
+u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
     u32 offset_size;
     std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
     return offset_size + size;
 }
 
-/**
- * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
- * @param compressed_size Size of compressed buffer
- * @param decompressed Decompressed buffer
- * @param decompressed_size Size of decompressed buffer
- * @return True on success, otherwise false
- */
-static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
-                            u32 decompressed_size) {
+bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                     u32 decompressed_size) {
+    if (compressed_size < 8 || decompressed_size < compressed_size)
+        return false;
+
     const u8* footer = compressed + compressed_size - 8;
 
     u32 buffer_top_and_bottom;
     std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
 
+    const u32 top = (buffer_top_and_bottom >> 24) & 0xFF;
+    const u32 bottom = buffer_top_and_bottom & 0xFFFFFF;
+    if (top > compressed_size || bottom > compressed_size)
+        return false;
+
     u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+    u32 index = compressed_size - top;
+    const u32 stop_index = compressed_size - bottom;
 
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
+    // The data is decompressed back to front over the compressed data, only the part past it has
+    // to be cleared.
+    std::memcpy(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
 
     while (index > stop_index) {
         u8 control = compressed[--index];
 
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
-
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
+        for (unsigned i = 0; i < 8 && index > stop_index && out > 0; i++, control <<= 1) {
+            if (!(control & 0x80)) {
                 decompressed[--out] = compressed[--index];
+                continue;
+            }
+
+            // Check if compression is out of bounds
+            if (index < 2)
+                return false;
+            index -= 2;
+
+            u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+            const u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+            segment_offset &= 0x0FFF;
+            segment_offset += 2;
+
+            // Check if compression is out of bounds, the first byte copied is the furthest one.
+            if (out < segment_size || out + segment_offset >= decompressed_size)
+                return false;
+
+            // Each byte is copied from segment_offset + 1 bytes above it. Segments closer than
+            // their size repeat bytes they have just written and are copied one byte at a time.
+            out -= segment_size;
+            u8* const dest = decompressed + out;
+            const u8* const source = dest + segment_offset + 1;
+            if (segment_offset + 1 >= segment_size) {
+                std::memcpy(dest, source, segment_size);
+            } else {
+                for (u32 j = segment_size; j-- > 0;) {
+                    dest[j] = source[j];
+                }
             }
-            control <<= 1;
         }
     }
     return true;
 }
 
+/**
+ * Decrypt an ExeFS section with AES-CTR. Large sections are split in chunks decrypted on several
+ * threads, as each chunk can seek the keystream to its own position.
+ * @param key Key of the section
+ * @param ctr Initial counter of the ExeFS
+ * @param offset Offset of the section from the start of the ExeFS
+ * @param data Section data, decrypted in place
+ * @param size Size of the section
+ */
+static void DecryptExeFSSection(const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
+                                u64 offset, u8* data, std::size_t size) {
+    const auto decrypt = [&](std::size_t begin, std::size_t end) {
+        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(), ctr.data());
+        dec.Seek(offset + begin);
+        dec.ProcessData(data + begin, data + begin, end - begin);
+    };
+
+    const std::size_t num_chunks = (size + kDecryptChunkSize - 1) / kDecryptChunkSize;
+    const std::size_t num_threads =
+        std::min<std::size_t>(num_chunks, std::thread::hardware_concurrency());
+    if (num_threads <= 1) {
+        decrypt(0, size);
+        return;
+    }
+
+    const std::size_t thread_size =
+        (num_chunks + num_threads - 1) / num_threads * kDecryptChunkSize;
+    std::vector<std::jthread> threads;
+    for (std::size_t begin = thread_size; begin < size; begin += thread_size) {
+        threads.emplace_back(decrypt, begin, std::min(begin + thread_size, size));
+    }
+    decrypt(0, std::min(thread_size, size));
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset, u32 partition)
     : ncch_offset(ncch_offset), partition(partition), filepath(filepath) {
     file = FileUtil::IOFile(filepath, "rb");
@@ -534,10 +563,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             } else {
                 key = secondary_key;
             }
-
-            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
-                                                              exefs_ctr.data());
-            dec.Seek(section.offset + sizeof(ExeFs_Header));
+            const u64 crypto_offset = section.offset + sizeof(ExeFs_Header);
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
                 // Section is compressed, read compressed .code section...
@@ -552,10 +578,13 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                     return Loader::ResultStatus::Error;
 
                 if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    DecryptExeFSSection(key, exefs_ctr, crypto_offset, &temp_buffer[0],
+                                        section.size);
                 }
 
                 // Decompress .code section...
+                if (section.size < 8)
+                    return Loader::ResultStatus::ErrorInvalidFormat;
                 u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
                 buffer.resize(decompressed_size);
                 if (!LZSS_Decompress(&temp_buffer[0], section.size, buffer.data(),
@@ -567,7 +596,8 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 if (exefs_file.ReadBytes(buffer.data(), section.size) != section.size)
                     return Loader::ResultStatus::Error;
                 if (is_encrypted) {
-                    dec.ProcessData(buffer.data(), buffer.data(), section.size);
+                    DecryptExeFSSection(key, exefs_ctr, crypto_offset, buffer.data(),
+                                        section.size);
                 }
             }
 
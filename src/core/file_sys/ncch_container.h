@@ -228,6 +228,25 @@ static_assert(sizeof(ExHeader_Header) == 0x800, "ExHeader structure size is wron
 
 namespace FileSys {
 
+/**
+ * Get the decompressed size of an LZSS compressed ExeFS file
+ * @param buffer Buffer of compressed file
+ * @param size Size of compressed buffer
+ * @return Size of decompressed buffer
+ */
+u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size);
+
+/**
+ * Decompress ExeFS file (compressed with LZSS)
+ * @param compressed Compressed buffer
+ * @param compressed_size Size of compressed buffer
+ * @param decompressed Decompressed buffer
+ * @param decompressed_size Size of decompressed buffer
+ * @return True on success, otherwise false
+ */
+bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                     u32 decompressed_size);
+
 /**
  * Helper which implements an interface to deal with NCCH containers which can
  * contain ExeFS archives or RomFS archives for games or other applications.
@@ -182,6 +182,10 @@ std::array<u8, 16> TitleMetadata::GetContentCTRByIndex(std::size_t index) const
     return ctr;
 }
 
+std::array<u8, 0x20> TitleMetadata::GetContentHashByIndex(std::size_t index) const {
+    return tmd_chunks[index].hash;
+}
+
 void TitleMetadata::SetTitleID(u64 title_id) {
     tmd_body.title_id = title_id;
 }
@@ -202,6 +202,13 @@ public:
                       std::shared_ptr<Thread> thread);
     ~HLERequestContext();
 
+    /**
+     * Prepares the context to handle another request on the same session. The translated handles
+     * and mapped buffers of the previous request are dropped, but the storage of the static
+     * buffers is kept so it can be reused. Passing null releases the session and thread.
+     */
+    void Reset(std::shared_ptr<ServerSession> session, std::shared_ptr<Thread> thread);
+
     /// Returns a pointer to the IPC command buffer for this request.
     u32* CommandBuffer() {
         return cmd_buf.data();
@@ -90,8 +90,12 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
         kernel.memory.ReadBlock(*current_process, thread->GetCommandBufferAddress(), cmd_buf.data(),
                                 cmd_buf.size() * sizeof(u32));
 
-        auto context =
-            std::make_shared<Kernel::HLERequestContext>(kernel, SharedFrom(this), thread);
+        std::shared_ptr<Kernel::HLERequestContext> context = std::move(cached_context);
+        if (context) {
+            context->Reset(SharedFrom(this), thread);
+        } else {
+            context = std::make_shared<Kernel::HLERequestContext>(kernel, SharedFrom(this), thread);
+        }
         context->PopulateFromIncomingCommandBuffer(cmd_buf.data(), current_process);
 
         hle_handler->HandleSyncRequest(*context);
@@ -106,6 +110,13 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
             kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
                                      cmd_buf.data(), cmd_buf.size() * sizeof(u32));
         }
+
+        // If the handler put the thread to sleep the wakeup callback still holds on to the
+        // context, otherwise keep it around for the next request on this session.
+        if (context.use_count() == 1) {
+            context->Reset(nullptr, nullptr);
+            cached_context = std::move(context);
+        }
     }
 
     if (thread->status == ThreadStatus::Running) {
@@ -20,6 +20,7 @@ namespace Kernel {
 
 class ClientSession;
 class ClientPort;
+class HLERequestContext;
 class ServerSession;
 class Session;
 class SessionRequestHandler;
@@ -106,6 +107,9 @@ private:
     friend class KernelSystem;
     KernelSystem& kernel;
 
+    /// Context of the last HLE request, reused by the next one unless something still holds it.
+    std::shared_ptr<HLERequestContext> cached_context;
+
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version);
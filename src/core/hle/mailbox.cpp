@@ -0,0 +1,68 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "common/threadsafe_queue.h"
+#include "core/hle/mailbox.h"
+
+namespace HLE {
+
+namespace {
+std::atomic<std::thread::id> g_emu_thread{};
+Common::MPSCQueue<std::function<void()>> g_mailbox;
+
+std::atomic<u64> g_ran_inline{0};
+std::atomic<u64> g_queued{0};
+std::atomic<u64> g_batches{0};
+std::atomic<u64> g_max_backlog{0};
+} // Anonymous namespace
+
+void SetEmuThread() {
+    g_emu_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+}
+
+void PostToEmuThread(std::function<void()> work) {
+    if (std::this_thread::get_id() == g_emu_thread.load(std::memory_order_relaxed)) {
+        g_ran_inline.fetch_add(1, std::memory_order_relaxed);
+        work();
+        return;
+    }
+
+    g_queued.fetch_add(1, std::memory_order_relaxed);
+    g_mailbox.Push(std::move(work));
+}
+
+void RunPostedWork() {
+    if (g_mailbox.Empty()) {
+        return;
+    }
+
+    const u64 backlog = g_mailbox.Size();
+    g_batches.fetch_add(1, std::memory_order_relaxed);
+    if (backlog > g_max_backlog.load(std::memory_order_relaxed)) {
+        g_max_backlog.store(backlog, std::memory_order_relaxed);
+    }
+
+    for (std::function<void()> work; g_mailbox.Pop(work);) {
+        work();
+    }
+}
+
+void ClearPostedWork() {
+    for (std::function<void()> work; g_mailbox.Pop(work);) {
+    }
+}
+
+MailboxStats GetMailboxStats() {
+    return {
+        .ran_inline = g_ran_inline.load(std::memory_order_relaxed),
+        .queued = g_queued.load(std::memory_order_relaxed),
+        .batches = g_batches.load(std::memory_order_relaxed),
+        .max_backlog = g_max_backlog.load(std::memory_order_relaxed),
+    };
+}
+
+} // namespace HLE
@@ -0,0 +1,48 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include "common/common_types.h"
+
+namespace HLE {
+
+/**
+ * The HLE kernel and service state is only ever touched by the emulation thread. Host threads
+ * that need to act on it (the LLE DSP thread, network callbacks, the frontend) post their work
+ * here instead of locking, and the emulation thread runs it at its next syscall or slice
+ * boundary. Checking for posted work is a single atomic load, so the syscall path takes no lock.
+ */
+
+/// Marks the calling thread as the emulation thread.
+void SetEmuThread();
+
+/**
+ * Runs the given work on the emulation thread. The work runs immediately if called from the
+ * emulation thread, otherwise it is queued until RunPostedWork is called.
+ */
+void PostToEmuThread(std::function<void()> work);
+
+/// Runs all work posted by host threads. Must be called from the emulation thread.
+void RunPostedWork();
+
+/// Discards any queued work, used on shutdown once no host thread can post anymore.
+void ClearPostedWork();
+
+struct MailboxStats {
+    /// Work posted from the emulation thread itself, which ran without being queued
+    u64 ran_inline;
+    /// Work posted from other host threads
+    u64 queued;
+    /// Number of times queued work was found by RunPostedWork
+    u64 batches;
+    /// Largest number of items found queued at once
+    u64 max_backlog;
+};
+
+/// Returns counters describing how often host threads had to hand work to the emulation thread.
+MailboxStats GetMailboxStats();
+
+} // namespace HLE
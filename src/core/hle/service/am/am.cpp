@@ -3,16 +3,21 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/alignment.h"
+#include "common/bounded_threadsafe_queue.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/polyfill_thread.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ncch_container.h"
@@ -78,9 +83,105 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
+// Content that doesn't match the hash in its TMD is reported as an invalid CIA, the same error
+// returned for CIAs that can't be parsed.
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrCodes::InvalidCIAHeader, ErrorModule::AM,
+                                                 ErrorSummary::InvalidArgument,
+                                                 ErrorLevel::Permanent);
+
 class CIAFile::DecryptionState {
 public:
     std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    std::vector<CryptoPP::SHA256> content_hash;
+};
+
+/**
+ * Writes decrypted content data to the content files on a separate thread, so that the disk keeps
+ * busy while the next piece of the CIA is decrypted and hashed. Data is handed over in a few large
+ * buffers which are recycled once written, which bounds the memory used by an install.
+ */
+class CIAFile::ContentWriter {
+public:
+    static constexpr std::size_t BUFFER_SIZE = 0x400000;
+    static constexpr std::size_t NUM_BUFFERS = 4;
+
+    struct Buffer {
+        std::size_t content_index;
+        std::size_t size;
+        std::vector<u8> data;
+    };
+
+    explicit ContentWriter(std::vector<std::string> paths_)
+        : paths{std::move(paths_)}, free_buffers{NUM_BUFFERS},
+          pending_buffers{NUM_BUFFERS} {
+        for (std::size_t i = 0; i < NUM_BUFFERS; i++) {
+            free_buffers.Push(Buffer{.data = std::vector<u8>(BUFFER_SIZE)});
+        }
+        thread = std::jthread([this] { Run(); });
+    }
+
+    ~ContentWriter() {
+        Finish();
+    }
+
+    /// Returns an unused buffer, blocking while all of them are waiting to be written.
+    [[nodiscard]] Buffer AcquireBuffer() {
+        return *free_buffers.PopWait();
+    }
+
+    /// Queues size bytes of the buffer to be appended to its content file.
+    void Write(Buffer&& buffer) {
+        if (!pending_buffers.Push(std::move(buffer))) {
+            free_buffers.Push(std::move(buffer));
+        }
+    }
+
+    [[nodiscard]] bool Failed() const {
+        return failed;
+    }
+
+    /// Waits for the queued data to be written and closes the content file.
+    /// @returns false if any of the data couldn't be written
+    bool Finish() {
+        pending_buffers.Close();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        file.Close();
+        return !failed;
+    }
+
+private:
+    void Run() {
+        Common::SetCurrentThreadName("CIAContentWriter");
+        while (auto buffer = pending_buffers.PopWait()) {
+            const std::size_t index = buffer->content_index;
+            if (!failed) {
+                // Content data arrives in order, so only the file of the content being written has
+                // to be open, which keeps CIAs with many contents within the open file limits.
+                if (!file.IsOpen() || index != file_index) {
+                    file = FileUtil::IOFile(paths[index], "wb");
+                    file_index = index;
+                }
+                if (!file.IsOpen() ||
+                    file.WriteBytes(buffer->data.data(), buffer->size) != buffer->size) {
+                    LOG_ERROR(Service_AM, "Failed to write content {} to {}", index,
+                              paths[index]);
+                    failed = true;
+                }
+            }
+            free_buffers.Push(std::move(*buffer));
+        }
+    }
+
+private:
+    std::vector<std::string> paths;
+    FileUtil::IOFile file;
+    std::size_t file_index = 0;
+    Common::BoundedQueue<Buffer> free_buffers;
+    Common::BoundedQueue<Buffer> pending_buffers;
+    std::atomic<bool> failed{false};
+    std::jthread thread;
 };
 
 CIAFile::CIAFile(Service::FS::MediaType media_type)
@@ -133,6 +234,13 @@ ResultCode CIAFile::WriteTitleMetadata() {
 
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
+    decryption_state->content_hash.resize(content_count);
+
+    std::vector<std::string> content_paths(content_count);
+    for (std::size_t i = 0; i < content_count; ++i) {
+        content_paths[i] = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+    }
+    content_writer = std::make_unique<ContentWriter>(std::move(content_paths));
 
     if (auto title_key = container.GetTicket().GetTitleKey()) {
         decryption_state->content.resize(content_count);
@@ -151,11 +259,17 @@ ResultCode CIAFile::WriteTitleMetadata() {
 }
 
 ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length, const u8* buffer) {
+    if (aborted || content_writer->Failed()) {
+        aborted = true;
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    }
+
     // Data is not being buffered, so we have to keep track of how much of each <ID>.app
     // has been written since we might get a written buffer which contains multiple .app
     // contents or only part of a larger .app's contents.
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
     const u64 offset_max = offset + length;
-    for (std::size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
+    for (std::size_t i = 0; i < tmd.GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(i)) {
             // The size, minimum unwritten offset, and maximum unwritten offset of this content
             const u64 size = container.GetContentSize(i);
@@ -171,35 +285,49 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Figure out how much of this content ID we have just recieved/can write out
             const u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
-            // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
-
-            if (!file.IsOpen()) {
+            const bool encrypted =
+                (tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) != 0;
+            if (encrypted && decryption_state->content.size() <= i) {
+                // TODO: There is probably no correct error to return here. What error should be
+                // returned?
                 return FileSys::ERROR_INSUFFICIENT_SPACE;
             }
 
-            std::vector<u8> temp(buffer + (range_min - offset),
-                                 buffer + (range_min - offset) + available_to_write);
-
-            if ((tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) != 0) {
-                if (decryption_state->content.size() <= i) {
-                    // TODO: There is probably no correct error to return here. What error should be
-                    // returned?
-                    return FileSys::ERROR_INSUFFICIENT_SPACE;
+            // Decrypt straight into the writer's buffers, the writer thread writes them out
+            // while the next ones are being filled.
+            const u8* source = buffer + (range_min - offset);
+            u64 remaining = available_to_write;
+            while (remaining > 0) {
+                auto out = content_writer->AcquireBuffer();
+                out.content_index = i;
+                out.size = static_cast<std::size_t>(std::min<u64>(remaining, out.data.size()));
+                if (encrypted) {
+                    decryption_state->content[i].ProcessData(out.data.data(), source, out.size);
+                } else {
+                    std::memcpy(out.data.data(), source, out.size);
                 }
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
+                decryption_state->content_hash[i].Update(out.data.data(), out.size);
+                source += out.size;
+                remaining -= out.size;
+                content_writer->Write(std::move(out));
             }
 
-            file.WriteBytes(temp.data(), temp.size());
-
             // Keep tabs on how much of this content ID has been written so new range_min
             // values can be calculated.
             content_written[i] += available_to_write;
             LOG_DEBUG(Service_AM, "Wrote {:x} to content {}, total {:x}", available_to_write, i,
                       content_written[i]);
+
+            if (content_written[i] == size) {
+                std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+                decryption_state->content_hash[i].Final(hash.data());
+                if (hash != tmd.GetContentHashByIndex(i)) {
+                    LOG_ERROR(Service_AM, "Content {} of title {:016X} doesn't match its hash", i,
+                              tmd.GetTitleID());
+                    aborted = true;
+                    return ERROR_CONTENT_HASH_MISMATCH;
+                }
+            }
         }
     }
 
@@ -286,7 +414,8 @@ bool CIAFile::SetSize(u64 size) const {
 }
 
 bool CIAFile::Close() const {
-    bool complete = true;
+    // Wait for the content data still being written before deciding whether the install is done
+    bool complete = !aborted && (!content_writer || content_writer->Finish());
     for (std::size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(static_cast<u16>(i)))
             complete = false;
@@ -295,8 +424,18 @@ bool CIAFile::Close() const {
     // Install aborted
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
-        FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
-        return true;
+        // Only remove the files written by this install, the title directory also holds the save
+        // data and the contents of the version of the title that is already installed.
+        if (install_state == CIAInstallState::TMDLoaded) {
+            const u64 title_id = container.GetTitleMetadata().GetTitleID();
+            for (std::size_t i = 0; i < content_written.size(); i++) {
+                if (content_written[i] > 0) {
+                    FileUtil::Delete(GetTitleContentPath(media_type, title_id, i, is_update));
+                }
+            }
+            FileUtil::Delete(GetTitleMetadataPath(media_type, title_id, is_update));
+        }
+        return false;
     }
 
     // Clean up older content data if we installed newer content on top
@@ -371,23 +510,66 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
-        std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
+        // The CIA is read on its own thread, while this one decrypts and hashes the contents and
+        // the CIAFile writes them out on a third. The stages hand over a few large buffers, so
+        // each of them only waits when the next one falls behind.
+        struct ReadBuffer {
+            u64 offset;
+            std::size_t size;
+            std::vector<u8> data;
+        };
+        constexpr std::size_t read_buffer_size = 0x400000;
+        constexpr std::size_t num_read_buffers = 4;
+        Common::BoundedQueue<ReadBuffer> free_buffers{num_read_buffers};
+        Common::BoundedQueue<ReadBuffer> read_buffers{num_read_buffers};
+        for (std::size_t i = 0; i < num_read_buffers; i++) {
+            free_buffers.Push(ReadBuffer{.data = std::vector<u8>(read_buffer_size)});
+        }
+
+        const u64 file_size = file.GetSize();
+        std::jthread reader([&] {
+            Common::SetCurrentThreadName("CIAReader");
+            u64 offset = 0;
+            while (offset < file_size) {
+                auto buffer = free_buffers.PopWait();
+                if (!buffer) {
+                    break;
+                }
+                buffer->offset = offset;
+                buffer->size = file.ReadBytes(buffer->data.data(), buffer->data.size());
+                if (buffer->size == 0 || !read_buffers.Push(std::move(*buffer))) {
+                    break;
+                }
+                offset += buffer->size;
+            }
+            read_buffers.Close();
+        });
+
+        u64 total_bytes_read = 0;
+        while (auto buffer = read_buffers.PopWait()) {
+            auto result =
+                installFile.Write(buffer->offset, buffer->size, true, buffer->data.data());
+            total_bytes_read += buffer->size;
 
             if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
+                update_callback(total_bytes_read, file_size);
             if (result.Failed()) {
                 LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
                           result.Code().raw);
+                free_buffers.Close();
+                read_buffers.Close();
                 return InstallStatus::ErrorAborted;
             }
-            total_bytes_read += bytes_read;
+            free_buffers.Push(std::move(*buffer));
+        }
+        if (total_bytes_read != file_size) {
+            LOG_ERROR(Service_AM, "Failed to read {}, aborting...", path);
+            return InstallStatus::ErrorAborted;
+        }
+        if (!installFile.Close()) {
+            LOG_ERROR(Service_AM, "CIA file installation of {} aborted", path);
+            return InstallStatus::ErrorAborted;
         }
-        installFile.Close();
 
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
 
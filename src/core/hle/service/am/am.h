@@ -98,8 +98,14 @@ private:
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
 
+    // Whether content data failed to be written out or didn't match the hash in the TMD
+    bool aborted = false;
+
     class DecryptionState;
     std::unique_ptr<DecryptionState> decryption_state;
+
+    class ContentWriter;
+    std::unique_ptr<ContentWriter> content_writer;
 };
 
 /**
@@ -150,23 +150,68 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
 }
 
 VAddr CROHelper::FindExportNamedSymbol(const std::string& name) const {
-    if (!GetField(ExportTreeNum))
+    const CROSymbolTable& table = GetSymbolTable();
+    const auto it = table.named_exports.find(name);
+    if (it == table.named_exports.end())
         return 0;
 
+    return SegmentTagToAddress(SegmentTag(it->second));
+}
+
+const CROSymbolTable& CROHelper::GetSymbolTable() const {
+    if (const CROSymbolTable* table = symbol_index.Find(module_address)) {
+        return *table;
+    }
+    return symbol_index.Insert(module_address, BuildSymbolTable());
+}
+
+CROSymbolTable CROHelper::BuildSymbolTable() const {
+    CROSymbolTable table;
+    table.module_name = ModuleName();
+
+    u32 export_tree_num = GetField(ExportTreeNum);
+    u32 export_named_symbol_num = GetField(ExportNamedSymbolNum);
+    u32 export_strings_size = GetField(ExportStringsSize);
+    table.named_exports.reserve(export_named_symbol_num);
+
+    // Collects the symbols at the leaves of the export tree. A symbol is only indexed if looking
+    // up its name leads back to it, like the RO service would find it.
+    for (u32 i = 0; i < export_tree_num; ++i) {
+        ExportTreeEntry entry;
+        GetEntry(system.Memory(), i, entry);
+        for (const ExportTreeEntry::Child child : {entry.left, entry.right}) {
+            if (!child.is_end)
+                continue;
+
+            ExportTreeEntry leaf;
+            GetEntry(system.Memory(), child.next_index, leaf);
+            u32 found_id = leaf.export_table_index;
+            if (found_id >= export_named_symbol_num)
+                continue;
+
+            ExportNamedSymbolEntry symbol_entry;
+            GetEntry(system.Memory(), found_id, symbol_entry);
+            std::string name =
+                system.Memory().ReadCString(symbol_entry.name_offset, export_strings_size);
+            if (WalkExportTree(name) == found_id)
+                table.named_exports.emplace(std::move(name), symbol_entry.symbol_position.raw);
+        }
+    }
+    return table;
+}
+
+u32 CROHelper::WalkExportTree(const std::string& name) const {
     std::size_t len = name.size();
     ExportTreeEntry entry;
     GetEntry(system.Memory(), 0, entry);
     ExportTreeEntry::Child next;
     next.raw = entry.left.raw;
-    u32 found_id;
 
     while (true) {
         GetEntry(system.Memory(), next.next_index, entry);
 
-        if (next.is_end) {
-            found_id = entry.export_table_index;
-            break;
-        }
+        if (next.is_end)
+            return entry.export_table_index;
 
         u16 test_byte = entry.test_bit >> 3;
         u16 test_bit_in_byte = entry.test_bit & 7;
@@ -179,20 +224,6 @@ VAddr CROHelper::FindExportNamedSymbol(const std::string& name) const {
             next.raw = entry.left.raw;
         }
     }
-
-    u32 export_named_symbol_num = GetField(ExportNamedSymbolNum);
-
-    if (found_id >= export_named_symbol_num)
-        return 0;
-
-    u32 export_strings_size = GetField(ExportStringsSize);
-    ExportNamedSymbolEntry symbol_entry;
-    GetEntry(system.Memory(), found_id, symbol_entry);
-
-    if (system.Memory().ReadCString(symbol_entry.name_offset, export_strings_size) != name)
-        return 0;
-
-    return SegmentTagToAddress(symbol_entry.symbol_position);
 }
 
 ResultCode CROHelper::RebaseHeader(u32 cro_size) {
@@ -549,7 +580,7 @@ ResultCode CROHelper::ApplyStaticAnonymousSymbolToCRS(VAddr crs_address) {
         static_relocation_table_offset +
         GetField(StaticRelocationNum) * sizeof(StaticRelocationEntry);
 
-    CROHelper crs(crs_address, process, system);
+    CROHelper crs(crs_address, process, system, symbol_index);
     u32 offset_export_num = GetField(StaticAnonymousSymbolNum);
     LOG_INFO(Service_LDR, "CRO \"{}\" exports {} static anonymous symbols", ModuleName(),
              offset_export_num);
@@ -759,10 +790,11 @@ ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address) {
                                   sizeof(ExternalRelocationEntry));
 
         if (!relocation_entry.is_batch_resolved) {
+            std::string symbol_name =
+                system.Memory().ReadCString(entry.name_offset, import_strings_size);
             ResultCode result = ForEachAutoLinkCRO(
-                process, system, crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                    std::string symbol_name =
-                        system.Memory().ReadCString(entry.name_offset, import_strings_size);
+                process, system, symbol_index, crs_address,
+                [&](CROHelper source) -> ResultVal<bool> {
                     u32 symbol_address = source.FindExportNamedSymbol(symbol_name);
 
                     if (symbol_address != 0) {
@@ -863,10 +895,11 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
             system.Memory().ReadCString(entry.name_offset, import_strings_size);
 
         ResultCode result = ForEachAutoLinkCRO(
-            process, system, crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                if (want_cro_name == source.ModuleName()) {
+            process, system, symbol_index, crs_address, [&](CROHelper source) -> ResultVal<bool> {
+                const std::string& source_name = source.GetSymbolTable().module_name;
+                if (want_cro_name == source_name) {
                     LOG_INFO(Service_LDR, "CRO \"{}\" imports {} indexed symbols from \"{}\"",
-                             ModuleName(), entry.import_indexed_symbol_num, source.ModuleName());
+                             ModuleName(), entry.import_indexed_symbol_num, source_name);
                     for (u32 j = 0; j < entry.import_indexed_symbol_num; ++j) {
                         ImportIndexedSymbolEntry im;
                         entry.GetImportIndexedSymbolEntry(process, system.Memory(), j, im);
@@ -883,7 +916,7 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
                         }
                     }
                     LOG_INFO(Service_LDR, "CRO \"{}\" imports {} anonymous symbols from \"{}\"",
-                             ModuleName(), entry.import_anonymous_symbol_num, source.ModuleName());
+                             ModuleName(), entry.import_anonymous_symbol_num, source_name);
                     for (u32 j = 0; j < entry.import_anonymous_symbol_num; ++j) {
                         ImportAnonymousSymbolEntry im;
                         entry.GetImportAnonymousSymbolEntry(process, system.Memory(), j, im);
@@ -1076,7 +1109,8 @@ ResultCode CROHelper::ApplyExitRelocations(VAddr crs_address) {
         if (system.Memory().ReadCString(entry.name_offset, import_strings_size) ==
             "__aeabi_atexit") {
             ResultCode result = ForEachAutoLinkCRO(
-                process, system, crs_address, [&](CROHelper source) -> ResultVal<bool> {
+                process, system, symbol_index, crs_address,
+                [&](CROHelper source) -> ResultVal<bool> {
                     u32 symbol_address = source.FindExportNamedSymbol("nnroAeabiAtexit_");
 
                     if (symbol_address != 0) {
@@ -1227,10 +1261,14 @@ ResultCode CROHelper::Rebase(VAddr crs_address, u32 cro_size, VAddr data_segment
         }
     }
 
+    symbol_index.Insert(module_address, BuildSymbolTable());
+
     return RESULT_SUCCESS;
 }
 
 void CROHelper::Unrebase(bool is_crs) {
+    symbol_index.Erase(module_address);
+
     UnrebaseImportAnonymousSymbolTable();
     UnrebaseImportIndexedSymbolTable();
     UnrebaseImportNamedSymbolTable();
@@ -1307,7 +1345,7 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
     }
 
     // Exports symbols to other modules
-    result = ForEachAutoLinkCRO(process, system, crs_address,
+    result = ForEachAutoLinkCRO(process, system, symbol_index, crs_address,
                                 [this](CROHelper target) -> ResultVal<bool> {
                                     ResultCode result = ApplyExportNamedSymbol(target);
                                     if (result.IsError())
@@ -1352,7 +1390,7 @@ ResultCode CROHelper::Unlink(VAddr crs_address) {
 
     // Resets all symbols in other modules imported from this module
     // Note: the RO service seems only searching in auto-link modules
-    result = ForEachAutoLinkCRO(process, system, crs_address,
+    result = ForEachAutoLinkCRO(process, system, symbol_index, crs_address,
                                 [this](CROHelper target) -> ResultVal<bool> {
                                     ResultCode result = ResetExportNamedSymbol(target);
                                     if (result.IsError())
@@ -1393,13 +1431,14 @@ void CROHelper::InitCRS() {
 }
 
 void CROHelper::Register(VAddr crs_address, bool auto_link) {
-    CROHelper crs(crs_address, process, system);
-    CROHelper head(auto_link ? crs.NextModule() : crs.PreviousModule(), process, system);
+    CROHelper crs(crs_address, process, system, symbol_index);
+    CROHelper head(auto_link ? crs.NextModule() : crs.PreviousModule(), process, system,
+                   symbol_index);
 
     if (head.module_address) {
         // there are already CROs registered
         // register as the new tail
-        CROHelper tail(head.PreviousModule(), process, system);
+        CROHelper tail(head.PreviousModule(), process, system, symbol_index);
 
         // link with the old tail
         ASSERT(tail.NextModule() == 0);
@@ -1425,11 +1464,11 @@ void CROHelper::Register(VAddr crs_address, bool auto_link) {
 }
 
 void CROHelper::Unregister(VAddr crs_address) {
-    CROHelper crs(crs_address, process, system);
-    CROHelper next_head(crs.NextModule(), process, system);
-    CROHelper previous_head(crs.PreviousModule(), process, system);
-    CROHelper next(NextModule(), process, system);
-    CROHelper previous(PreviousModule(), process, system);
+    CROHelper crs(crs_address, process, system, symbol_index);
+    CROHelper next_head(crs.NextModule(), process, system, symbol_index);
+    CROHelper previous_head(crs.PreviousModule(), process, system, symbol_index);
+    CROHelper next(NextModule(), process, system, symbol_index);
+    CROHelper previous(PreviousModule(), process, system, symbol_index);
 
     if (module_address == next_head.module_address ||
         module_address == previous_head.module_address) {
@@ -1500,6 +1539,9 @@ u32 CROHelper::Fix(u32 fix_level) {
             SetField(static_cast<HeaderField>(field), fix_end);
             SetField(static_cast<HeaderField>(field + 1), 0);
         }
+
+        // The fixed tables may include the exported symbols, index them again on next lookup.
+        symbol_index.Erase(module_address);
     }
 
     fix_end = Common::AlignUp(fix_end, Memory::CITRA_PAGE_SIZE);
@@ -5,10 +5,12 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <tuple>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
+#include "core/hle/service/ldr_ro/cro_symbol_index.h"
 #include "core/memory.h"
 
 namespace Kernel {
@@ -33,8 +35,10 @@ static constexpr u32 CRO_HASH_SIZE = 0x80;
 class CROHelper final {
 public:
     // TODO (wwylele): pass in the process handle for memory access
-    explicit CROHelper(VAddr cro_address, Kernel::Process& process, Core::System& system)
-        : module_address(cro_address), process(process), system(system) {}
+    explicit CROHelper(VAddr cro_address, Kernel::Process& process, Core::System& system,
+                       CROSymbolIndex& symbol_index)
+        : module_address(cro_address), process(process), system(system),
+          symbol_index(symbol_index) {}
 
     std::string ModuleName() const {
         return system.Memory().ReadCString(GetField(ModuleNameOffset), GetField(ModuleNameSize));
@@ -144,6 +148,7 @@ private:
     const VAddr module_address; ///< the virtual address of this module
     Kernel::Process& process;   ///< the owner process of this module
     Core::System& system;
+    CROSymbolIndex& symbol_index; ///< the symbol tables of the modules of the owner process
 
     /**
      * Each item in this enum represents a u32 field in the header begin from address+0x80,
@@ -462,6 +467,7 @@ private:
     /**
      * A helper function iterating over all registered auto-link modules, including the static
      * module.
+     * @param symbol_index the symbol tables of the modules of the process
      * @param crs_address the virtual address of the static module
      * @param func a function object to operate on a module. It accepts one parameter
      *        CROHelper and returns ResultVal<bool>. It should return true to continue the
@@ -473,10 +479,11 @@ private:
      */
     template <typename FunctionObject>
     static ResultCode ForEachAutoLinkCRO(Kernel::Process& process, Core::System& system,
-                                         VAddr crs_address, FunctionObject func) {
+                                         CROSymbolIndex& symbol_index, VAddr crs_address,
+                                         FunctionObject func) {
         VAddr current = crs_address;
         while (current != 0) {
-            CROHelper cro(current, process, system);
+            CROHelper cro(current, process, system, symbol_index);
             CASCADE_RESULT(bool next, func(cro));
             if (!next)
                 break;
@@ -523,6 +530,27 @@ private:
      */
     VAddr FindExportNamedSymbol(const std::string& name) const;
 
+    /**
+     * Gets the host copy of the name and exported named symbols of this module, reading them from
+     * guest memory if the module is not indexed yet. The module must be rebased.
+     * @returns the symbol table of this module.
+     */
+    const CROSymbolTable& GetSymbolTable() const;
+
+    /**
+     * Reads the name and exported named symbols of this module from guest memory.
+     * @returns the symbol table of this module.
+     */
+    CROSymbolTable BuildSymbolTable() const;
+
+    /**
+     * Walks the export tree of this module with the provided name.
+     * @param name the name of the symbol to find
+     * @returns the index of the exported named symbol the tree leads to, which has to be checked
+     *          against the name.
+     */
+    u32 WalkExportTree(const std::string& name) const;
+
     /**
      * Rebases offsets in module header according to module address.
      * @param cro_size the size of the CRO file
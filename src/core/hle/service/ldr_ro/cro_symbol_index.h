@@ -0,0 +1,55 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "common/common_types.h"
+
+namespace Service::LDR {
+
+/// Host copy of the name and exported named symbols of a loaded module.
+struct CROSymbolTable {
+    std::string module_name;
+    /// Maps symbol names to their raw segment tags, which are resolved to addresses on lookup so
+    /// that temporary changes to the segment table are honored.
+    std::unordered_map<std::string, u32> named_exports;
+};
+
+/**
+ * Symbol tables of the modules loaded by a client, indexed by module address. Linking looks up
+ * every import of a module in every auto-link module, and walking the export trees and string
+ * tables in guest memory for each of them is slow with dozens of modules loaded. Tables are built
+ * when a module is rebased and dropped when it is unrebased. They are not serialized, modules that
+ * are missing after loading a savestate are indexed again on their next lookup.
+ */
+class CROSymbolIndex {
+public:
+    [[nodiscard]] const CROSymbolTable* Find(VAddr module_address) const {
+        const auto it = tables.find(module_address);
+        return it != tables.end() ? &it->second : nullptr;
+    }
+
+    const CROSymbolTable& Insert(VAddr module_address, CROSymbolTable table) {
+        return tables.insert_or_assign(module_address, std::move(table)).first->second;
+    }
+
+    void Erase(VAddr module_address) {
+        tables.erase(module_address);
+    }
+
+    void Clear() {
+        tables.clear();
+    }
+
+    [[nodiscard]] std::size_t Size() const noexcept {
+        return tables.size();
+    }
+
+private:
+    std::unordered_map<VAddr, CROSymbolTable> tables;
+};
+
+} // namespace Service::LDR
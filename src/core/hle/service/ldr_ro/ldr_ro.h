@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "core/hle/service/ldr_ro/cro_symbol_index.h"
 #include "core/hle/service/service.h"
 
 namespace Core {
@@ -13,7 +14,8 @@ class System;
 namespace Service::LDR {
 
 struct ClientSlot : public Kernel::SessionRequestHandler::SessionDataBase {
-    VAddr loaded_crs = 0; ///< the virtual address of the static module
+    VAddr loaded_crs = 0;        ///< the virtual address of the static module
+    CROSymbolIndex symbol_index; ///< host copy of the symbols of the loaded modules
 
 private:
     template <class Archive>
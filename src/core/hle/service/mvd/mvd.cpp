@@ -10,7 +10,7 @@ namespace Service::MVD {
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<MVD_STD>()->InstallAsService(service_manager);
+    std::make_shared<MVD_STD>(system)->InstallAsService(service_manager);
 }
 
 } // namespace Service::MVD
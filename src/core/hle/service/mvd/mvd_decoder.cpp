@@ -0,0 +1,356 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "common/dynamic_library/ffmpeg.h"
+#include "common/logging/log.h"
+#include "common/polyfill_thread.h"
+#include "common/thread.h"
+#include "core/hle/service/mvd/mvd_decoder.h"
+
+using namespace DynamicLibrary;
+
+namespace Service::MVD {
+
+namespace {
+
+struct AVPacketDeleter {
+    void operator()(AVPacket* packet) const {
+        FFmpeg::av_packet_free(&packet);
+    }
+};
+
+struct AVCodecContextDeleter {
+    void operator()(AVCodecContext* context) const {
+        FFmpeg::avcodec_free_context(&context);
+    }
+};
+
+struct AVCodecParserContextDeleter {
+    void operator()(AVCodecParserContext* parser) const {
+        FFmpeg::av_parser_close(parser);
+    }
+};
+
+struct AVFrameDeleter {
+    void operator()(AVFrame* frame) const {
+        FFmpeg::av_frame_free(&frame);
+    }
+};
+
+/// Converts a limited range BT.601 color to RGB565, or to BGR565 when swap_rb is set.
+u16 EncodeRGB565(s32 y, s32 u, s32 v, bool swap_rb) {
+    const s32 c = 298 * (y - 16) + 128;
+    const s32 d = u - 128;
+    const s32 e = v - 128;
+    const s32 r = std::clamp((c + 409 * e) >> 8, 0, 0xFF);
+    const s32 g = std::clamp((c - 100 * d - 208 * e) >> 8, 0, 0xFF);
+    const s32 b = std::clamp((c + 516 * d) >> 8, 0, 0xFF);
+    const s32 high = swap_rb ? b : r;
+    const s32 low = swap_rb ? r : b;
+    return static_cast<u16>(((high >> 3) << 11) | ((g >> 2) << 5) | (low >> 3));
+}
+
+} // Anonymous namespace
+
+std::optional<NALUnit> PrepareNALUnit(std::span<const u8> memory, u32 size) {
+    if (size > memory.size()) {
+        return std::nullopt;
+    }
+    const u8* data = memory.data();
+
+    // The decoder expects Annex B byte streams, add a start code if the unit doesn't have one
+    NALUnit nal_unit;
+    nal_unit.data.reserve(size + 3);
+    std::size_t header_size = 0;
+    if (size >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) {
+        header_size = 3;
+    } else if (size >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) {
+        header_size = 4;
+    } else {
+        nal_unit.data.insert(nal_unit.data.end(), {0, 0, 1});
+    }
+    if (header_size >= size) {
+        return std::nullopt;
+    }
+    nal_unit.data.insert(nal_unit.data.end(), data, data + size);
+    nal_unit.type = data[header_size] & 0x1F;
+    return nal_unit;
+}
+
+void ConvertFrame(const YUVFrame& frame, OutputFormat format, u32 width, u32 height,
+                  std::vector<u8>& output) {
+    output.resize(width * height * 2);
+    const u32 src_width = frame.width;
+    const u32 src_height = frame.height;
+
+    u8* out = output.data();
+    for (u32 y = 0; y < height; ++y) {
+        const u32 src_y = y * src_height / height;
+        const u8* line_y = frame.planes[0] + src_y * frame.strides[0];
+        const u8* line_u = frame.planes[1] + (src_y / 2) * frame.strides[1];
+        const u8* line_v = frame.planes[2] + (src_y / 2) * frame.strides[2];
+
+        for (u32 x = 0; x < width; x += 2) {
+            const u32 src_x0 = x * src_width / width;
+            const u32 src_x1 = (x + 1) * src_width / width;
+            const s32 y0 = line_y[src_x0];
+            const s32 y1 = line_y[src_x1];
+            const s32 u = line_u[src_x0 / 2];
+            const s32 v = line_v[src_x0 / 2];
+
+            switch (format) {
+            case OutputFormat::YUYV422:
+                out[0] = static_cast<u8>(y0);
+                out[1] = static_cast<u8>(u);
+                out[2] = static_cast<u8>(y1);
+                out[3] = static_cast<u8>(v);
+                break;
+            case OutputFormat::RGB565:
+            case OutputFormat::BGR565: {
+                const bool swap_rb = format == OutputFormat::BGR565;
+                const u16 pixel0 = EncodeRGB565(y0, u, v, swap_rb);
+                const u16 pixel1 = EncodeRGB565(y1, u, v, swap_rb);
+                out[0] = static_cast<u8>(pixel0);
+                out[1] = static_cast<u8>(pixel0 >> 8);
+                out[2] = static_cast<u8>(pixel1);
+                out[3] = static_cast<u8>(pixel1 >> 8);
+                break;
+            }
+            }
+            out += 4;
+        }
+    }
+}
+
+class H264Decoder::Impl {
+public:
+    Impl() {
+        if (!FFmpeg::LoadFFmpeg()) {
+            LOG_ERROR(Service_MVD, "FFmpeg could not be loaded, videos will not be decoded");
+            return;
+        }
+
+        const AVCodec* codec = FFmpeg::avcodec_find_decoder(AV_CODEC_ID_H264);
+        if (!codec) {
+            LOG_ERROR(Service_MVD, "H.264 decoder not found");
+            return;
+        }
+        parser.reset(FFmpeg::av_parser_init(codec->id));
+        av_context.reset(FFmpeg::avcodec_alloc_context3(codec));
+        av_packet.reset(FFmpeg::av_packet_alloc());
+        decoded_frame.reset(FFmpeg::av_frame_alloc());
+        if (!parser || !av_context || !av_packet || !decoded_frame) {
+            LOG_ERROR(Service_MVD, "Could not allocate the H.264 decoder");
+            return;
+        }
+        if (FFmpeg::avcodec_open2(av_context.get(), codec, nullptr) < 0) {
+            LOG_ERROR(Service_MVD, "Could not open the H.264 decoder");
+            return;
+        }
+
+        valid = true;
+        decode_thread =
+            std::jthread([this](std::stop_token stop_token) { DecodeLoop(stop_token); });
+    }
+
+    ~Impl() = default;
+
+    bool IsValid() const {
+        return valid;
+    }
+
+    void SetOutput(OutputFormat format, u32 width, u32 height) {
+        std::scoped_lock lock{frame_mutex};
+        output_format = format;
+        output_width = width;
+        output_height = height;
+    }
+
+    void QueueNALUnit(std::vector<u8> nal_unit) {
+        if (!valid) {
+            return;
+        }
+        {
+            std::scoped_lock lock{queue_mutex};
+            nal_units.push_back(std::move(nal_unit));
+            ++pending_nal_units;
+        }
+        queue_cv.notify_one();
+    }
+
+    void Flush() {
+        // An empty unit tells the decode thread to flush the parser
+        QueueNALUnit({});
+    }
+
+    bool TakeFrame(std::vector<u8>& frame) {
+        std::scoped_lock lock{frame_mutex};
+        if (!has_ready_frame) {
+            return false;
+        }
+        frame.swap(ready_frame);
+        has_ready_frame = false;
+        return true;
+    }
+
+    void WaitIdle() {
+        std::unique_lock lock{queue_mutex};
+        idle_cv.wait(lock, [this] { return pending_nal_units == 0; });
+    }
+
+    u64 GetDecodedFrameCount() const {
+        return decoded_frames.load(std::memory_order_relaxed);
+    }
+
+private:
+    void DecodeLoop(std::stop_token stop_token) {
+        Common::SetCurrentThreadName("MVD:Decoder");
+        while (true) {
+            std::vector<u8> nal_unit;
+            {
+                std::unique_lock lock{queue_mutex};
+                Common::CondvarWait(queue_cv, lock, stop_token,
+                                    [this] { return !nal_units.empty(); });
+                if (stop_token.stop_requested()) {
+                    return;
+                }
+                nal_unit = std::move(nal_units.front());
+                nal_units.pop_front();
+            }
+
+            Decode(nal_unit);
+
+            std::scoped_lock lock{queue_mutex};
+            if (--pending_nal_units == 0) {
+                idle_cv.notify_all();
+            }
+        }
+    }
+
+    void Decode(const std::vector<u8>& nal_unit) {
+        const u8* data = nal_unit.data();
+        std::size_t data_size = nal_unit.size();
+        // Parsing no data makes the parser output the frame it has buffered
+        bool flush = data_size == 0;
+        while (data_size > 0 || flush) {
+            flush = false;
+            const int consumed = FFmpeg::av_parser_parse2(
+                parser.get(), av_context.get(), &av_packet->data, &av_packet->size, data,
+                static_cast<int>(data_size), AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+            if (consumed < 0) {
+                LOG_ERROR(Service_MVD, "Error while parsing NAL unit");
+                return;
+            }
+            data += consumed;
+            data_size -= consumed;
+
+            // The parser only outputs a packet once it has seen the start of the next frame
+            if (av_packet->size == 0) {
+                continue;
+            }
+            if (FFmpeg::avcodec_send_packet(av_context.get(), av_packet.get()) < 0) {
+                LOG_ERROR(Service_MVD, "Error submitting the packet to the decoder");
+                continue;
+            }
+            while (FFmpeg::avcodec_receive_frame(av_context.get(), decoded_frame.get()) >= 0) {
+                OutputFrame(*decoded_frame);
+                FFmpeg::av_frame_unref(decoded_frame.get());
+            }
+        }
+    }
+
+    void OutputFrame(const AVFrame& frame) {
+        if (frame.format != AV_PIX_FMT_YUV420P && frame.format != AV_PIX_FMT_YUVJ420P) {
+            LOG_ERROR(Service_MVD, "Unsupported decoded pixel format {}", frame.format);
+            return;
+        }
+
+        OutputFormat format;
+        u32 width;
+        u32 height;
+        {
+            std::scoped_lock lock{frame_mutex};
+            format = output_format;
+            width = output_width != 0 ? output_width : static_cast<u32>(frame.width);
+            height = output_height != 0 ? output_height : static_cast<u32>(frame.height);
+        }
+        const YUVFrame planes{
+            .planes = {frame.data[0], frame.data[1], frame.data[2]},
+            .strides = {frame.linesize[0], frame.linesize[1], frame.linesize[2]},
+            .width = static_cast<u32>(frame.width),
+            .height = static_cast<u32>(frame.height),
+        };
+        ConvertFrame(planes, format, width & ~1u, height, back_frame);
+        decoded_frames.fetch_add(1, std::memory_order_relaxed);
+
+        std::scoped_lock lock{frame_mutex};
+        ready_frame.swap(back_frame);
+        has_ready_frame = true;
+    }
+
+    bool valid = false;
+
+    // Only accessed by the decode thread once it is running
+    std::unique_ptr<AVCodecContext, AVCodecContextDeleter> av_context;
+    std::unique_ptr<AVCodecParserContext, AVCodecParserContextDeleter> parser;
+    std::unique_ptr<AVPacket, AVPacketDeleter> av_packet;
+    std::unique_ptr<AVFrame, AVFrameDeleter> decoded_frame;
+    std::vector<u8> back_frame;
+
+    std::mutex queue_mutex;
+    std::condition_variable_any queue_cv;
+    std::condition_variable idle_cv;
+    std::deque<std::vector<u8>> nal_units;
+    std::size_t pending_nal_units = 0;
+
+    std::mutex frame_mutex;
+    OutputFormat output_format = OutputFormat::YUYV422;
+    u32 output_width = 0;
+    u32 output_height = 0;
+    std::vector<u8> ready_frame;
+    bool has_ready_frame = false;
+    std::atomic<u64> decoded_frames = 0;
+
+    std::jthread decode_thread;
+};
+
+H264Decoder::H264Decoder() : impl{std::make_unique<Impl>()} {}
+
+H264Decoder::~H264Decoder() = default;
+
+bool H264Decoder::IsValid() const {
+    return impl->IsValid();
+}
+
+void H264Decoder::SetOutput(OutputFormat format, u32 width, u32 height) {
+    impl->SetOutput(format, width, height);
+}
+
+void H264Decoder::QueueNALUnit(std::vector<u8> nal_unit) {
+    impl->QueueNALUnit(std::move(nal_unit));
+}
+
+void H264Decoder::Flush() {
+    impl->Flush();
+}
+
+bool H264Decoder::TakeFrame(std::vector<u8>& frame) {
+    return impl->TakeFrame(frame);
+}
+
+void H264Decoder::WaitIdle() {
+    impl->WaitIdle();
+}
+
+u64 H264Decoder::GetDecodedFrameCount() const {
+    return impl->GetDecodedFrameCount();
+}
+
+} // namespace Service::MVD
@@ -0,0 +1,96 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::MVD {
+
+/// Pixel formats the decoded frames can be converted to, as set in the MVD configuration
+enum class OutputFormat : u32 {
+    YUYV422 = 0x00010001,
+    BGR565 = 0x00040002,
+    RGB565 = 0x00040004,
+};
+
+/// A NAL unit in Annex B format, ready to be queued for decoding
+struct NALUnit {
+    std::vector<u8> data;
+    /// NAL unit type, from the header following the start code
+    u8 type;
+};
+
+/**
+ * Copies the NAL unit of the given size at the start of memory, adding a start code if it doesn't
+ * begin with one.
+ * @returns nothing if the unit is empty, only holds a start code or doesn't fit in memory.
+ */
+std::optional<NALUnit> PrepareNALUnit(std::span<const u8> memory, u32 size);
+
+/// A frame in YUV 4:2:0 planar format, with the lines of each plane stride bytes apart
+struct YUVFrame {
+    std::array<const u8*, 3> planes;
+    std::array<s32, 3> strides;
+    u32 width;
+    u32 height;
+};
+
+/**
+ * Converts a frame to the output format, scaling it to the given size. All output formats use two
+ * bytes per pixel, the width must be even.
+ */
+void ConvertFrame(const YUVFrame& frame, OutputFormat format, u32 width, u32 height,
+                  std::vector<u8>& output);
+
+/**
+ * H.264 decoder backed by FFmpeg. NAL units are decoded and converted to the output format on a
+ * dedicated thread, so queueing them and taking the finished frames never blocks the caller.
+ */
+class H264Decoder {
+public:
+    H264Decoder();
+    ~H264Decoder();
+
+    /// Returns whether FFmpeg could be loaded and the H.264 decoder opened
+    bool IsValid() const;
+
+    /**
+     * Sets the format and size of the frames produced from now on. Decoded frames of a different
+     * size are scaled to the output size.
+     */
+    void SetOutput(OutputFormat format, u32 width, u32 height);
+
+    /// Queues a NAL unit, in Annex B format, for decoding
+    void QueueNALUnit(std::vector<u8> nal_unit);
+
+    /**
+     * Makes the decoder output the frame whose NAL units were queued so far. Otherwise a frame is
+     * only decoded once the first NAL unit of the next one is seen.
+     */
+    void Flush();
+
+    /**
+     * Moves the most recent frame that was decoded since the last call into frame.
+     * @returns false if no new frame was decoded, in which case frame is left untouched.
+     */
+    bool TakeFrame(std::vector<u8>& frame);
+
+    /// Blocks until all queued NAL units have been decoded
+    void WaitIdle();
+
+    /// Returns the number of frames decoded so far
+    u64 GetDecodedFrameCount() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Service::MVD
@@ -2,33 +2,237 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <span>
 #include "common/archives.h"
+#include "common/logging/log.h"
+#include "common/memory_ref.h"
+#include "core/core.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/service/mvd/mvd_decoder.h"
 #include "core/hle/service/mvd/mvd_std.h"
+#include "core/memory.h"
 
+SERVICE_CONSTRUCT_IMPL(Service::MVD::MVD_STD)
 SERIALIZE_EXPORT_IMPL(Service::MVD::MVD_STD)
 
 namespace Service::MVD {
 
-MVD_STD::MVD_STD() : ServiceFramework("mvd:std", 1) {
+/// Decoder status codes returned in place of a result
+constexpr ResultCode StatusOk{0x17000};
+constexpr ResultCode StatusParamSet{0x17001};
+
+/// Work buffer size requested by the official software for the largest supported video
+constexpr u32 DefaultWorkBufferSize = 0x9006C8;
+
+void MVD_STD::Initialize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1, 2, 2);
+    const VAddr work_buffer = rp.Pop<u32>();
+    const u32 work_buffer_size = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+
+    // The work buffer is only used by the hardware decoder, frames are decoded on the host
+    if (!decoder) {
+        CreateDecoder();
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_DEBUG(Service_MVD, "called work_buffer=0x{:08X}, size=0x{:X}", work_buffer,
+              work_buffer_size);
+}
+
+void MVD_STD::Shutdown(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x2, 0, 0);
+    decoder.reset();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_DEBUG(Service_MVD, "called");
+}
+
+void MVD_STD::CalculateWorkBufSize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x3, 12, 0);
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push(DefaultWorkBufferSize);
+
+    LOG_DEBUG(Service_MVD, "called");
+}
+
+void MVD_STD::CalculateImageSize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x4, 3, 0);
+    const u32 type = rp.Pop<u32>();
+    const u32 width = rp.Pop<u32>();
+    const u32 height = rp.Pop<u32>();
+
+    // All supported output formats use 16 bits per pixel
+    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push(width * height * 2);
+
+    LOG_DEBUG(Service_MVD, "called type=0x{:X}, width={}, height={}", type, width, height);
+}
+
+void MVD_STD::ProcessNALUnit(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x8, 5, 2);
+    rp.Skip(1, false);
+    const PAddr address = rp.Pop<u32>();
+    const u32 size = rp.Pop<u32>();
+    const u32 frame_number = rp.Pop<u32>();
+    rp.Skip(1, false);
+    rp.PopObject<Kernel::Process>();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+
+    // The whole unit must be readable from the memory region it starts in
+    const MemoryRef memory = system.Memory().GetPhysicalRef(address);
+    const std::span<const u8> source = memory ? memory.GetReadBytes(size) : std::span<const u8>{};
+    auto nal_unit = decoder ? PrepareNALUnit(source, size) : std::nullopt;
+    if (!nal_unit) {
+        LOG_ERROR(Service_MVD, "Invalid NAL unit at 0x{:08X}, size=0x{:X}", address, size);
+        rb.Push(ResultCode(ErrorDescription::InvalidSize, ErrorModule::MVD,
+                           ErrorSummary::InvalidArgument, ErrorLevel::Usage));
+        return;
+    }
+
+    // Sequence and picture parameter sets don't produce frames
+    const u8 nal_type = nal_unit->type;
+    decoder->QueueNALUnit(std::move(nal_unit->data));
+    rb.Push(nal_type == 7 || nal_type == 8 ? StatusParamSet : StatusOk);
+
+    LOG_TRACE(Service_MVD, "called address=0x{:08X}, size=0x{:X}, frame={}", address, size,
+              frame_number);
+}
+
+void MVD_STD::ControlFrameRendering(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x9, 1, 2);
+    const u32 control = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+
+    // All NAL units of the frame have been processed, decode it without waiting for the next one
+    if (decoder) {
+        decoder->Flush();
+    }
+    RenderFrame();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_TRACE(Service_MVD, "called control={}", control);
+}
+
+void MVD_STD::GetStatus(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0xA, 0, 0);
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_TRACE(Service_MVD, "called");
+}
+
+void MVD_STD::GetStatusOther(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0xB, 0, 0);
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_TRACE(Service_MVD, "called");
+}
+
+void MVD_STD::GetConfig(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1D, 1, 2);
+    const u32 size = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+
+    std::vector<u8> buffer(std::min<std::size_t>(size, sizeof(config)));
+    std::memcpy(buffer.data(), &config, buffer.size());
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+    rb.Push(RESULT_SUCCESS);
+    rb.PushStaticBuffer(std::move(buffer), 0);
+
+    LOG_DEBUG(Service_MVD, "called size=0x{:X}", size);
+}
+
+void MVD_STD::SetConfig(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1E, 1, 4);
+    const u32 size = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+    auto& buffer = rp.PopMappedBuffer();
+
+    buffer.Read(&config, 0, std::min<std::size_t>(size, sizeof(config)));
+    ApplyOutputConfig();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+    rb.Push(RESULT_SUCCESS);
+    rb.PushMappedBuffer(buffer);
+
+    LOG_DEBUG(Service_MVD, "called output_type=0x{:X}, width={}, height={}, address=0x{:08X}",
+              config.output_type, config.output_width, config.output_height,
+              config.output_address0);
+}
+
+void MVD_STD::CreateDecoder() {
+    decoder = std::make_unique<H264Decoder>();
+    ApplyOutputConfig();
+}
+
+void MVD_STD::ApplyOutputConfig() {
+    // The output format is left at its default until the application sets a configuration
+    if (decoder && config.output_type != 0) {
+        decoder->SetOutput(static_cast<OutputFormat>(static_cast<u32>(config.output_type)),
+                           config.output_width, config.output_height);
+    }
+}
+
+void MVD_STD::RenderFrame() {
+    // Frames are decoded and converted on the decoder thread, only the final copy is done here so
+    // that the emulated CPU never waits for the decoder. If the frame isn't ready yet, the output
+    // buffer keeps the previous one.
+    if (!decoder || !decoder->TakeFrame(frame)) {
+        return;
+    }
+
+    const PAddr address = config.output_address0;
+    const u32 size = static_cast<u32>(frame.size());
+    // The whole frame must fit in the memory region the output buffer starts in
+    MemoryRef memory = system.Memory().GetPhysicalRef(address);
+    if (!memory || memory.GetSize() < size) {
+        LOG_ERROR(Service_MVD, "Invalid output buffer at 0x{:08X}, size=0x{:X}", address, size);
+        return;
+    }
+
+    Memory::RasterizerFlushAndInvalidateRegion(address, size);
+    std::memcpy(memory.GetPtr(), frame.data(), size);
+}
+
+MVD_STD::MVD_STD(Core::System& system) : ServiceFramework("mvd:std", 1), system(system) {
     static const FunctionInfo functions[] = {
         // clang-format off
-        {IPC::MakeHeader(0x0001, 2, 2), nullptr, "Initialize"},
-        {IPC::MakeHeader(0x0002, 0, 0), nullptr, "Shutdown"},
-        {IPC::MakeHeader(0x0003, 12, 0), nullptr, "CalculateWorkBufSize"},
-        {IPC::MakeHeader(0x0004, 3, 0), nullptr, "CalculateImageSize"},
-        {IPC::MakeHeader(0x0008, 5, 2), nullptr, "ProcessNALUnit"},
-        {IPC::MakeHeader(0x0009, 1, 2), nullptr, "ControlFrameRendering"},
-        {IPC::MakeHeader(0x000A, 0, 0), nullptr, "GetStatus"},
-        {IPC::MakeHeader(0x000B, 0, 0), nullptr, "GetStatusOther"},
-        {IPC::MakeHeader(0x001D, 1, 2), nullptr, "GetConfig"},
-        {IPC::MakeHeader(0x001E, 1, 4), nullptr, "SetConfig"},
+        {IPC::MakeHeader(0x0001, 2, 2), &MVD_STD::Initialize, "Initialize"},
+        {IPC::MakeHeader(0x0002, 0, 0), &MVD_STD::Shutdown, "Shutdown"},
+        {IPC::MakeHeader(0x0003, 12, 0), &MVD_STD::CalculateWorkBufSize, "CalculateWorkBufSize"},
+        {IPC::MakeHeader(0x0004, 3, 0), &MVD_STD::CalculateImageSize, "CalculateImageSize"},
+        {IPC::MakeHeader(0x0008, 5, 2), &MVD_STD::ProcessNALUnit, "ProcessNALUnit"},
+        {IPC::MakeHeader(0x0009, 1, 2), &MVD_STD::ControlFrameRendering, "ControlFrameRendering"},
+        {IPC::MakeHeader(0x000A, 0, 0), &MVD_STD::GetStatus, "GetStatus"},
+        {IPC::MakeHeader(0x000B, 0, 0), &MVD_STD::GetStatusOther, "GetStatusOther"},
+        {IPC::MakeHeader(0x001D, 1, 2), &MVD_STD::GetConfig, "GetConfig"},
+        {IPC::MakeHeader(0x001E, 1, 4), &MVD_STD::SetConfig, "SetConfig"},
         {IPC::MakeHeader(0x001F, 36, 2), nullptr, "SetOutputBuffer"},
         {IPC::MakeHeader(0x0021, 4, 0), nullptr, "OverrideOutputBuffers"}
         // clang-format on
     };
 
     RegisterHandlers(functions);
-};
+}
+
+MVD_STD::~MVD_STD() = default;
 
 } // namespace Service::MVD
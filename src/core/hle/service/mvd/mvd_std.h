@@ -4,19 +4,122 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <boost/serialization/binary_object.hpp>
+#include "common/common_funcs.h"
+#include "common/swap.h"
 #include "core/hle/service/service.h"
 
+namespace Core {
+class System;
+}
+
 namespace Service::MVD {
 
+class H264Decoder;
+
+/// Conversion configuration of the video decoder, as laid out by the homebrew libctru headers.
+/// Only the fields needed to deliver frames are named.
+struct MVDConfig {
+    u32_le input_type;
+    INSERT_PADDING_WORDS(2);
+    u32_le input_width;
+    u32_le input_height;
+    INSERT_PADDING_WORDS(11);
+    u32_le enable_cropping;
+    u32_le input_crop_x;
+    u32_le input_crop_y;
+    u32_le input_crop_height;
+    u32_le input_crop_width;
+    INSERT_PADDING_WORDS(1);
+    u32_le output_type;
+    u32_le output_width;
+    u32_le output_height;
+    u32_le output_address0;
+    u32_le output_address1;
+    INSERT_PADDING_WORDS(42);
+};
+static_assert(offsetof(MVDConfig, enable_cropping) == 0x40);
+static_assert(offsetof(MVDConfig, output_type) == 0x58);
+static_assert(offsetof(MVDConfig, output_address0) == 0x64);
+static_assert(sizeof(MVDConfig) == 0x114, "MVDConfig has incorrect size");
+
 class MVD_STD final : public ServiceFramework<MVD_STD> {
 public:
-    MVD_STD();
-    ~MVD_STD() = default;
+    explicit MVD_STD(Core::System& system);
+    ~MVD_STD() override;
 
 private:
-    SERVICE_SERIALIZATION_SIMPLE
+    void Initialize(Kernel::HLERequestContext& ctx);
+    void Shutdown(Kernel::HLERequestContext& ctx);
+    void CalculateWorkBufSize(Kernel::HLERequestContext& ctx);
+    void CalculateImageSize(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::ProcessNALUnit service function. The NAL unit is queued for decoding on the
+     * decoder thread and the function returns immediately.
+     *  Inputs:
+     *      1 : Virtual address of the NAL unit
+     *      2 : Physical address of the NAL unit
+     *      3 : Size of the NAL unit
+     *      4 : Frame number
+     *      6 : Process handle
+     *  Outputs:
+     *      1 : Decoder status
+     */
+    void ProcessNALUnit(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::ControlFrameRendering service function. Copies the most recently decoded frame, if
+     * any, to the output buffer set in the configuration.
+     *  Inputs:
+     *      1 : Control value
+     *      3 : Process handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void ControlFrameRendering(Kernel::HLERequestContext& ctx);
+
+    void GetStatus(Kernel::HLERequestContext& ctx);
+    void GetStatusOther(Kernel::HLERequestContext& ctx);
+    void GetConfig(Kernel::HLERequestContext& ctx);
+    void SetConfig(Kernel::HLERequestContext& ctx);
+
+    /// Creates the decoder and applies the current output configuration to it
+    void CreateDecoder();
+
+    /// Sets the output format and size of the decoder from the configuration
+    void ApplyOutputConfig();
+
+    /// Copies the latest decoded frame to the configured output buffer
+    void RenderFrame();
+
+    Core::System& system;
+
+    MVDConfig config{};
+    std::unique_ptr<H264Decoder> decoder;
+    std::vector<u8> frame;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        ar& boost::serialization::base_object<Kernel::SessionRequestHandler>(*this);
+        ar& boost::serialization::make_binary_object(&config, sizeof(config));
+        bool initialized = decoder != nullptr;
+        ar& initialized;
+        if (Archive::is_loading::value) {
+            // The decoder state isn't saved, frames decode again from the next IDR frame the
+            // application sends
+            decoder.reset();
+            if (initialized) {
+                CreateDecoder();
+            }
+        }
+    }
+    friend class boost::serialization::access;
 };
 
 } // namespace Service::MVD
 
+SERVICE_CONSTRUCT(Service::MVD::MVD_STD)
 BOOST_CLASS_EXPORT_KEY(Service::MVD::MVD_STD)
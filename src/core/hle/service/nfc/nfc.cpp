@@ -6,7 +6,7 @@
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
-#include "core/hle/lock.h"
+#include "core/hle/mailbox.h"
 #include "core/hle/service/nfc/nfc.h"
 #include "core/hle/service/nfc/nfc_m.h"
 #include "core/hle/service/nfc/nfc_u.h"
@@ -319,16 +319,18 @@ std::shared_ptr<Module> Module::Interface::GetModule() const {
 }
 
 void Module::Interface::LoadAmiibo(const AmiiboData& amiibo_data) {
-    std::lock_guard lock(HLE::g_hle_lock);
-    nfc->amiibo_data = amiibo_data;
-    nfc->amiibo_in_range = true;
-    nfc->SyncTagState();
+    HLE::PostToEmuThread([nfc = nfc, amiibo_data] {
+        nfc->amiibo_data = amiibo_data;
+        nfc->amiibo_in_range = true;
+        nfc->SyncTagState();
+    });
 }
 
 void Module::Interface::RemoveAmiibo() {
-    std::lock_guard lock(HLE::g_hle_lock);
-    nfc->amiibo_in_range = false;
-    nfc->SyncTagState();
+    HLE::PostToEmuThread([nfc = nfc] {
+        nfc->amiibo_in_range = false;
+        nfc->SyncTagState();
+    });
 }
 
 void Module::SyncTagState() {
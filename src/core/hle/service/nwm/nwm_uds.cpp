@@ -16,7 +16,7 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/shared_page.h"
-#include "core/hle/lock.h"
+#include "core/hle/mailbox.h"
 #include "core/hle/result.h"
 #include "core/hle/service/nwm/nwm_uds.h"
 #include "core/hle/service/nwm/uds_beacon.h"
@@ -191,9 +191,7 @@ void NWM_UDS::HandleAssociationResponseFrame(const Network::WifiPacket& packet)
 }
 
 void NWM_UDS::HandleEAPoLPacket(const Network::WifiPacket& packet) {
-    std::unique_lock hle_lock(HLE::g_hle_lock, std::defer_lock);
-    std::unique_lock lock(connection_status_mutex, std::defer_lock);
-    std::lock(hle_lock, lock);
+    std::lock_guard lock(connection_status_mutex);
 
     if (GetEAPoLFrameType(packet.data) == EAPoLStartMagic) {
         if (connection_status.status != NetworkStatus::ConnectedAsHost) {
@@ -324,9 +322,7 @@ void NWM_UDS::HandleEAPoLPacket(const Network::WifiPacket& packet) {
 
 void NWM_UDS::HandleSecureDataPacket(const Network::WifiPacket& packet) {
     auto secure_data = ParseSecureDataHeader(packet.data);
-    std::unique_lock hle_lock(HLE::g_hle_lock, std::defer_lock);
-    std::unique_lock lock(connection_status_mutex, std::defer_lock);
-    std::lock(hle_lock, lock);
+    std::lock_guard lock(connection_status_mutex);
 
     if (connection_status.status != NetworkStatus::ConnectedAsHost &&
         connection_status.status != NetworkStatus::ConnectedAsClient) {
@@ -381,7 +377,7 @@ void NWM_UDS::HandleSecureDataPacket(const Network::WifiPacket& packet) {
     // Add the received packet to the data queue.
     channel_info->second.received_packets.emplace_back(packet.data);
 
-    // Signal the data event. We can do this directly because we locked g_hle_lock
+    // Signal the data event. We can do this directly because we are on the emulation thread
     channel_info->second.event->Signal();
 }
 
@@ -469,9 +465,7 @@ void NWM_UDS::HandleAuthenticationFrame(const Network::WifiPacket& packet) {
 
 void NWM_UDS::HandleDeauthenticationFrame(const Network::WifiPacket& packet) {
     LOG_DEBUG(Service_NWM, "called");
-    std::unique_lock hle_lock(HLE::g_hle_lock, std::defer_lock);
-    std::unique_lock lock(connection_status_mutex, std::defer_lock);
-    std::lock(hle_lock, lock);
+    std::lock_guard lock(connection_status_mutex);
     if (connection_status.status != NetworkStatus::ConnectedAsHost) {
         LOG_ERROR(Service_NWM, "Got deauthentication frame but we are not the host");
         return;
@@ -536,11 +530,12 @@ void NWM_UDS::OnWifiPacketReceived(const Network::WifiPacket& packet) {
     case Network::WifiPacket::PacketType::AssociationResponse:
         HandleAssociationResponseFrame(packet);
         break;
+    // These signal kernel events, so they have to be handled on the emulation thread.
     case Network::WifiPacket::PacketType::Data:
-        HandleDataFrame(packet);
+        HLE::PostToEmuThread([this, packet] { HandleDataFrame(packet); });
         break;
     case Network::WifiPacket::PacketType::Deauthentication:
-        HandleDeauthenticationFrame(packet);
+        HLE::PostToEmuThread([this, packet] { HandleDeauthenticationFrame(packet); });
         break;
     case Network::WifiPacket::PacketType::NodeMap:
         HandleNodeMapPacket(packet);
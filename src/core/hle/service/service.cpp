@@ -3,10 +3,15 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <mutex>
 #include <fmt/format.h>
 #include "common/assert.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/perf_sections.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
@@ -122,11 +127,27 @@ const std::array<ServiceModuleInfo, 41> service_module_map{
     return function_string;
 }
 
+MICROPROFILE_DEFINE(Service_IPC, "Service", "IPC", MP_RGB(200, 150, 50));
+
+namespace {
+/// Every live service, used to collect the IPC profile
+std::mutex g_services_mutex;
+std::vector<ServiceFrameworkBase*> g_services;
+} // Anonymous namespace
+
 ServiceFrameworkBase::ServiceFrameworkBase(const char* service_name, u32 max_sessions,
                                            InvokerFn* handler_invoker)
-    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {}
+    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker),
+      profile_token(MicroProfileGetToken("Service", service_name, MP_RGB(200, 150, 50),
+                                         MicroProfileTokenTypeCpu)) {
+    std::scoped_lock lock{g_services_mutex};
+    g_services.push_back(this);
+}
 
-ServiceFrameworkBase::~ServiceFrameworkBase() = default;
+ServiceFrameworkBase::~ServiceFrameworkBase() {
+    std::scoped_lock lock{g_services_mutex};
+    g_services.erase(std::find(g_services.begin(), g_services.end(), this));
+}
 
 void ServiceFrameworkBase::InstallAsService(SM::ServiceManager& service_manager) {
     auto port = service_manager.RegisterService(service_name, max_sessions).Unwrap();
@@ -171,17 +192,38 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const Funct
 }
 
 void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context) {
+    MICROPROFILE_SCOPE(Service_IPC);
+    MICROPROFILE_SCOPE_TOKEN(profile_token);
+    Common::ScopedPerfSection section{Common::PerfSection::Services};
+
     u32 header_code = context.CommandBuffer()[0];
     auto itr = handlers.find(header_code);
     const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
     if (info == nullptr || info->handler_callback == nullptr) {
+        command_stats[header_code].calls++;
         context.ReportUnimplemented();
         return ReportUnimplementedFunction(context.CommandBuffer(), info);
     }
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+
+    const auto& timing = Core::System::GetInstance().CoreTiming();
+    const s64 start_ticks = timing.GetTicks();
+    const auto start_time = std::chrono::steady_clock::now();
+
     handler_invoker(this, info->handler_callback, context);
+
+    const std::chrono::nanoseconds host_time = std::chrono::steady_clock::now() - start_time;
+    IPCCommandStats& stats = command_stats[header_code];
+    stats.calls++;
+    stats.total_host_time += host_time;
+    stats.max_host_time = std::max(stats.max_host_time, host_time);
+    stats.emulated_ticks += timing.GetTicks() - start_ticks;
+}
+
+void ServiceFrameworkBase::ResetCommandStats() {
+    command_stats.clear();
 }
 
 std::string ServiceFrameworkBase::GetFunctionName(u32 header) const {
@@ -212,6 +254,56 @@ static bool AttemptLLE(const ServiceModuleInfo& service_module) {
     return true;
 }
 
+std::vector<IPCProfileEntry> GetIPCProfile() {
+    std::vector<IPCProfileEntry> profile;
+    {
+        std::scoped_lock lock{g_services_mutex};
+        for (const ServiceFrameworkBase* service : g_services) {
+            for (const auto& [header, stats] : service->GetCommandStats()) {
+                std::string function_name = service->GetFunctionName(header);
+                if (function_name.empty()) {
+                    function_name = fmt::format("{:#010x}", header);
+                }
+                profile.push_back(
+                    {service->GetServiceName(), std::move(function_name), header, stats});
+            }
+        }
+    }
+
+    std::sort(profile.begin(), profile.end(), [](const auto& a, const auto& b) {
+        return a.stats.total_host_time > b.stats.total_host_time;
+    });
+    return profile;
+}
+
+void ResetIPCProfile() {
+    std::scoped_lock lock{g_services_mutex};
+    for (ServiceFrameworkBase* service : g_services) {
+        service->ResetCommandStats();
+    }
+}
+
+bool DumpIPCProfile(const std::string& path) {
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Service, "Could not open IPC profile file {}", path);
+        return false;
+    }
+
+    file.WriteString("service,function,header,calls,total_host_us,mean_host_us,max_host_us,"
+                     "emulated_ticks\n");
+    for (const auto& entry : GetIPCProfile()) {
+        const auto& stats = entry.stats;
+        const double total_us = stats.total_host_time.count() / 1000.0;
+        file.WriteString(fmt::format("{},{},{:#010x},{},{:.3f},{:.3f},{:.3f},{}\n",
+                                     entry.service_name, entry.function_name, entry.header,
+                                     stats.calls, total_us, total_us / stats.calls,
+                                     stats.max_host_time.count() / 1000.0,
+                                     stats.emulated_ticks));
+    }
+    return true;
+}
+
 /// Initialize ServiceManager
 void Init(Core::System& core) {
     SM::ServiceManager::InstallInterfaces(core);
@@ -5,10 +5,12 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -39,6 +41,23 @@ static const int kMaxPortSize = 8; ///< Maximum size of a port name (8 character
 /// Arbitrary default number of maximum connections to an HLE service.
 static const u32 DefaultMaxSessions = 10;
 
+/// Cost of the requests handled by a single command of a service.
+struct IPCCommandStats {
+    u64 calls = 0;
+    std::chrono::nanoseconds total_host_time{};
+    std::chrono::nanoseconds max_host_time{};
+    /// Emulated CPU ticks consumed while the handler was running
+    s64 emulated_ticks = 0;
+};
+
+/// IPC statistics of one command, as returned by GetIPCProfile.
+struct IPCProfileEntry {
+    std::string service_name;
+    std::string function_name;
+    u32 header;
+    IPCCommandStats stats;
+};
+
 /**
  * This is an non-templated base of ServiceFramework to reduce code bloat and compilation times, it
  * is not meant to be used directly.
@@ -70,6 +89,14 @@ public:
     /// Retrieves name of a function based on the header code. For IPC Recorder.
     std::string GetFunctionName(u32 header) const;
 
+    /// Returns the statistics of every command handled by this service so far, keyed by header.
+    const boost::container::flat_map<u32, IPCCommandStats>& GetCommandStats() const {
+        return command_stats;
+    }
+
+    /// Clears the statistics of every command of this service.
+    void ResetCommandStats();
+
 protected:
     /// Member-function pointer type of SyncRequest handlers.
     template <typename Self>
@@ -103,6 +130,11 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+
+    /// Per-command IPC statistics, including unimplemented commands.
+    boost::container::flat_map<u32, IPCCommandStats> command_stats;
+    /// MicroProfile timer covering all the handlers of this service.
+    u64 profile_token;
 };
 
 /**
@@ -188,6 +220,22 @@ private:
 /// Initialize ServiceManager
 void Init(Core::System& system);
 
+/**
+ * Collects the IPC statistics of every live HLE service, sorted by total host time. The counters
+ * are updated on the emulation thread, so this should only be called while emulation is paused
+ * or from that thread.
+ */
+std::vector<IPCProfileEntry> GetIPCProfile();
+
+/// Clears the IPC statistics of every live HLE service.
+void ResetIPCProfile();
+
+/**
+ * Writes the IPC statistics of every live HLE service to the given file as CSV.
+ * @returns false if the file could not be written.
+ */
+bool DumpIPCProfile(const std::string& path);
+
 struct ServiceModuleInfo {
     std::string name;
     u64 title_id;
@@ -0,0 +1,445 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/polyfill_thread.h"
+#include "common/thread.h"
+#include "core/hle/service/soc_reactor.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#endif
+
+namespace Service::SOC {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum ReadyFlags : u32 {
+    ReadyRead = 1 << 0,
+    ReadyWrite = 1 << 1,
+    ReadyError = 1 << 2,
+};
+
+#ifndef __linux__
+/// Longest time the I/O thread polls before picking up waits added in the meantime.
+constexpr auto poll_slice = std::chrono::milliseconds(10);
+#endif
+
+int ToTimeoutMs(std::optional<Clock::duration> timeout) {
+    if (!timeout) {
+        return -1;
+    }
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(*timeout).count();
+    return static_cast<int>(std::min<s64>(ms, std::numeric_limits<int>::max()));
+}
+
+} // Anonymous namespace
+
+struct SocketReactor::Impl {
+    struct PendingWait {
+        std::vector<SocketWatch> watches;
+        std::optional<Clock::time_point> deadline;
+        Completion completion;
+    };
+
+    /// Completions of finished waits along with whether they timed out, run outside of the lock.
+    using Completed = std::vector<std::pair<Completion, bool>>;
+
+    Impl();
+    ~Impl();
+
+    void Run(std::stop_token stop_token);
+
+    /// Blocks until a watched socket is ready or the timeout expires. Returns the ready sockets.
+    std::vector<std::pair<SocketFd, u32>> WaitReady(std::optional<Clock::duration> timeout);
+
+    /// Removes a wait and queues its completion. Unknown ids are ignored.
+    void Complete(u64 id, bool timed_out, Completed& completed);
+
+    /// Returns whether any waiter of the socket wants to read and/or write.
+    std::pair<bool, bool> GetInterest(SocketFd fd) const;
+
+    /// Makes the backend watch the current interest of a socket. Returns false on failure.
+    bool UpdateInterest(SocketFd fd);
+
+    /// Wakes the I/O thread so that it picks up new waits and deadlines.
+    void Interrupt();
+
+    std::mutex mutex;
+    u64 next_id = 0;
+    std::unordered_map<u64, PendingWait> waits;
+    /// Ids of the waits involving each watched socket
+    std::unordered_map<SocketFd, std::vector<u64>> watchers;
+
+#ifdef __linux__
+    int epoll_fd = -1;
+    int wakeup_fd = -1;
+    /// Event masks of the sockets currently registered with epoll
+    std::unordered_map<SocketFd, u32> registered;
+#else
+    /// Wakes the I/O thread while no socket is watched, as there is nothing to poll then
+    std::condition_variable wakeup_cv;
+    bool interrupted = false;
+#endif
+
+    std::jthread thread;
+};
+
+SocketReactor::Impl::Impl() {
+#ifdef __linux__
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASSERT_MSG(epoll_fd != -1 && wakeup_fd != -1, "Failed to create socket reactor: {}", errno);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeup_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event);
+#endif
+
+    thread = std::jthread([this](std::stop_token stop_token) { Run(stop_token); });
+}
+
+SocketReactor::Impl::~Impl() {
+    thread.request_stop();
+    Interrupt();
+    thread.join();
+#ifdef __linux__
+    close(wakeup_fd);
+    close(epoll_fd);
+#endif
+}
+
+void SocketReactor::Impl::Run(std::stop_token stop_token) {
+    Common::SetCurrentThreadName("SOC:Reactor");
+
+    while (!stop_token.stop_requested()) {
+        std::optional<Clock::duration> timeout;
+        {
+            std::scoped_lock lock{mutex};
+            const auto now = Clock::now();
+            for (const auto& [id, wait] : waits) {
+                if (wait.deadline) {
+                    const auto remaining =
+                        std::max<Clock::duration>(*wait.deadline - now, Clock::duration::zero());
+                    timeout = timeout ? std::min(*timeout, remaining) : remaining;
+                }
+            }
+        }
+
+        const auto ready = WaitReady(timeout);
+
+        Completed completed;
+        {
+            std::scoped_lock lock{mutex};
+            for (const auto& [fd, flags] : ready) {
+                const auto it = watchers.find(fd);
+                if (it == watchers.end()) {
+                    continue;
+                }
+                // Completing a wait modifies the list of watchers, so iterate over a copy.
+                const std::vector<u64> ids = it->second;
+                for (const u64 id : ids) {
+                    const auto& watches = waits.at(id).watches;
+                    const bool wanted =
+                        std::any_of(watches.begin(), watches.end(), [&](const SocketWatch& watch) {
+                            return watch.fd == fd &&
+                                   ((flags & ReadyError) || (watch.read && (flags & ReadyRead)) ||
+                                    (watch.write && (flags & ReadyWrite)));
+                        });
+                    if (wanted) {
+                        Complete(id, false, completed);
+                    }
+                }
+            }
+
+            const auto now = Clock::now();
+            std::vector<u64> expired;
+            for (const auto& [id, wait] : waits) {
+                if (wait.deadline && *wait.deadline <= now) {
+                    expired.push_back(id);
+                }
+            }
+            for (const u64 id : expired) {
+                Complete(id, true, completed);
+            }
+        }
+
+        for (auto& [completion, timed_out] : completed) {
+            completion(timed_out);
+        }
+    }
+}
+
+#ifdef __linux__
+
+std::vector<std::pair<SocketFd, u32>> SocketReactor::Impl::WaitReady(
+    std::optional<Clock::duration> timeout) {
+    std::array<epoll_event, 64> events;
+    const int count =
+        epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), ToTimeoutMs(timeout));
+    if (count < 0) {
+        if (errno != EINTR) {
+            LOG_ERROR(Service_SOC, "epoll_wait failed: {}", errno);
+        }
+        return {};
+    }
+
+    std::vector<std::pair<SocketFd, u32>> ready;
+    for (int i = 0; i < count; i++) {
+        const epoll_event& event = events[i];
+        if (event.data.fd == wakeup_fd) {
+            u64 value;
+            [[maybe_unused]] const auto bytes = read(wakeup_fd, &value, sizeof(value));
+            continue;
+        }
+        u32 flags = 0;
+        if (event.events & (EPOLLIN | EPOLLPRI)) {
+            flags |= ReadyRead;
+        }
+        if (event.events & EPOLLOUT) {
+            flags |= ReadyWrite;
+        }
+        if (event.events & (EPOLLERR | EPOLLHUP)) {
+            flags |= ReadyError;
+        }
+        ready.emplace_back(event.data.fd, flags);
+    }
+    return ready;
+}
+
+bool SocketReactor::Impl::UpdateInterest(SocketFd fd) {
+    const auto [want_read, want_write] = GetInterest(fd);
+    const u32 mask = (want_read ? u32{EPOLLIN | EPOLLPRI} : 0) | (want_write ? u32{EPOLLOUT} : 0);
+
+    const auto it = registered.find(fd);
+    if (mask == 0) {
+        if (it != registered.end()) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            registered.erase(it);
+        }
+        return true;
+    }
+    if (it != registered.end() && it->second == mask) {
+        return true;
+    }
+
+    epoll_event event{};
+    event.events = mask;
+    event.data.fd = fd;
+    const int op = it == registered.end() ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (epoll_ctl(epoll_fd, op, fd, &event) != 0) {
+        LOG_ERROR(Service_SOC, "Failed to watch socket {}: {}", fd, errno);
+        return false;
+    }
+    registered[fd] = mask;
+    return true;
+}
+
+void SocketReactor::Impl::Interrupt() {
+    const u64 value = 1;
+    [[maybe_unused]] const auto bytes = write(wakeup_fd, &value, sizeof(value));
+}
+
+#else
+
+std::vector<std::pair<SocketFd, u32>> SocketReactor::Impl::WaitReady(
+    std::optional<Clock::duration> timeout) {
+#ifdef _WIN32
+    // WSAPoll rejects POLLPRI.
+    constexpr short read_events = POLLIN;
+#else
+    constexpr short read_events = POLLIN | POLLPRI;
+#endif
+
+    std::vector<pollfd> fds;
+    {
+        std::unique_lock lock{mutex};
+        if (watchers.empty()) {
+            // Sleep until a wait is added or the earliest deadline passes
+            const auto woken = [this] { return std::exchange(interrupted, false); };
+            if (timeout) {
+                wakeup_cv.wait_for(lock, *timeout, woken);
+            } else {
+                wakeup_cv.wait(lock, woken);
+            }
+            return {};
+        }
+        interrupted = false;
+
+        fds.reserve(watchers.size());
+        for (const auto& [fd, ids] : watchers) {
+            const auto [want_read, want_write] = GetInterest(fd);
+            pollfd entry{};
+            entry.fd = fd;
+            entry.events = static_cast<short>((want_read ? read_events : 0) |
+                                              (want_write ? POLLOUT : 0));
+            fds.push_back(entry);
+        }
+    }
+
+    const Clock::duration slice = timeout ? std::min<Clock::duration>(*timeout, poll_slice)
+                                          : Clock::duration(poll_slice);
+
+#ifdef _WIN32
+    const int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), ToTimeoutMs(slice));
+#else
+    const int count = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), ToTimeoutMs(slice));
+#endif
+    if (count <= 0) {
+        return {};
+    }
+
+    std::vector<std::pair<SocketFd, u32>> ready;
+    for (const pollfd& entry : fds) {
+        u32 flags = 0;
+        if (entry.revents & read_events) {
+            flags |= ReadyRead;
+        }
+        if (entry.revents & POLLOUT) {
+            flags |= ReadyWrite;
+        }
+        if (entry.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            flags |= ReadyError;
+        }
+        if (flags != 0) {
+            ready.emplace_back(static_cast<SocketFd>(entry.fd), flags);
+        }
+    }
+    return ready;
+}
+
+bool SocketReactor::Impl::UpdateInterest(SocketFd) {
+    // The interest of every socket is gathered again before each poll.
+    return true;
+}
+
+void SocketReactor::Impl::Interrupt() {
+    // The I/O thread never polls for longer than a slice, it only has to be woken up while it
+    // waits for sockets to watch.
+    {
+        std::scoped_lock lock{mutex};
+        interrupted = true;
+    }
+    wakeup_cv.notify_one();
+}
+
+#endif // __linux__
+
+void SocketReactor::Impl::Complete(u64 id, bool timed_out, Completed& completed) {
+    const auto it = waits.find(id);
+    if (it == waits.end()) {
+        return;
+    }
+    PendingWait wait = std::move(it->second);
+    waits.erase(it);
+
+    for (const SocketWatch& watch : wait.watches) {
+        const auto watcher = watchers.find(watch.fd);
+        if (watcher != watchers.end()) {
+            std::erase(watcher->second, id);
+            if (watcher->second.empty()) {
+                watchers.erase(watcher);
+            }
+        }
+        UpdateInterest(watch.fd);
+    }
+    completed.emplace_back(std::move(wait.completion), timed_out);
+}
+
+std::pair<bool, bool> SocketReactor::Impl::GetInterest(SocketFd fd) const {
+    bool read = false;
+    bool write = false;
+    const auto it = watchers.find(fd);
+    if (it == watchers.end()) {
+        return {read, write};
+    }
+    for (const u64 id : it->second) {
+        for (const SocketWatch& watch : waits.at(id).watches) {
+            if (watch.fd == fd) {
+                read |= watch.read;
+                write |= watch.write;
+            }
+        }
+    }
+    return {read, write};
+}
+
+SocketReactor::SocketReactor() : impl(std::make_unique<Impl>()) {}
+
+SocketReactor::~SocketReactor() = default;
+
+void SocketReactor::Wait(std::vector<SocketWatch> watches, std::chrono::milliseconds timeout,
+                         Completion completion) {
+    Impl::Completed completed;
+    {
+        std::scoped_lock lock{impl->mutex};
+        const u64 id = impl->next_id++;
+        auto& wait = impl->waits[id];
+        wait.watches = std::move(watches);
+        if (timeout.count() >= 0) {
+            wait.deadline = Clock::now() + timeout;
+        }
+        wait.completion = std::move(completion);
+
+        bool watching = true;
+        for (const SocketWatch& watch : wait.watches) {
+            auto& ids = impl->watchers[watch.fd];
+            if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+                ids.push_back(id);
+            }
+            watching &= impl->UpdateInterest(watch.fd);
+        }
+        // Sockets that cannot be watched are reported as ready, the retried operation will then
+        // fail with the actual error instead of waiting forever.
+        if (!watching) {
+            impl->Complete(id, false, completed);
+        }
+    }
+    impl->Interrupt();
+
+    for (auto& [callback, timed_out] : completed) {
+        callback(timed_out);
+    }
+}
+
+void SocketReactor::Cancel(SocketFd fd) {
+    Impl::Completed completed;
+    {
+        std::scoped_lock lock{impl->mutex};
+        const auto it = impl->watchers.find(fd);
+        if (it != impl->watchers.end()) {
+            const std::vector<u64> ids = it->second;
+            for (const u64 id : ids) {
+                impl->Complete(id, false, completed);
+            }
+        }
+    }
+
+    for (auto& [callback, timed_out] : completed) {
+        callback(timed_out);
+    }
+}
+
+} // namespace Service::SOC
@@ -0,0 +1,69 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::SOC {
+
+#ifdef _WIN32
+using SocketFd = unsigned long long;
+#else
+using SocketFd = int;
+#endif // _WIN32
+
+/// A host socket and the readiness a waiter is interested in.
+struct SocketWatch {
+    SocketFd fd;
+    bool read;  ///< Wake when data (or a connection, or out-of-band data) can be received
+    bool write; ///< Wake when data can be sent or a pending connect finished
+};
+
+/**
+ * Waits for host sockets to become ready on a dedicated I/O thread, so that guest threads doing
+ * blocking socket calls can be put to sleep instead of stalling the emulation thread. Backed by
+ * epoll on Linux, other platforms poll all watched sockets in short slices.
+ *
+ * Errors and hang-ups always complete a wait. Completions may be spurious (another guest thread
+ * may have consumed the data first), so callers retry their operation without blocking and wait
+ * again if it still would block.
+ */
+class SocketReactor {
+public:
+    /**
+     * Called when a wait completes, with whether its timeout expired. This is usually the I/O
+     * thread, but Wait and Cancel call it on the caller's thread when they complete a wait
+     * themselves.
+     */
+    using Completion = std::function<void(bool timed_out)>;
+
+    SocketReactor();
+    ~SocketReactor();
+
+    /**
+     * Waits until any of the given sockets becomes ready.
+     * @param watches Sockets to watch along with the readiness to wait for.
+     * @param timeout Time after which the wait completes regardless, negative to wait forever.
+     * @param completion Invoked exactly once unless the reactor is destroyed first.
+     */
+    void Wait(std::vector<SocketWatch> watches, std::chrono::milliseconds timeout,
+              Completion completion);
+
+    /**
+     * Completes every wait involving the given socket as if it became ready. Must be called
+     * before the socket is closed so that no wait refers to a recycled descriptor.
+     */
+    void Cancel(SocketFd fd);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Service::SOC
@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <memory>
+#include <optional>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -16,7 +19,10 @@
 #include "common/swap.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/mailbox.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 
@@ -375,36 +381,39 @@ bool SOC_U::GetSocketBlocking(const SocketHolder& socket_holder) {
     return socket_holder.blocking;
 }
 u32 SOC_U::SetSocketBlocking(SocketHolder& socket_holder, bool blocking) {
-    u32 posix_ret = 0;
+    socket_holder.blocking = blocking;
+    return 0;
+}
+
+/// Puts a host socket in non-blocking mode, blocking guest calls wait on the reactor instead.
+static void SetHostSocketNonBlocking(SocketFd fd) {
 #ifdef _WIN32
-    unsigned long nonblocking = (blocking) ? 0 : 1;
-    int ret = ioctlsocket(socket_holder.socket_fd, FIONBIO, &nonblocking);
-    if (ret == SOCKET_ERROR_VALUE) {
-        posix_ret = TranslateError(GET_ERRNO);
-        return posix_ret;
+    unsigned long nonblocking = 1;
+    if (ioctlsocket(fd, FIONBIO, &nonblocking) == SOCKET_ERROR_VALUE) {
+        LOG_ERROR(Service_SOC, "Failed to make socket non-blocking: {}", GET_ERRNO);
     }
-    socket_holder.blocking = blocking;
 #else
-    int flags = ::fcntl(socket_holder.socket_fd, F_GETFL, 0);
-    if (flags == SOCKET_ERROR_VALUE) {
-        posix_ret = TranslateError(GET_ERRNO);
-        return posix_ret;
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags == SOCKET_ERROR_VALUE || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        LOG_ERROR(Service_SOC, "Failed to make socket non-blocking: {}", GET_ERRNO);
     }
+#endif
+}
 
-    flags &= ~O_NONBLOCK;
-    if (!blocking) { // O_NONBLOCK
-        flags |= O_NONBLOCK;
+/// Sends data to the given address, or to the connected peer if there is none.
+static s32 SendToPlatform(SocketFd fd, const std::vector<u8>& data, u32 flags,
+                          const std::optional<sockaddr>& dest_addr) {
+    const auto buffer = reinterpret_cast<const char*>(data.data());
+    const auto len = static_cast<int>(data.size());
+    if (dest_addr) {
+        return static_cast<s32>(::sendto(fd, buffer, len, flags, &*dest_addr, sizeof(sockaddr)));
     }
+    return static_cast<s32>(::sendto(fd, buffer, len, flags, nullptr, 0));
+}
 
-    socket_holder.blocking = blocking;
-
-    const int ret = ::fcntl(socket_holder.socket_fd, F_SETFL, flags);
-    if (ret == SOCKET_ERROR_VALUE) {
-        posix_ret = TranslateError(GET_ERRNO);
-        return posix_ret;
-    }
-#endif
-    return posix_ret;
+/// Returns whether a failed call on a non-blocking socket would have blocked.
+static bool WouldBlock(int error) {
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK) || error == ERRNO(EINPROGRESS);
 }
 
 static u32 SendRecvFlagsToPlatform(u32 flags) {
@@ -702,23 +711,117 @@ static u32 NameInfoFlagsToPlatform(u32 flags) {
 
 static_assert(sizeof(CTRAddrInfo) == 0x130, "Size of CTRAddrInfo is not correct");
 
-void SOC_U::PreTimerAdjust() {
-    adjust_value_last = std::chrono::steady_clock::now();
+/// Receives data, storing the source address in addr_buff unless it is empty.
+static s32 RecvFromPlatform(SocketFd fd, std::vector<u8>& output_buff, u32 flags,
+                            std::vector<u8>& addr_buff) {
+    const auto buffer = reinterpret_cast<char*>(output_buff.data());
+    const auto len = static_cast<int>(output_buff.size());
+    if (addr_buff.empty()) {
+        return static_cast<s32>(::recvfrom(fd, buffer, len, flags, nullptr, 0));
+    }
+
+    sockaddr src_addr;
+    socklen_t src_addr_len = sizeof(src_addr);
+    const auto ret =
+        static_cast<s32>(::recvfrom(fd, buffer, len, flags, &src_addr, &src_addr_len));
+    if (ret >= 0 && src_addr_len > 0) {
+        const CTRSockAddr ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
+        std::memcpy(addr_buff.data(), &ctr_src_addr,
+                    std::min(addr_buff.size(), sizeof(ctr_src_addr)));
+    }
+    return ret;
+}
+
+struct SOC_U::PendingOperation {
+    std::shared_ptr<Kernel::HLERequestContext> context;
+    std::shared_ptr<Kernel::Event> event;
+    std::vector<SocketWatch> watches;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    BlockingOperation operation;
+};
+
+void SOC_U::RunBlocking(Kernel::HLERequestContext& ctx, const std::string& reason,
+                        std::vector<SocketWatch> watches, std::chrono::milliseconds timeout,
+                        BlockingOperation operation) {
+    if (operation(ctx, false)) {
+        return;
+    }
+
+    auto pending = std::make_shared<PendingOperation>();
+    pending->context = ctx.shared_from_this();
+    pending->event = ctx.SleepClientThread(fmt::format("soc_u::{}", reason),
+                                           std::chrono::nanoseconds(-1), nullptr);
+    pending->watches = std::move(watches);
+    if (timeout.count() >= 0) {
+        pending->deadline = std::chrono::steady_clock::now() + timeout;
+    }
+    pending->operation = std::move(operation);
+    pending_operations.push_back(pending);
+    WaitForRetry(std::move(pending));
+}
+
+void SOC_U::WaitForRetry(std::shared_ptr<PendingOperation> pending) {
+    auto timeout = std::chrono::milliseconds(-1);
+    if (pending->deadline) {
+        timeout = std::max(std::chrono::ceil<std::chrono::milliseconds>(
+                               *pending->deadline - std::chrono::steady_clock::now()),
+                           std::chrono::milliseconds(0));
+    }
+
+    std::weak_ptr<SOC_U> weak_this = std::static_pointer_cast<SOC_U>(shared_from_this());
+    reactor->Wait(pending->watches, timeout, [weak_this, pending](bool timed_out) {
+        // The retried call writes guest memory and signals kernel objects.
+        HLE::PostToEmuThread([weak_this, pending, timed_out] {
+            const auto self = weak_this.lock();
+            if (!self) {
+                return;
+            }
+            if (pending->operation(*pending->context, timed_out)) {
+                std::erase(self->pending_operations, pending);
+                pending->event->Signal();
+            } else {
+                self->WaitForRetry(pending);
+            }
+        });
+    });
+}
+
+std::vector<SOC_U::SleepingRequest> SOC_U::GetSleepingRequests() const {
+    std::vector<SleepingRequest> requests;
+    for (const auto& pending : pending_operations) {
+        requests.emplace_back(pending->context, pending->event);
+    }
+    return requests;
+}
+
+void SOC_U::FailSleepingRequests(std::vector<SleepingRequest> requests) {
+    // Waking the threads touches guest memory, which may not be loaded yet. Completing a wait
+    // without sockets on the reactor defers the wakeup until the emulation thread runs again.
+    for (auto& [context, event] : requests) {
+        reactor->Wait({}, std::chrono::milliseconds(0), [context, event](bool) {
+            HLE::PostToEmuThread([context, event] {
+                const IPC::Header header{context->CommandBuffer()[0]};
+                LOG_WARNING(Service_SOC, "Failing blocking call 0x{:02X} after loading a savestate",
+                            header.command_id.Value());
+                IPC::RequestBuilder rb(*context, header.command_id, 1, 0);
+                rb.Push(ERR_INVALID_HANDLE);
+                event->Signal();
+            });
+        });
+    }
 }
 
-void SOC_U::PostTimerAdjust(Kernel::HLERequestContext& ctx, const std::string& caller_method) {
-    std::chrono::time_point<std::chrono::steady_clock> new_timer = std::chrono::steady_clock::now();
-    ASSERT(new_timer >= adjust_value_last);
-    ctx.SleepClientThread(
-        fmt::format("soc_u::{}", caller_method),
-        std::chrono::duration_cast<std::chrono::nanoseconds>(new_timer - adjust_value_last),
-        nullptr);
+s32 SOC_U::CloseSocket(SocketFd fd) {
+    reactor->Cancel(fd);
+    return closesocket(fd);
 }
 
 void SOC_U::CleanupSockets() {
-    for (const auto& sock : open_sockets)
-        closesocket(sock.second.socket_fd);
+    // Waiters woken up below look their socket up again, so forget about the sockets first.
+    const auto sockets = std::move(open_sockets);
     open_sockets.clear();
+    for (const auto& sock : sockets)
+        CloseSocket(sock.second.socket_fd);
 }
 
 void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
@@ -753,7 +856,8 @@ void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
     u32 socketHandle = GetNextSocketID();
 
     if ((s64)ret != SOCKET_ERROR_VALUE) {
-        open_sockets[socketHandle] = {static_cast<decltype(SocketHolder::socket_fd)>(ret), true};
+        open_sockets[socketHandle] = {static_cast<SocketFd>(ret), true};
+        SetHostSocketNonBlocking(static_cast<SocketFd>(ret));
 #if _WIN32
         // Disable UDP connection reset
         int new_behavior = 0;
@@ -856,9 +960,6 @@ void SOC_U::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x04, 2, 2);
     const auto socket_handle = rp.Pop<u32>();
     auto fd_info = open_sockets.find(socket_handle);
@@ -870,29 +971,48 @@ void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
     }
     [[maybe_unused]] const auto max_addr_len = static_cast<socklen_t>(rp.Pop<u32>());
     rp.PopPID();
-    sockaddr addr;
-    socklen_t addr_len = sizeof(addr);
-    u32 ret = static_cast<u32>(::accept(fd_info->second.socket_fd, &addr, &addr_len));
 
-    if (static_cast<s32>(ret) != SOCKET_ERROR_VALUE) {
-        u32 socketID = GetNextSocketID();
-        open_sockets[socketID] = {static_cast<decltype(SocketHolder::socket_fd)>(ret), true};
-        ret = socketID;
-    }
+    const bool may_block = GetSocketBlocking(fd_info->second);
+    auto accept = [this, socket_handle, may_block](Kernel::HLERequestContext& context, bool) {
+        auto fd_info = open_sockets.find(socket_handle);
+        if (fd_info == open_sockets.end()) {
+            IPC::RequestBuilder rb(context, 0x04, 1, 0);
+            rb.Push(ERR_INVALID_HANDLE);
+            return true;
+        }
 
-    CTRSockAddr ctr_addr;
-    std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
-    if (static_cast<s32>(ret) == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        ctr_addr = CTRSockAddr::FromPlatform(addr);
-        std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
-    }
+        sockaddr addr;
+        socklen_t addr_len = sizeof(addr);
+        u32 ret = static_cast<u32>(::accept(fd_info->second.socket_fd, &addr, &addr_len));
+        const int accept_error = (static_cast<s32>(ret) == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
+        if (static_cast<s32>(ret) == SOCKET_ERROR_VALUE && may_block && WouldBlock(accept_error)) {
+            return false;
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(ctr_addr_buf), 0);
+        if (static_cast<s32>(ret) != SOCKET_ERROR_VALUE) {
+            SetHostSocketNonBlocking(static_cast<SocketFd>(ret));
+            u32 socketID = GetNextSocketID();
+            open_sockets[socketID] = {static_cast<SocketFd>(ret), true};
+            ret = socketID;
+        }
+
+        CTRSockAddr ctr_addr;
+        std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
+        if (static_cast<s32>(ret) == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(accept_error);
+        } else {
+            ctr_addr = CTRSockAddr::FromPlatform(addr);
+            std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
+        }
+
+        IPC::RequestBuilder rb(context, 0x04, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(std::move(ctr_addr_buf), 0);
+        return true;
+    };
+    RunBlocking(ctx, "Accept", {{fd_info->second.socket_fd, true, false}},
+                std::chrono::milliseconds(-1), std::move(accept));
 }
 
 void SOC_U::GetHostId(Kernel::HLERequestContext& ctx) {
@@ -921,11 +1041,11 @@ void SOC_U::Close(Kernel::HLERequestContext& ctx) {
     }
     rp.PopPID();
 
-    s32 ret = 0;
-
-    ret = closesocket(fd_info->second.socket_fd);
+    // Forget about the socket first, guest threads waiting on it are woken up when it is closed.
+    const SocketFd socket_fd = fd_info->second.socket_fd;
+    open_sockets.erase(fd_info);
 
-    open_sockets.erase(socket_handle);
+    s32 ret = CloseSocket(socket_fd);
 
     if (ret != 0)
         ret = TranslateError(GET_ERRNO);
@@ -949,16 +1069,6 @@ void SOC_U::SendToOther(Kernel::HLERequestContext& ctx) {
     u32 flags = SendRecvFlagsToPlatform(rp.Pop<u32>());
     bool dont_wait = (flags & MSGCUSTOM_HANDLE_DONTWAIT) != 0;
     flags &= ~MSGCUSTOM_HANDLE_DONTWAIT;
-#ifdef _WIN32
-    bool was_blocking = GetSocketBlocking(fd_info->second);
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, false);
-    }
-#else
-    if (dont_wait) {
-        flags |= MSG_DONTWAIT;
-    }
-#endif // _WIN32
     const u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
     const auto dest_addr_buffer = rp.PopStaticBuffer();
@@ -968,33 +1078,39 @@ void SOC_U::SendToOther(Kernel::HLERequestContext& ctx) {
     input_mapped_buff.Read(input_buff.data(), 0,
                            std::min(input_mapped_buff.GetSize(), static_cast<size_t>(len)));
 
-    s32 ret = -1;
+    std::optional<sockaddr> dest_addr;
     if (addr_len > 0) {
         CTRSockAddr ctr_dest_addr;
         std::memcpy(&ctr_dest_addr, dest_addr_buffer.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
-        ret = ::sendto(fd_info->second.socket_fd, reinterpret_cast<const char*>(input_buff.data()),
-                       len, flags, &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(fd_info->second.socket_fd, reinterpret_cast<const char*>(input_buff.data()),
-                       len, flags, nullptr, 0);
+        dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
     }
 
-    const auto send_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
-
-#ifdef _WIN32
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, true);
-    }
-#endif
+    const bool may_block = GetSocketBlocking(fd_info->second) && !dont_wait;
+    auto send = [this, socket_handle, flags, may_block, dest_addr,
+                 input_buff = std::move(input_buff)](Kernel::HLERequestContext& context, bool) {
+        const auto fd_info = open_sockets.find(socket_handle);
+        if (fd_info == open_sockets.end()) {
+            IPC::RequestBuilder rb(context, 0x09, 1, 0);
+            rb.Push(ERR_INVALID_HANDLE);
+            return true;
+        }
 
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(send_error);
-    }
+        s32 ret = SendToPlatform(fd_info->second.socket_fd, input_buff, flags, dest_addr);
+        const auto send_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
+        if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(send_error)) {
+            return false;
+        }
+        if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(send_error);
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+        IPC::RequestBuilder rb(context, 0x09, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        return true;
+    };
+    RunBlocking(ctx, "SendToOther", {{fd_info->second.socket_fd, false, true}},
+                std::chrono::milliseconds(-1), std::move(send));
 }
 
 void SOC_U::SendTo(Kernel::HLERequestContext& ctx) {
@@ -1011,47 +1127,45 @@ void SOC_U::SendTo(Kernel::HLERequestContext& ctx) {
     u32 flags = SendRecvFlagsToPlatform(rp.Pop<u32>());
     bool dont_wait = (flags & MSGCUSTOM_HANDLE_DONTWAIT) != 0;
     flags &= ~MSGCUSTOM_HANDLE_DONTWAIT;
-#ifdef _WIN32
-    bool was_blocking = GetSocketBlocking(fd_info->second);
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, false);
-    }
-#else
-    if (dont_wait) {
-        flags |= MSG_DONTWAIT;
-    }
-#endif // _WIN32
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
     auto input_buff = rp.PopStaticBuffer();
     auto dest_addr_buff = rp.PopStaticBuffer();
+    input_buff.resize(len);
 
-    s32 ret = -1;
+    std::optional<sockaddr> dest_addr;
     if (addr_len > 0) {
         CTRSockAddr ctr_dest_addr;
         std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
-        ret = ::sendto(fd_info->second.socket_fd, reinterpret_cast<const char*>(input_buff.data()),
-                       len, flags, &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(fd_info->second.socket_fd, reinterpret_cast<const char*>(input_buff.data()),
-                       len, flags, nullptr, 0);
+        dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
     }
 
-    auto send_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
-
-#ifdef _WIN32
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, true);
-    }
-#endif
+    const bool may_block = GetSocketBlocking(fd_info->second) && !dont_wait;
+    auto send = [this, socket_handle, flags, may_block, dest_addr,
+                 input_buff = std::move(input_buff)](Kernel::HLERequestContext& context, bool) {
+        const auto fd_info = open_sockets.find(socket_handle);
+        if (fd_info == open_sockets.end()) {
+            IPC::RequestBuilder rb(context, 0x0A, 1, 0);
+            rb.Push(ERR_INVALID_HANDLE);
+            return true;
+        }
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(send_error);
+        s32 ret = SendToPlatform(fd_info->second.socket_fd, input_buff, flags, dest_addr);
+        const auto send_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
+        if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(send_error)) {
+            return false;
+        }
+        if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(send_error);
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+        IPC::RequestBuilder rb(context, 0x0A, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        return true;
+    };
+    RunBlocking(ctx, "SendTo", {{fd_info->second.socket_fd, false, true}},
+                std::chrono::milliseconds(-1), std::move(send));
 }
 
 void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
@@ -1068,69 +1182,45 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
     u32 flags = SendRecvFlagsToPlatform(rp.Pop<u32>());
     bool dont_wait = (flags & MSGCUSTOM_HANDLE_DONTWAIT) != 0;
     flags &= ~MSGCUSTOM_HANDLE_DONTWAIT;
-#ifdef _WIN32
-    bool was_blocking = GetSocketBlocking(fd_info->second);
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, false);
-    }
-#else
-    if (dont_wait) {
-        flags |= MSG_DONTWAIT;
-    }
-#endif // _WIN32
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
     auto& buffer = rp.PopMappedBuffer();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(addr_len);
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
-
-    s32 ret = -1;
-    if (GetSocketBlocking(fd_info->second) && !dont_wait) {
-        PreTimerAdjust();
-    }
+    const bool may_block = GetSocketBlocking(fd_info->second) && !dont_wait;
+    auto recv = [this, socket_handle, len, flags, addr_len, may_block,
+                 &buffer](Kernel::HLERequestContext& context, bool) {
+        const auto fd_info = open_sockets.find(socket_handle);
+        if (fd_info == open_sockets.end()) {
+            IPC::RequestBuilder rb(context, 0x7, 1, 0);
+            rb.Push(ERR_INVALID_HANDLE);
+            return true;
+        }
 
-    if (addr_len > 0) {
-        ret = ::recvfrom(fd_info->second.socket_fd, reinterpret_cast<char*>(output_buff.data()),
-                         len, flags, &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, addr_len);
+        std::vector<u8> output_buff(len);
+        std::vector<u8> addr_buff(addr_len);
+        s32 ret = RecvFromPlatform(fd_info->second.socket_fd, output_buff, flags, addr_buff);
+        const int recv_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
+        if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(recv_error)) {
+            return false;
+        }
+        if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(recv_error);
+        } else {
+            buffer.Write(output_buff.data(), 0, ret);
         }
-    } else {
-        ret = ::recvfrom(fd_info->second.socket_fd, reinterpret_cast<char*>(output_buff.data()),
-                         len, flags, NULL, 0);
-        addr_buff.resize(0);
-    }
-    int recv_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
-    if (GetSocketBlocking(fd_info->second) && !dont_wait) {
-        PostTimerAdjust(ctx, "RecvFromOther");
-    }
-#ifdef _WIN32
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, true);
-    }
-#endif
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(recv_error);
-    } else {
-        buffer.Write(output_buff.data(), 0, ret);
-    }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(addr_buff), 0);
-    rb.PushMappedBuffer(buffer);
+        IPC::RequestBuilder rb(context, 0x7, 2, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(std::move(addr_buff), 0);
+        rb.PushMappedBuffer(buffer);
+        return true;
+    };
+    RunBlocking(ctx, "RecvFromOther", {{fd_info->second.socket_fd, true, false}},
+                std::chrono::milliseconds(-1), std::move(recv));
 }
 
 void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x08, 4, 2);
     u32 socket_handle = rp.Pop<u32>();
     auto fd_info = open_sockets.find(socket_handle);
@@ -1144,66 +1234,47 @@ void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 flags = SendRecvFlagsToPlatform(rp.Pop<u32>());
     bool dont_wait = (flags & MSGCUSTOM_HANDLE_DONTWAIT) != 0;
     flags &= ~MSGCUSTOM_HANDLE_DONTWAIT;
-#ifdef _WIN32
-    bool was_blocking = GetSocketBlocking(fd_info->second);
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, false);
-    }
-#else
-    if (dont_wait) {
-        flags |= MSG_DONTWAIT;
-    }
-#endif // _WIN32
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(addr_len);
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    const bool may_block = GetSocketBlocking(fd_info->second) && !dont_wait;
+    auto recv = [this, socket_handle, len, flags, addr_len,
+                 may_block](Kernel::HLERequestContext& context, bool) {
+        const auto fd_info = open_sockets.find(socket_handle);
+        if (fd_info == open_sockets.end()) {
+            IPC::RequestBuilder rb(context, 0x08, 1, 0);
+            rb.Push(ERR_INVALID_HANDLE);
+            return true;
+        }
 
-    s32 ret = -1;
-    if (GetSocketBlocking(fd_info->second) && !dont_wait) {
-        PreTimerAdjust();
-    }
-    if (addr_len > 0) {
         // Only get src adr if input adr available
-        ret = ::recvfrom(fd_info->second.socket_fd, reinterpret_cast<char*>(output_buff.data()),
-                         len, flags, &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, addr_len);
+        std::vector<u8> output_buff(len);
+        std::vector<u8> addr_buff(addr_len);
+        s32 ret = RecvFromPlatform(fd_info->second.socket_fd, output_buff, flags, addr_buff);
+        const int recv_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
+        if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(recv_error)) {
+            return false;
         }
-    } else {
-        ret = ::recvfrom(fd_info->second.socket_fd, reinterpret_cast<char*>(output_buff.data()),
-                         len, flags, NULL, 0);
-        addr_buff.resize(0);
-    }
-    int recv_error = (ret == SOCKET_ERROR_VALUE) ? GET_ERRNO : 0;
-    if (GetSocketBlocking(fd_info->second) && !dont_wait) {
-        PostTimerAdjust(ctx, "RecvFrom");
-    }
-#ifdef _WIN32
-    if (dont_wait && was_blocking) {
-        SetSocketBlocking(fd_info->second, true);
-    }
-#endif
-    s32 total_received = ret;
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(recv_error);
-        total_received = 0;
-    }
 
-    // Write only the data we received to avoid overwriting parts of the buffer with zeros
-    output_buff.resize(total_received);
+        s32 total_received = ret;
+        if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(recv_error);
+            total_received = 0;
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(3, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.Push(total_received);
-    rb.PushStaticBuffer(std::move(output_buff), 0);
-    rb.PushStaticBuffer(std::move(addr_buff), 1);
+        // Write only the data we received to avoid overwriting parts of the buffer with zeros
+        output_buff.resize(total_received);
+
+        IPC::RequestBuilder rb(context, 0x08, 3, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.Push(total_received);
+        rb.PushStaticBuffer(std::move(output_buff), 0);
+        rb.PushStaticBuffer(std::move(addr_buff), 1);
+        return true;
+    };
+    RunBlocking(ctx, "RecvFrom", {{fd_info->second.socket_fd, true, false}},
+                std::chrono::milliseconds(-1), std::move(recv));
 }
 
 void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
@@ -1221,37 +1292,50 @@ void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
     // so we have to copy the data in order
     std::vector<pollfd> platform_pollfd(nfds);
     std::vector<u8> has_libctru_bug(nfds, false);
+    std::vector<SocketWatch> watches;
     for (u32 i = 0; i < nfds; i++) {
         platform_pollfd[i] = CTRPollFD::ToPlatform(*this, ctr_fds[i], has_libctru_bug[i]);
+        if (open_sockets.contains(ctr_fds[i].fd)) {
+            const auto events = platform_pollfd[i].events;
+            watches.push_back({
+                .fd = static_cast<SocketFd>(platform_pollfd[i].fd),
+                .read = (events & (POLLIN | POLLPRI | POLLRDNORM | POLLRDBAND)) != 0,
+                .write = (events & (POLLOUT | POLLWRNORM | POLLWRBAND)) != 0,
+            });
+        }
     }
 
-    if (timeout) {
-        PreTimerAdjust();
-    }
-    s32 ret = ::poll(platform_pollfd.data(), nfds, timeout);
-    if (timeout) {
-        PostTimerAdjust(ctx, "Poll");
-    }
+    auto poll_sockets = [this, ctr_fds, platform_pollfd, has_libctru_bug, nfds,
+                         timeout](Kernel::HLERequestContext& context, bool timed_out) mutable {
+        // The reactor did the waiting, so only check the current state of the sockets here.
+        s32 ret = ::poll(platform_pollfd.data(), nfds, 0);
+        if (ret == 0 && timeout != 0 && !timed_out) {
+            return false;
+        }
 
-    // Now update the output 3ds_pollfd structure
-    for (u32 i = 0; i < nfds; i++) {
-        ctr_fds[i] = CTRPollFD::FromPlatform(*this, platform_pollfd[i], has_libctru_bug[i]);
-    }
+        // Now update the output 3ds_pollfd structure
+        for (u32 i = 0; i < nfds; i++) {
+            ctr_fds[i] = CTRPollFD::FromPlatform(*this, platform_pollfd[i], has_libctru_bug[i]);
+        }
 
-    std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
-    std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+        std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
+        std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
 
-    if (ret == SOCKET_ERROR_VALUE) {
-        int err = GET_ERRNO;
-        LOG_ERROR(Service_SOC, "Socket error: {}", err);
+        if (ret == SOCKET_ERROR_VALUE) {
+            int err = GET_ERRNO;
+            LOG_ERROR(Service_SOC, "Socket error: {}", err);
 
-        ret = TranslateError(GET_ERRNO);
-    }
+            ret = TranslateError(err);
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(output_fds), 0);
+        IPC::RequestBuilder rb(context, 0x14, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(std::move(output_fds), 0);
+        return true;
+    };
+    RunBlocking(ctx, "Poll", std::move(watches), std::chrono::milliseconds(timeout),
+                std::move(poll_sockets));
 }
 
 void SOC_U::GetSockName(Kernel::HLERequestContext& ctx) {
@@ -1381,9 +1465,6 @@ void SOC_U::GetPeerName(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x06, 2, 4);
     const auto socket_handle = rp.Pop<u32>();
     auto fd_info = open_sockets.find(socket_handle);
@@ -1401,15 +1482,43 @@ void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
     std::memcpy(&ctr_input_addr, input_addr_buf.data(), sizeof(ctr_input_addr));
 
     sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
-    if (GetSocketBlocking(fd_info->second)) {
-        PreTimerAdjust();
-    }
     s32 ret = ::connect(fd_info->second.socket_fd, &input_addr, sizeof(input_addr));
-    if (GetSocketBlocking(fd_info->second)) {
-        PostTimerAdjust(ctx, "Connect");
+    const int connect_error = (ret != 0) ? GET_ERRNO : 0;
+    if (ret != 0 && GetSocketBlocking(fd_info->second) && WouldBlock(connect_error)) {
+        // The connection is established in the background, the socket becomes writable once it
+        // either succeeded or failed.
+        auto finish_connect = [this, socket_handle](Kernel::HLERequestContext& context, bool) {
+            const auto fd_info = open_sockets.find(socket_handle);
+            if (fd_info == open_sockets.end()) {
+                IPC::RequestBuilder rb(context, 0x06, 1, 0);
+                rb.Push(ERR_INVALID_HANDLE);
+                return true;
+            }
+
+            pollfd pending{};
+            pending.fd = fd_info->second.socket_fd;
+            pending.events = POLLOUT;
+            const int ready = ::poll(&pending, 1, 0);
+            if (ready == 0) {
+                return false;
+            }
+
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            ::getsockopt(fd_info->second.socket_fd, SOL_SOCKET, SO_ERROR,
+                         reinterpret_cast<char*>(&error), &error_len);
+
+            IPC::RequestBuilder rb(context, 0x06, 2, 0);
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(error != 0 ? TranslateError(error) : 0);
+            return true;
+        };
+        RunBlocking(ctx, "Connect", {{fd_info->second.socket_fd, false, true}},
+                    std::chrono::milliseconds(-1), std::move(finish_connect));
+        return;
     }
     if (ret != 0)
-        ret = TranslateError(GET_ERRNO);
+        ret = TranslateError(connect_error);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
@@ -1719,6 +1828,8 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
 #endif
+
+    reactor = std::make_unique<SocketReactor>();
 }
 
 SOC_U::~SOC_U() {
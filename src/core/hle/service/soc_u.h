@@ -4,28 +4,39 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+#include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/unordered_map.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
+#include "core/hle/service/soc_reactor.h"
 
 namespace Core {
 class System;
 }
 
+namespace Kernel {
+class Event;
+}
+
 namespace Service::SOC {
 
 /// Holds information about a particular socket
 struct SocketHolder {
-#ifdef _WIN32
-    using SOCKET = unsigned long long;
-    SOCKET socket_fd; ///< The socket descriptor
-#else
-    int socket_fd; ///< The socket descriptor
-#endif // _WIN32
+    SocketFd socket_fd; ///< The socket descriptor
 
-    bool blocking = true; ///< Whether the socket is blocking or not.
+    /// Whether the guest considers the socket blocking. The host socket is always non-blocking,
+    /// blocking guest calls wait on the SocketReactor instead.
+    bool blocking = true;
 
 private:
     template <class Archive>
@@ -129,14 +140,47 @@ private:
         return next_socket_id++;
     }
 
-    // System timer adjust
-    std::chrono::time_point<std::chrono::steady_clock> adjust_value_last;
-    void PreTimerAdjust();
-    void PostTimerAdjust(Kernel::HLERequestContext& ctx, const std::string& caller_method);
+    /**
+     * A socket call that may have to wait for the socket. It receives whether the wait timed out
+     * and returns false if the call would still block, otherwise it must have written the entire
+     * response.
+     */
+    using BlockingOperation = std::function<bool(Kernel::HLERequestContext& ctx, bool timed_out)>;
+    struct PendingOperation;
+
+    /**
+     * Runs a socket call without blocking the emulation thread. If the call would block, the guest
+     * thread is put to sleep and the call is retried on the emulation thread every time the reactor
+     * reports one of the watched sockets as ready, until it completes or the timeout expires.
+     * @param timeout Timeout of the wait, negative to wait forever.
+     */
+    void RunBlocking(Kernel::HLERequestContext& ctx, const std::string& reason,
+                     std::vector<SocketWatch> watches, std::chrono::milliseconds timeout,
+                     BlockingOperation operation);
+    void WaitForRetry(std::shared_ptr<PendingOperation> pending);
+
+    /// Request of a guest thread sleeping in RunBlocking and the event that wakes it up
+    using SleepingRequest =
+        std::pair<std::shared_ptr<Kernel::HLERequestContext>, std::shared_ptr<Kernel::Event>>;
+
+    /**
+     * Wakes up guest threads that were sleeping in RunBlocking when a savestate was made. Their
+     * host sockets don't exist anymore, so they fail as if the sockets were closed.
+     */
+    void FailSleepingRequests(std::vector<SleepingRequest> requests);
+    std::vector<SleepingRequest> GetSleepingRequests() const;
+
+    /// Closes a host socket, waking up the guest threads waiting on it.
+    s32 CloseSocket(SocketFd fd);
 
     /// Close all open sockets
     void CleanupSockets();
 
+    std::unique_ptr<SocketReactor> reactor;
+
+    /// Calls waiting on the reactor, their guest threads sleep until they complete
+    std::vector<std::shared_ptr<PendingOperation>> pending_operations;
+
     /// Holds info about the currently open sockets
     friend struct CTRPollFD;
     std::unordered_map<u32, SocketHolder> open_sockets;
@@ -149,9 +193,20 @@ private:
     InterfaceInfo interface_info;
 
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int) {
+    void serialize(Archive& ar, const unsigned int file_version) {
         ar& boost::serialization::base_object<Kernel::SessionRequestHandler>(*this);
         ar& open_sockets;
+        if (file_version > 0) {
+            // The pending operations can't be saved, only what is needed to wake their threads
+            std::vector<SleepingRequest> sleeping_requests;
+            if (Archive::is_saving::value) {
+                sleeping_requests = GetSleepingRequests();
+            }
+            ar& sleeping_requests;
+            if (Archive::is_loading::value) {
+                FailSleepingRequests(std::move(sleeping_requests));
+            }
+        }
     }
     friend class boost::serialization::access;
 };
@@ -163,3 +218,4 @@ void InstallInterfaces(Core::System& system);
 } // namespace Service::SOC
 
 BOOST_CLASS_EXPORT_KEY(Service::SOC::SOC_U)
+BOOST_CLASS_VERSION(Service::SOC::SOC_U, 1)
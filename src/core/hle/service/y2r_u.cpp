@@ -2,11 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <thread>
 #include "common/archives.h"
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
@@ -521,7 +524,7 @@ void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
     Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
                                          Memory::FlushMode::FlushAndInvalidate);
 
-    HW::Y2R::PerformConversion(system.Memory(), conversion);
+    HW::Y2R::PerformConversion(system.Memory(), conversion, conversion_workers.get());
 
     completion_event->Signal();
 
@@ -698,6 +701,11 @@ Y2R_U::Y2R_U(Core::System& system) : ServiceFramework("y2r:u", 1), system(system
     RegisterHandlers(functions);
 
     completion_event = system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "Y2R:Completed");
+
+    // Video frames only have a few dozen strips, more workers than this would mostly idle
+    const std::size_t num_workers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
+    conversion_workers = std::make_unique<Common::ThreadWorker>(num_workers, "Y2R");
 }
 
 Y2R_U::~Y2R_U() = default;
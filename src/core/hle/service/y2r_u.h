@@ -12,6 +12,12 @@
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
 
+namespace Common {
+template <class StateType>
+class StatefulThreadWorker;
+using ThreadWorker = StatefulThreadWorker<void>;
+} // namespace Common
+
 namespace Core {
 class System;
 }
@@ -355,6 +361,9 @@ private:
     bool transfer_end_interrupt_enabled = false;
     bool spacial_dithering_enabled = false;
 
+    /// Converts the strips of large images concurrently
+    std::unique_ptr<Common::ThreadWorker> conversion_workers;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int);
     friend class boost::serialization::access;
@@ -10,6 +10,7 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/perf_sections.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -470,6 +471,7 @@ inline void Write(u32 addr, const T data) {
         if (config.trigger & 1) {
             MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
+            Common::ScopedPerfSection section{Common::PerfSection::GPU};
             Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
 
             g_regs.command_processor_config.trigger = 0;
@@ -504,7 +506,10 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(std::uintptr_t user_data, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    {
+        Common::ScopedPerfSection section{Common::PerfSection::Present};
+        VideoCore::g_renderer->SwapBuffers();
+    }
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -5,10 +5,12 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/thread_worker.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/hle/service/y2r_u.h"
@@ -23,55 +25,83 @@ static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
+/// Decodes the YUV components of a line of an image strip into separate arrays.
+static void DecodeLine(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                       const u8* input_V, unsigned int y, unsigned int width, s32* Y, s32* U,
+                       s32* V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        for (unsigned int x = 0; x < width; ++x) {
+            Y[x] = input_Y[y * width + x];
+            U[x] = input_U[(y * width + x) / 2];
+            V[x] = input_V[(y * width + x) / 2];
+        }
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        for (unsigned int x = 0; x < width; ++x) {
+            Y[x] = input_Y[y * width + x];
+            U[x] = input_U[((y / 2) * width + x) / 2];
+            V[x] = input_V[((y / 2) * width + x) / 2];
+        }
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        for (unsigned int x = 0; x < width; ++x) {
+            Y[x] = input_Y[(y * width + x) * 2];
+            U[x] = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+            V[x] = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+        }
+        break;
+    }
+}
+
+/**
+ * Converts a line of YUV components to RGB32. The loop is kept free of branches and of
+ * dependencies between pixels so that the compiler can vectorize it.
+ */
+static void ConvertLine(const s32* Y, const s32* U, const s32* V, u32* output,
+                        unsigned int width, const CoefficientSet& coefficients) {
+    // This conversion process is bit-exact with hardware, as far as could be tested.
+    const s32 c0 = coefficients[0];
+    const s32 c1 = coefficients[1];
+    const s32 c2 = coefficients[2];
+    const s32 c3 = coefficients[3];
+    const s32 c4 = coefficients[4];
+    const s32 rounding_offset = 0x18;
+    const s32 r_offset = coefficients[5] + rounding_offset;
+    const s32 g_offset = coefficients[6] + rounding_offset;
+    const s32 b_offset = coefficients[7] + rounding_offset;
+
+    for (unsigned int x = 0; x < width; ++x) {
+        const s32 cY = c0 * Y[x];
+
+        const s32 r = ((cY + c1 * V[x]) >> 3) + r_offset;
+        const s32 g = ((cY - c2 * V[x] - c3 * U[x]) >> 3) + g_offset;
+        const s32 b = ((cY + c4 * U[x]) >> 3) + b_offset;
+
+        output[x] = (static_cast<u32>(std::clamp(r >> 5, 0, 0xFF)) << 24) |
+                    (static_cast<u32>(std::clamp(g >> 5, 0, 0xFF)) << 16) |
+                    (static_cast<u32>(std::clamp(b >> 5, 0, 0xFF)) << 8);
+    }
+}
+
 /// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
 static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
                             const u8* input_V, ImageTile output[], unsigned int width,
                             unsigned int height, const CoefficientSet& coefficients) {
+    std::array<s32, MAX_TILES * 8> Y;
+    std::array<s32, MAX_TILES * 8> U;
+    std::array<s32, MAX_TILES * 8> V;
+    std::array<u32, MAX_TILES * 8> line;
 
     for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+        DecodeLine(input_format, input_Y, input_U, input_V, y, width, Y.data(), U.data(),
+                   V.data());
+        ConvertLine(Y.data(), U.data(), V.data(), line.data(), width, coefficients);
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+        for (unsigned int tile = 0; tile < width / 8; ++tile) {
+            std::memcpy(&output[tile][y * 8], &line[tile * 8], 8 * sizeof(u32));
         }
     }
 }
@@ -102,8 +132,9 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
 
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
+template <OutputFormat output_format>
 static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
-                     int amount_of_data, OutputFormat output_format, u8 alpha) {
+                     int amount_of_data, u8 alpha) {
 
     u8* output = memory.GetPointer(buf.address);
 
@@ -113,23 +144,18 @@ static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionB
             u32 color = *input++;
             Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
 
-            switch (output_format) {
-            case OutputFormat::RGBA8:
+            if constexpr (output_format == OutputFormat::RGBA8) {
                 Common::Color::EncodeRGBA8(col_vec, output);
                 output += 4;
-                break;
-            case OutputFormat::RGB8:
+            } else if constexpr (output_format == OutputFormat::RGB8) {
                 Common::Color::EncodeRGB8(col_vec, output);
                 output += 3;
-                break;
-            case OutputFormat::RGB5A1:
+            } else if constexpr (output_format == OutputFormat::RGB5A1) {
                 Common::Color::EncodeRGB5A1(col_vec, output);
                 output += 2;
-                break;
-            case OutputFormat::RGB565:
+            } else if constexpr (output_format == OutputFormat::RGB565) {
                 Common::Color::EncodeRGB565(col_vec, output);
                 output += 2;
-                break;
             }
 
             amount_of_data -= 1;
@@ -141,6 +167,24 @@ static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionB
     }
 }
 
+static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
+                     int amount_of_data, OutputFormat output_format, u8 alpha) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        SendData<OutputFormat::RGBA8>(memory, input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB8:
+        SendData<OutputFormat::RGB8>(memory, input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB5A1:
+        SendData<OutputFormat::RGB5A1>(memory, input, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB565:
+        SendData<OutputFormat::RGB565>(memory, input, buf, amount_of_data, alpha);
+        break;
+    }
+}
+
 static const u8 linear_lut[TILE_SIZE] = {
     // clang-format off
      0,  1,  2,  3,  4,  5,  6,  7,
@@ -210,6 +254,119 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
     }
 }
 
+/// Receives the input data of a strip of row_height lines into the strip buffer.
+static void ReceiveStrip(Memory::MemorySystem& memory, ConversionConfiguration& cvt,
+                         u8* strip_buffer, unsigned int row_height) {
+    // Total size in pixels of incoming data required for this strip.
+    const std::size_t row_data_size = row_height * cvt.input_line_width;
+
+    u8* input_Y = strip_buffer;
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    }
+}
+
+/**
+ * Converts the received input of a strip to RGB32, rotating and swizzling it as configured. The
+ * result overwrites the input in the strip buffer.
+ */
+static void ConvertStrip(const ConversionConfiguration& cvt, u8* strip_buffer, ImageTile tiles[],
+                         unsigned int row_height) {
+    const std::size_t num_tiles = cvt.input_line_width / 8;
+    ImageTile tmp_tile;
+
+    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
+    // requiring two different code paths.
+    const u8* tile_remap = nullptr;
+    switch (cvt.block_alignment) {
+    case BlockAlignment::Linear:
+        tile_remap = linear_lut;
+        break;
+    case BlockAlignment::Block8x8:
+        tile_remap = morton_lut;
+        break;
+    }
+
+    const u8* input_Y = strip_buffer;
+    const u8* input_U = input_Y + 8 * cvt.input_line_width;
+    const u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+    if (cvt.input_format == InputFormat::YUYV422_Interleaved) {
+        input_U = nullptr;
+        input_V = nullptr;
+    }
+
+    ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles, cvt.input_line_width,
+                    row_height, cvt.coefficients);
+
+    u32* output_buffer = reinterpret_cast<u32*>(strip_buffer);
+
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+        int image_strip_width = 0;
+        int output_stride = 0;
+
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        case Rotation::Clockwise_180:
+            // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
+            // since the rotates are done individually on each tile.
+            RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_270:
+            RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+            output_buffer += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+            output_buffer += TILE_SIZE;
+            break;
+        }
+    }
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -259,122 +416,60 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  *
  * Hardware behaves strangely (doesn't fire the completion interrupt, for example) in these cases,
  * so they are believed to be invalid configurations anyway.
+ *
+ * When workers are given, the strips are converted concurrently once all input has been received.
  */
-void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
+void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt,
+                       Common::ThreadWorker* workers) {
     ASSERT(cvt.input_line_width % 8 == 0);
     ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
     // Tiles per row
     std::size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
-    std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
-        break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
-        break;
-    }
-
-    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
-        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
+    // Buffers used as CDMA source/target, one per strip. The CDMA transfers update the buffer
+    // configurations as they go, so they are simulated in order, but once the input of every
+    // strip has been received the strips can be converted independently.
+    const std::size_t num_strips = (cvt.input_lines + 7) / 8;
+    const std::size_t strip_buffer_size = cvt.input_line_width * 8 * 4;
+    std::unique_ptr<u8[]> data_buffer(new u8[strip_buffer_size * num_strips]);
 
-        // Total size in pixels of incoming data required for this strip.
-        const std::size_t row_data_size = row_height * cvt.input_line_width;
+    const auto get_row_height = [&cvt](std::size_t strip) {
+        return std::min(cvt.input_lines - static_cast<unsigned int>(strip) * 8, 8u);
+    };
 
-        u8* input_Y = data_buffer.get();
-        u8* input_U = input_Y + 8 * cvt.input_line_width;
-        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+    for (std::size_t strip = 0; strip < num_strips; ++strip) {
+        ReceiveStrip(memory, cvt, data_buffer.get() + strip * strip_buffer_size,
+                     get_row_height(strip));
+    }
 
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
-            break;
+    const auto convert_strips = [&](std::size_t begin, std::size_t end) {
+        // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
+        std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
+        for (std::size_t strip = begin; strip < end; ++strip) {
+            ConvertStrip(cvt, data_buffer.get() + strip * strip_buffer_size, tiles.get(),
+                         get_row_height(strip));
         }
-
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (std::size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            }
-
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+    };
+
+    if (workers && num_strips > 1) {
+        const std::size_t num_workers = workers->NumWorkers();
+        const std::size_t chunk_size = (num_strips + num_workers - 1) / num_workers;
+        for (std::size_t begin = 0; begin < num_strips; begin += chunk_size) {
+            const std::size_t end = std::min(begin + chunk_size, num_strips);
+            workers->QueueWork([&convert_strips, begin, end] { convert_strips(begin, end); });
         }
+        workers->WaitForRequests();
+    } else {
+        convert_strips(0, num_strips);
+    }
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+    for (std::size_t strip = 0; strip < num_strips; ++strip) {
+        // Total size in pixels of outgoing data for this strip.
+        const std::size_t row_data_size = get_row_height(strip) * cvt.input_line_width;
+        SendData(memory,
+                 reinterpret_cast<const u32*>(data_buffer.get() + strip * strip_buffer_size),
+                 cvt.dst, (int)row_data_size, cvt.output_format, (u8)cvt.alpha);
     }
 }
 } // namespace HW::Y2R
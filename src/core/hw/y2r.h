@@ -4,6 +4,12 @@
 
 #pragma once
 
+namespace Common {
+template <class StateType>
+class StatefulThreadWorker;
+using ThreadWorker = StatefulThreadWorker<void>;
+} // namespace Common
+
 namespace Memory {
 class MemorySystem;
 }
@@ -13,5 +19,10 @@ struct ConversionConfiguration;
 } // namespace Service::Y2R
 
 namespace HW::Y2R {
-void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt);
+/**
+ * Performs a Y2R conversion, see the implementation for details.
+ * @param workers Optional thread pool used to convert the image strips concurrently
+ */
+void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt,
+                       Common::ThreadWorker* workers = nullptr);
 } // namespace HW::Y2R
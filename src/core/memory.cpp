@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
@@ -19,7 +20,6 @@
 #include "core/global.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
-#include "core/hle/lock.h"
 #include "core/hle/service/plgldr/plgldr.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
@@ -87,6 +87,61 @@ private:
     }
 };
 
+/// Bitmap of the FCRAM and VRAM pages written to since they were last marked as clean
+class DirtyPageTracker {
+public:
+    void Mark(PAddr start, std::size_t size) {
+        const PAddr end = start + static_cast<PAddr>(size);
+        for (PAddr page = start & ~CITRA_PAGE_MASK; page < end; page += CITRA_PAGE_SIZE) {
+            std::atomic<u64>* bits = At(page);
+            if (!bits) {
+                continue;
+            }
+            // Avoid dirtying the cache line when the page is already marked
+            const u64 mask = Mask(page);
+            if ((bits->load(std::memory_order_relaxed) & mask) == 0) {
+                bits->fetch_or(mask, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TestAndClear(PAddr page) {
+        std::atomic<u64>* bits = At(page);
+        if (!bits) {
+            return false;
+        }
+        const u64 mask = Mask(page);
+        return (bits->fetch_and(~mask, std::memory_order_relaxed) & mask) != 0;
+    }
+
+    void Reset() {
+        for (auto& bits : fcram) {
+            bits.store(0, std::memory_order_relaxed);
+        }
+        for (auto& bits : vram) {
+            bits.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<u64>* At(PAddr addr) {
+        if (addr >= FCRAM_PADDR && addr < FCRAM_N3DS_PADDR_END) {
+            return &fcram[(addr - FCRAM_PADDR) / CITRA_PAGE_SIZE / 64];
+        }
+        if (addr >= VRAM_PADDR && addr < VRAM_PADDR_END) {
+            return &vram[(addr - VRAM_PADDR) / CITRA_PAGE_SIZE / 64];
+        }
+        return nullptr;
+    }
+
+    static u64 Mask(PAddr addr) {
+        return u64{1} << ((addr / CITRA_PAGE_SIZE) % 64);
+    }
+
+    std::array<std::atomic<u64>, FCRAM_N3DS_SIZE / CITRA_PAGE_SIZE / 64> fcram{};
+    std::array<std::atomic<u64>, VRAM_SIZE / CITRA_PAGE_SIZE / 64> vram{};
+};
+
 class MemorySystem::Impl {
 public:
     // Visual Studio would try to allocate these on compile time if they are std::array, which would
@@ -99,6 +154,10 @@ public:
     RasterizerCacheMarker cache_marker;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
+    // Enabled and queried from other threads than the one writing memory.
+    std::atomic<bool> dirty_tracking{false};
+    DirtyPageTracker dirty_pages;
+
     AudioCore::DspInterface* dsp = nullptr;
 
     std::shared_ptr<BackingMem> fcram_mem;
@@ -138,6 +197,18 @@ public:
         }
     }
 
+    /// Marks the pages backing a host pointer as dirty, if it points into FCRAM or VRAM
+    void MarkDirty(const u8* pointer, std::size_t size) {
+        if (!dirty_tracking.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (pointer >= fcram.get() && pointer < fcram.get() + FCRAM_N3DS_SIZE) {
+            dirty_pages.Mark(FCRAM_PADDR + static_cast<PAddr>(pointer - fcram.get()), size);
+        } else if (pointer >= vram.get() && pointer < vram.get() + VRAM_SIZE) {
+            dirty_pages.Mark(VRAM_PADDR + static_cast<PAddr>(pointer - vram.get()), size);
+        }
+    }
+
     u32 GetSize(Region r) const {
         switch (r) {
         case Region::VRAM:
@@ -167,76 +238,115 @@ public:
         return nullptr; // Should never happen
     }
 
-    template <bool UNSAFE>
-    void ReadBlockImpl(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
-                       const std::size_t size) {
-        auto& page_table = *process.vm_manager.page_table;
+    /// Returns the host pointer backing a page, or nullptr if it isn't backed by memory
+    u8* GetPageHostPointer(PageTable& page_table, std::size_t page_index) const {
+        switch (page_table.attributes[page_index]) {
+        case PageType::Memory:
+            return page_table.GetPointerArray()[page_index];
+        case PageType::RasterizerCachedMemory:
+            return GetPointerForRasterizerCache(static_cast<VAddr>(page_index << CITRA_PAGE_BITS))
+                .GetPtr();
+        default:
+            return nullptr;
+        }
+    }
 
+    /**
+     * Splits the virtual range into runs of consecutive pages with the same type and calls
+     * `func(type, vaddr, host_pointer, size)` once per run. Memory-backed pages are only merged
+     * while their host memory is contiguous, so each run can be handled with a single memcpy.
+     * Special pages are never merged since they may belong to different MMIO regions.
+     */
+    template <typename Func>
+    void ForEachRun(PageTable& page_table, const VAddr start, const std::size_t size,
+                    Func&& func) const {
         std::size_t remaining_size = size;
-        std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
-        std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
+        std::size_t page_index = start >> CITRA_PAGE_BITS;
+        std::size_t page_offset = start & CITRA_PAGE_MASK;
 
         while (remaining_size > 0) {
-            const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-            const VAddr current_vaddr =
+            const PageType type = page_table.attributes[page_index];
+            const VAddr run_vaddr =
                 static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
+            u8* run_pointer = GetPageHostPointer(page_table, page_index);
+            if (run_pointer) {
+                run_pointer += page_offset;
+            }
+            DEBUG_ASSERT(type != PageType::Memory || run_pointer);
+
+            std::size_t run_size = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
+            remaining_size -= run_size;
+            page_index++;
+
+            while (type != PageType::Special && remaining_size > 0 &&
+                   page_table.attributes[page_index] == type) {
+                if (run_pointer &&
+                    GetPageHostPointer(page_table, page_index) != run_pointer + run_size) {
+                    break;
+                }
+                const std::size_t amount = std::min<std::size_t>(CITRA_PAGE_SIZE, remaining_size);
+                run_size += amount;
+                remaining_size -= amount;
+                page_index++;
+            }
+
+            func(type, run_vaddr, run_pointer, run_size);
+            page_offset = 0;
+        }
+    }
+
+    template <bool UNSAFE>
+    void ReadBlockImpl(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
+                       const std::size_t size) {
+        auto& page_table = *process.vm_manager.page_table;
+        u8* dest = static_cast<u8*>(dest_buffer);
 
-            switch (page_table.attributes[page_index]) {
+        ForEachRun(page_table, src_addr, size, [&](PageType type, VAddr current_vaddr,
+                                                   const u8* src_ptr, std::size_t amount) {
+            switch (type) {
             case PageType::Unmapped: {
                 LOG_ERROR(
                     HW_Memory,
                     "unmapped ReadBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
                     "0x{:08X}",
                     current_vaddr, src_addr, size, Core::GetRunningCore().GetPC());
-                std::memset(dest_buffer, 0, copy_amount);
+                std::memset(dest, 0, amount);
                 break;
             }
             case PageType::Memory: {
-                DEBUG_ASSERT(page_table.pointers[page_index]);
-
-                const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-                std::memcpy(dest_buffer, src_ptr, copy_amount);
+                std::memcpy(dest, src_ptr, amount);
                 break;
             }
             case PageType::Special: {
                 MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
                 DEBUG_ASSERT(handler);
-                handler->ReadBlock(current_vaddr, dest_buffer, copy_amount);
+                handler->ReadBlock(current_vaddr, dest, amount);
                 break;
             }
             case PageType::RasterizerCachedMemory: {
                 if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(amount),
                                                  FlushMode::Flush);
                 }
-                std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
+                std::memcpy(dest, src_ptr, amount);
                 break;
             }
             default:
                 UNREACHABLE();
             }
-
-            page_index++;
-            page_offset = 0;
-            dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
-            remaining_size -= copy_amount;
-        }
+            dest += amount;
+        });
     }
 
     template <bool UNSAFE>
     void WriteBlockImpl(const Kernel::Process& process, const VAddr dest_addr,
                         const void* src_buffer, const std::size_t size) {
         auto& page_table = *process.vm_manager.page_table;
-        std::size_t remaining_size = size;
-        std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
-        std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
+        const u8* src = static_cast<const u8*>(src_buffer);
 
-        while (remaining_size > 0) {
-            const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-            const VAddr current_vaddr =
-                static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
-
-            switch (page_table.attributes[page_index]) {
+        ForEachRun(page_table, dest_addr, size, [&](PageType type, VAddr current_vaddr,
+                                                    u8* dest_ptr, std::size_t amount) {
+            switch (type) {
             case PageType::Unmapped: {
                 LOG_ERROR(
                     HW_Memory,
@@ -246,35 +356,30 @@ public:
                 break;
             }
             case PageType::Memory: {
-                DEBUG_ASSERT(page_table.pointers[page_index]);
-
-                u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-                std::memcpy(dest_ptr, src_buffer, copy_amount);
+                std::memcpy(dest_ptr, src, amount);
+                MarkDirty(dest_ptr, amount);
                 break;
             }
             case PageType::Special: {
                 MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
                 DEBUG_ASSERT(handler);
-                handler->WriteBlock(current_vaddr, src_buffer, copy_amount);
+                handler->WriteBlock(current_vaddr, src, amount);
                 break;
             }
             case PageType::RasterizerCachedMemory: {
                 if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(amount),
                                                  FlushMode::Invalidate);
                 }
-                std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
+                std::memcpy(dest_ptr, src, amount);
+                MarkDirty(dest_ptr, amount);
                 break;
             }
             default:
                 UNREACHABLE();
             }
-
-            page_index++;
-            page_offset = 0;
-            src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
-            remaining_size -= copy_amount;
-        }
+            src += amount;
+        });
     }
 
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const {
@@ -495,8 +600,10 @@ template <typename T>
 void MemorySystem::Write(const VAddr vaddr, const T data) {
     u8* page_pointer = impl->current_page_table->pointers[vaddr >> CITRA_PAGE_BITS];
     if (page_pointer) {
-        // NOTE: Avoid adding any extra logic to this fast-path block
+        // NOTE: Avoid adding any extra logic to this fast-path block. MarkDirty is a single
+        // branch while dirty tracking is disabled.
         std::memcpy(&page_pointer[vaddr & CITRA_PAGE_MASK], &data, sizeof(T));
+        impl->MarkDirty(&page_pointer[vaddr & CITRA_PAGE_MASK], sizeof(T));
         return;
     }
 
@@ -505,7 +612,9 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
     if (vaddr & (1 << 31)) {
         PAddr paddr = (vaddr & ~(1 << 31));
         if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
-            std::memcpy(GetFCRAMPointer(paddr - Memory::FCRAM_PADDR), &data, sizeof(T));
+            u8* dest_ptr = GetFCRAMPointer(paddr - Memory::FCRAM_PADDR);
+            std::memcpy(dest_ptr, &data, sizeof(T));
+            impl->MarkDirty(dest_ptr, sizeof(T));
             return;
         } else if ((paddr & 0xF0000000) == 0x10000000 &&
                    paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
@@ -525,7 +634,9 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         break;
     case PageType::RasterizerCachedMemory: {
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
+        u8* dest_ptr = GetPointerForRasterizerCache(vaddr);
+        std::memcpy(dest_ptr, &data, sizeof(T));
+        impl->MarkDirty(dest_ptr, sizeof(T));
         break;
     }
     case PageType::Special:
@@ -541,9 +652,13 @@ bool MemorySystem::WriteExclusive(const VAddr vaddr, const T data, const T expec
     u8* page_pointer = impl->current_page_table->pointers[vaddr >> CITRA_PAGE_BITS];
 
     if (page_pointer) {
-        const auto volatile_pointer =
-            reinterpret_cast<volatile T*>(&page_pointer[vaddr & CITRA_PAGE_MASK]);
-        return Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
+        u8* dest_ptr = &page_pointer[vaddr & CITRA_PAGE_MASK];
+        const auto volatile_pointer = reinterpret_cast<volatile T*>(dest_ptr);
+        const bool success = Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
+        if (success) {
+            impl->MarkDirty(dest_ptr, sizeof(T));
+        }
+        return success;
     }
 
     PageType type = impl->current_page_table->attributes[vaddr >> CITRA_PAGE_BITS];
@@ -557,9 +672,13 @@ bool MemorySystem::WriteExclusive(const VAddr vaddr, const T data, const T expec
         return true;
     case PageType::RasterizerCachedMemory: {
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        const auto volatile_pointer =
-            reinterpret_cast<volatile T*>(GetPointerForRasterizerCache(vaddr).GetPtr());
-        return Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
+        u8* dest_ptr = GetPointerForRasterizerCache(vaddr);
+        const auto volatile_pointer = reinterpret_cast<volatile T*>(dest_ptr);
+        const bool success = Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
+        if (success) {
+            impl->MarkDirty(dest_ptr, sizeof(T));
+        }
+        return success;
     }
     case PageType::Special:
         WriteMMIO<T>(impl->GetMMIOHandler(*impl->current_page_table, vaddr), vaddr, data);
@@ -918,18 +1037,12 @@ void MemorySystem::WriteBlock(const VAddr dest_addr, const void* src_buffer,
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
     auto& page_table = *process.vm_manager.page_table;
-    std::size_t remaining_size = size;
-    std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
-    std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
 
     static const std::array<u8, CITRA_PAGE_SIZE> zeros = {};
 
-    while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr =
-            static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
-
-        switch (page_table.attributes[page_index]) {
+    impl->ForEachRun(page_table, dest_addr, size, [&](PageType type, VAddr current_vaddr,
+                                                      u8* dest_ptr, std::size_t amount) {
+        switch (type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "unmapped ZeroBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
@@ -938,32 +1051,27 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memset(dest_ptr, 0, copy_amount);
+            std::memset(dest_ptr, 0, amount);
+            impl->MarkDirty(dest_ptr, amount);
             break;
         }
         case PageType::Special: {
             MMIORegionPointer handler = impl->GetMMIOHandler(page_table, current_vaddr);
             DEBUG_ASSERT(handler);
-            handler->WriteBlock(current_vaddr, zeros.data(), copy_amount);
+            handler->WriteBlock(current_vaddr, zeros.data(), amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(amount),
                                          FlushMode::Invalidate);
-            std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
+            std::memset(dest_ptr, 0, amount);
+            impl->MarkDirty(dest_ptr, amount);
             break;
         }
         default:
             UNREACHABLE();
         }
-
-        page_index++;
-        page_offset = 0;
-        remaining_size -= copy_amount;
-    }
+    });
 }
 
 void MemorySystem::CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
@@ -975,55 +1083,41 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
                              const Kernel::Process& src_process, VAddr dest_addr, VAddr src_addr,
                              std::size_t size) {
     auto& page_table = *src_process.vm_manager.page_table;
-    std::size_t remaining_size = size;
-    std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
-    std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
-
-    while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr =
-            static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+    impl->ForEachRun(page_table, src_addr, size, [&](PageType type, VAddr current_vaddr,
+                                                     const u8* src_ptr, std::size_t amount) {
+        switch (type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "unmapped CopyBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
                       "0x{:08X}",
                       current_vaddr, src_addr, size, Core::GetRunningCore().GetPC());
-            ZeroBlock(dest_process, dest_addr, copy_amount);
+            ZeroBlock(dest_process, dest_addr, amount);
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            WriteBlock(dest_process, dest_addr, src_ptr, copy_amount);
+            WriteBlock(dest_process, dest_addr, src_ptr, amount);
             break;
         }
         case PageType::Special: {
             MMIORegionPointer handler = impl->GetMMIOHandler(page_table, current_vaddr);
             DEBUG_ASSERT(handler);
-            std::vector<u8> buffer(copy_amount);
+            std::vector<u8> buffer(amount);
             handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
             WriteBlock(dest_process, dest_addr, buffer.data(), buffer.size());
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(amount),
                                          FlushMode::Flush);
-            WriteBlock(dest_process, dest_addr, GetPointerForRasterizerCache(current_vaddr),
-                       copy_amount);
+            WriteBlock(dest_process, dest_addr, src_ptr, amount);
             break;
         }
         default:
             UNREACHABLE();
         }
-
-        page_index++;
-        page_offset = 0;
-        dest_addr += static_cast<VAddr>(copy_amount);
-        src_addr += static_cast<VAddr>(copy_amount);
-        remaining_size -= copy_amount;
-    }
+        dest_addr += static_cast<VAddr>(amount);
+    });
 }
 
 template <>
@@ -1086,6 +1180,38 @@ MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
     return MemoryRef(impl->fcram_mem, offset);
 }
 
+void MemorySystem::SetDirtyTracking(bool enable) {
+    impl->dirty_tracking = enable;
+    if (!enable) {
+        impl->dirty_pages.Reset();
+    }
+}
+
+bool MemorySystem::IsDirtyTrackingEnabled() const {
+    return impl->dirty_tracking;
+}
+
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size) {
+    if (impl->dirty_tracking) {
+        impl->dirty_pages.Mark(start, size);
+    }
+}
+
+std::vector<PAddr> MemorySystem::GetAndClearDirtyPages(PAddr start, u32 size) {
+    std::vector<PAddr> pages;
+    if (size == 0) {
+        return pages;
+    }
+
+    const PAddr end = start + size;
+    for (PAddr page = start & ~CITRA_PAGE_MASK; page < end; page += CITRA_PAGE_SIZE) {
+        if (impl->dirty_pages.TestAndClear(page)) {
+            pages.push_back(page);
+        }
+    }
+    return pages;
+}
+
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
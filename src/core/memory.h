@@ -6,6 +6,7 @@
 #include <array>
 #include <cstddef>
 #include <string>
+#include <vector>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
@@ -605,6 +606,33 @@ public:
     /// Unregisters page table for rasterizer cache marking
     void UnregisterPageTable(std::shared_ptr<PageTable> page_table);
 
+    /**
+     * Enables or disables tracking of writes to FCRAM and VRAM at page granularity. While enabled,
+     * the CPU cores bypass the page table fast path so that writes from JIT-compiled code are also
+     * observed. Disabling tracking marks every page as clean.
+     */
+    void SetDirtyTracking(bool enable);
+
+    /// Returns true if writes to FCRAM and VRAM are currently being tracked
+    bool IsDirtyTrackingEnabled() const;
+
+    /**
+     * Marks every page touched by the physical address range as dirty. This is meant for writers
+     * that access the backing memory directly instead of going through this class.
+     */
+    void MarkRegionDirty(PAddr start, u32 size);
+
+    /**
+     * Collects the pages written to since the last call and marks them as clean.
+     *
+     * @param start Physical address of the start of the range to query.
+     * @param size  The size of the range in bytes.
+     *
+     * @returns The page-aligned physical address of every dirty page within the range. Pages
+     *          outside of FCRAM and VRAM are never reported.
+     */
+    std::vector<PAddr> GetAndClearDirtyPages(PAddr start, u32 size);
+
     void SetDSP(AudioCore::DspInterface& dsp);
 
 private:
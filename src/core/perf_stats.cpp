@@ -12,6 +12,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "common/settings.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
@@ -27,9 +28,18 @@ constexpr std::size_t IgnoreFrames = 5;
 
 namespace Core {
 
-PerfStats::PerfStats(u64 title_id) : title_id(title_id) {}
+PerfStats::PerfStats(u64 title_id) : title_id(title_id) {
+    if (Settings::values.record_frame_times) {
+        frame_records.resize(FRAME_RECORD_COUNT);
+        Common::TakePerfSectionTimes();
+        Common::SetPerfSectionsEnabled(true);
+    }
+}
 
 PerfStats::~PerfStats() {
+    if (!frame_records.empty()) {
+        Common::SetPerfSectionsEnabled(false);
+    }
     if (!Settings::values.record_frame_times || title_id == 0) {
         return;
     }
@@ -66,6 +76,13 @@ void PerfStats::EndSystemFrame() {
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
+
+    if (!frame_records.empty()) {
+        frame_records[num_frame_records++ % frame_records.size()] = {
+            .frame_time = previous_frame_length,
+            .sections = Common::TakePerfSectionTimes(),
+        };
+    }
 }
 
 void PerfStats::EndGameFrame() {
@@ -119,6 +136,76 @@ double PerfStats::GetLastFrameTimeScale() const {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+std::vector<PerfStats::FrameRecord> PerfStats::GetFrameRecords() const {
+    std::lock_guard lock{object_mutex};
+
+    if (num_frame_records <= frame_records.size()) {
+        return {frame_records.begin(), frame_records.begin() + num_frame_records};
+    }
+    const auto oldest = frame_records.begin() + num_frame_records % frame_records.size();
+    std::vector<FrameRecord> records(oldest, frame_records.end());
+    records.insert(records.end(), frame_records.begin(), oldest);
+    return records;
+}
+
+bool PerfStats::DumpFrameRecords(const std::string& path) const {
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open frame record file {}", path);
+        return false;
+    }
+
+    const auto section_name = [](std::size_t i) {
+        return Common::GetPerfSectionName(static_cast<Common::PerfSection>(i));
+    };
+    const auto to_ms = [](auto duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    // Host time of the frame that wasn't spent in any of the sections
+    const auto other_ms = [&](const FrameRecord& record) {
+        auto other = record.frame_time;
+        for (const auto section : record.sections) {
+            other -= section;
+        }
+        return to_ms(std::max(other, Clock::duration::zero()));
+    };
+
+    const std::vector<FrameRecord> records = GetFrameRecords();
+    const bool json = path.ends_with(".json");
+    std::string out;
+    if (json) {
+        out += "[\n";
+    } else {
+        out += "frame_ms";
+        for (std::size_t i = 0; i < Common::NumPerfSections; i++) {
+            out += fmt::format(",{}_ms", section_name(i));
+        }
+        out += ",other_ms\n";
+    }
+    for (std::size_t frame = 0; frame < records.size(); frame++) {
+        const FrameRecord& record = records[frame];
+        if (json) {
+            out += fmt::format("  {{\"frame_ms\": {:.4f}", to_ms(record.frame_time));
+            for (std::size_t i = 0; i < Common::NumPerfSections; i++) {
+                out += fmt::format(", \"{}_ms\": {:.4f}", section_name(i),
+                                   to_ms(record.sections[i]));
+            }
+            out += fmt::format(", \"other_ms\": {:.4f}}}{}\n", other_ms(record),
+                               frame + 1 < records.size() ? "," : "");
+        } else {
+            out += fmt::format("{:.4f}", to_ms(record.frame_time));
+            for (const auto section : record.sections) {
+                out += fmt::format(",{:.4f}", to_ms(section));
+            }
+            out += fmt::format(",{:.4f}\n", other_ms(record));
+        }
+    }
+    if (json) {
+        out += "]\n";
+    }
+    return file.WriteString(out) == out.size();
+}
+
 void FrameLimiter::WaitOnce() {
     if (frame_advancing_enabled) {
         // Frame advancing is enabled: wait on event instead of doing framelimiting
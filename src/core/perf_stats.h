@@ -9,7 +9,10 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <string>
+#include <vector>
 #include "common/common_types.h"
+#include "common/perf_sections.h"
 #include "common/thread.h"
 
 namespace Core {
@@ -36,6 +39,17 @@ public:
         double emulation_speed;
     };
 
+    /// Where the host time of a system frame went.
+    struct FrameRecord {
+        /// Walltime from the end of the previous system frame, including waits
+        Clock::duration frame_time;
+        /// Host time spent in each subsystem, the rest of frame_time wasn't attributed to any
+        Common::PerfSectionTimes sections;
+    };
+
+    /// Number of system frames kept by the frame record ring, ten minutes at full speed
+    static constexpr std::size_t FRAME_RECORD_COUNT = 36000;
+
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
@@ -53,6 +67,19 @@ public:
      */
     double GetLastFrameTimeScale() const;
 
+    /**
+     * Returns the most recent frame records, oldest first. Frames are only recorded when frame
+     * times are being recorded.
+     */
+    std::vector<FrameRecord> GetFrameRecords() const;
+
+    /**
+     * Writes the most recent frame records to the given file, as JSON if its name ends with .json
+     * and as CSV otherwise.
+     * @returns false if the file could not be written.
+     */
+    bool DumpFrameRecords(const std::string& path) const;
+
 private:
     mutable std::mutex object_mutex;
 
@@ -63,6 +90,10 @@ private:
     /// Stores an hour of historical frametime data useful for processing and tracking performance
     /// regressions with code changes.
     std::array<double, 216000> perf_history{};
+    /// Ring of the most recent frame records, empty unless frame times are being recorded
+    std::vector<FrameRecord> frame_records;
+    /// Number of frames recorded so far, the next record goes to this index modulo the ring size
+    u64 num_frame_records{0};
 
     /// Point when the cumulative counters were reset
     Clock::time_point reset_point = Clock::now();
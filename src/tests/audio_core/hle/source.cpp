@@ -0,0 +1,132 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstring>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "audio_core/hle/hle.h"
+#include "audio_core/hle/shared_memory.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+
+namespace {
+
+using Configuration = AudioCore::HLE::SourceConfiguration::Configuration;
+
+// Matches the audio tick period used by DspHle.
+constexpr u64 audio_frame_ticks = AudioCore::samples_per_frame * 4096 * 2ull;
+constexpr u32 voice_samples = 0x1000;
+constexpr u32 voice_bytes = voice_samples * 2 * sizeof(s16);
+
+AudioCore::HLE::DspMemory& GetSharedMemory(AudioCore::DspHle& dsp) {
+    return *reinterpret_cast<AudioCore::HLE::DspMemory*>(dsp.GetDspMemory().data());
+}
+
+/// Configures all sources to play a looping stereo PCM16 buffer through a biquad filter.
+void SetupVoices(Memory::MemorySystem& memory, AudioCore::DspHle& dsp) {
+    auto& dsp_memory = GetSharedMemory(dsp);
+    // Region 0 is always the one read by the DSP.
+    dsp_memory.region_0.frame_counter = 1;
+    dsp_memory.region_1.frame_counter = 0;
+
+    auto& dsp_config = dsp_memory.region_0.dsp_configuration;
+    dsp_config.volume[0] = 1.0f;
+    dsp_config.volume_0_dirty.Assign(1);
+    dsp_config.output_format = AudioCore::HLE::DspConfiguration::OutputFormat::Stereo;
+    dsp_config.output_format_dirty.Assign(1);
+
+    u32 seed = 0x12345678;
+    for (std::size_t i = 0; i < AudioCore::HLE::num_sources; i++) {
+        const u32 offset = static_cast<u32>(i) * voice_bytes;
+        u8* const samples = memory.GetFCRAMPointer(offset);
+        for (u32 byte = 0; byte < voice_bytes; byte += sizeof(s16)) {
+            seed = seed * 1664525 + 1013904223;
+            const s16 sample = static_cast<s16>(seed >> 20);
+            std::memcpy(samples + byte, &sample, sizeof(s16));
+        }
+
+        Configuration& config = dsp_memory.region_0.source_configurations.config[i];
+        config.enable = 1;
+        config.enable_dirty.Assign(1);
+        config.gain[0][0] = 1.0f / 8;
+        config.gain[0][1] = 1.0f / 8;
+        config.gain_0_dirty.Assign(1);
+        config.rate_multiplier = 1.0f + static_cast<float>(i) / 64;
+        config.rate_multiplier_dirty.Assign(1);
+        config.interpolation_mode = Configuration::InterpolationMode::Linear;
+        config.interpolation_dirty.Assign(1);
+        config.biquad_filter_enabled.Assign(1);
+        config.filters_enabled_dirty.Assign(1);
+        config.biquad_filter.b0 = 1 << 13;
+        config.biquad_filter.b1 = 1 << 12;
+        config.biquad_filter.a1 = 1 << 11;
+        config.biquad_filter_dirty.Assign(1);
+        config.physical_address = Memory::FCRAM_PADDR + offset;
+        config.length = voice_samples;
+        config.mono_or_stereo.Assign(Configuration::MonoOrStereo::Stereo);
+        config.format.Assign(Configuration::Format::PCM16);
+        config.is_looping.Assign(1);
+        config.buffer_id = 1;
+        config.embedded_buffer_dirty.Assign(1);
+    }
+}
+
+void RunFrames(Core::Timing& timing, std::size_t num_frames) {
+    const auto timer = timing.GetTimer(0);
+    const u64 target = timer->GetTicks() + num_frames * audio_frame_ticks;
+    while (timer->GetTicks() < target) {
+        timer->AddTicks(timer->GetDowncount());
+        timer->Advance();
+        timer->SetNextSlice();
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DSP HLE multithreaded source processing", "[audio_core][hle]") {
+    Memory::MemorySystem serial_memory;
+    Core::Timing serial_timing(1, 100);
+    AudioCore::DspHle serial(serial_memory, serial_timing);
+    SetupVoices(serial_memory, serial);
+
+    Memory::MemorySystem threaded_memory;
+    Core::Timing threaded_timing(1, 100);
+    AudioCore::DspHle threaded(threaded_memory, threaded_timing);
+    threaded.SetMultithreaded(true);
+    SetupVoices(threaded_memory, threaded);
+
+    auto& serial_output = GetSharedMemory(serial).region_1;
+    auto& threaded_output = GetSharedMemory(threaded).region_1;
+    for (int frame = 0; frame < 200; frame++) {
+        RunFrames(serial_timing, 1);
+        RunFrames(threaded_timing, 1);
+        REQUIRE(std::memcmp(&serial_output.final_samples, &threaded_output.final_samples,
+                            sizeof(serial_output.final_samples)) == 0);
+        REQUIRE(std::memcmp(&serial_output.source_statuses, &threaded_output.source_statuses,
+                            sizeof(serial_output.source_statuses)) == 0);
+    }
+}
+
+TEST_CASE("DSP HLE 24 voice render", "[.][audio_core][hle][benchmark]") {
+    constexpr std::size_t seconds = 10;
+    constexpr std::size_t num_frames =
+        seconds * AudioCore::native_sample_rate / AudioCore::samples_per_frame;
+
+    for (const bool multithreaded : {false, true}) {
+        Memory::MemorySystem memory;
+        Core::Timing timing(1, 100);
+        AudioCore::DspHle dsp(memory, timing);
+        dsp.SetMultithreaded(multithreaded);
+        SetupVoices(memory, dsp);
+
+        const auto start = std::chrono::steady_clock::now();
+        RunFrames(timing, num_frames);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        fmt::print("DspHle multithreaded={}: rendered {}s of audio in {:.3f}s, real-time factor "
+                   "{:.1f}x\n",
+                   multithreaded, seconds, elapsed.count(), seconds / elapsed.count());
+    }
+}
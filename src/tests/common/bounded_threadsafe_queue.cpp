@@ -0,0 +1,74 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include "common/bounded_threadsafe_queue.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("BoundedQueue hands over elements in order", "[common]") {
+    Common::BoundedQueue<int> queue{4};
+    REQUIRE(queue.Push(1));
+    REQUIRE(queue.Push(2));
+    REQUIRE(queue.PopWait() == 1);
+    REQUIRE(queue.Push(3));
+    REQUIRE(queue.PopWait() == 2);
+    REQUIRE(queue.PopWait() == 3);
+}
+
+TEST_CASE("BoundedQueue blocks producers while full", "[common]") {
+    Common::BoundedQueue<int> queue{2};
+    REQUIRE(queue.Push(1));
+    REQUIRE(queue.Push(2));
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        const bool result = queue.Push(3);
+        pushed = result;
+    });
+    std::this_thread::sleep_for(50ms);
+    REQUIRE_FALSE(pushed);
+
+    // Popping makes room for the blocked element
+    REQUIRE(queue.PopWait() == 1);
+    producer.join();
+    REQUIRE(pushed);
+    REQUIRE(queue.PopWait() == 2);
+    REQUIRE(queue.PopWait() == 3);
+}
+
+TEST_CASE("BoundedQueue Close wakes up waiters", "[common]") {
+    SECTION("consumers blocked on an empty queue") {
+        Common::BoundedQueue<int> queue{2};
+        std::optional<int> popped{0};
+        std::thread consumer([&] { popped = queue.PopWait(); });
+        std::this_thread::sleep_for(10ms);
+        queue.Close();
+        consumer.join();
+        REQUIRE_FALSE(popped);
+    }
+
+    SECTION("producers blocked on a full queue") {
+        Common::BoundedQueue<int> queue{1};
+        REQUIRE(queue.Push(1));
+        std::atomic<bool> pushed{true};
+        std::thread producer([&] {
+            const bool result = queue.Push(2);
+            pushed = result;
+        });
+        std::this_thread::sleep_for(10ms);
+        queue.Close();
+        producer.join();
+        REQUIRE_FALSE(pushed);
+
+        // Elements pushed before closing are still handed out, then the queue reports the end
+        REQUIRE_FALSE(queue.Push(3));
+        REQUIRE(queue.PopWait() == 1);
+        REQUIRE_FALSE(queue.PopWait());
+    }
+}
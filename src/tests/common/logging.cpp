@@ -0,0 +1,128 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+
+namespace Log {
+
+namespace {
+
+/// Backend keeping the messages it receives.
+class CaptureBackend : public Backend {
+public:
+    static const char* Name() {
+        return "capture";
+    }
+
+    const char* GetName() const override {
+        return Name();
+    }
+
+    void Write(const Entry& entry) override {
+        std::scoped_lock lock{mutex};
+        messages.push_back(entry.message);
+    }
+
+    /// Waits until count messages were received and returns them.
+    std::vector<std::string> WaitForMessages(std::size_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::scoped_lock lock{mutex};
+                if (messages.size() >= count) {
+                    return messages;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        std::scoped_lock lock{mutex};
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+/// Lets every message through while alive, then restores the previous global filter.
+class ScopedTraceFilter {
+public:
+    ScopedTraceFilter() : previous{filter} {
+        SetGlobalFilter(Filter{Level::Trace});
+    }
+
+    ~ScopedTraceFilter() {
+        SetGlobalFilter(previous);
+    }
+
+private:
+    Filter previous;
+};
+
+enum class Color : u8 { Red = 2 };
+
+void LogSamples() {
+    const std::string owned = "owned";
+    LOG_INFO(Common, "ints {} {:#x} {}", -1, 0xbeefu, u64{1} << 40);
+    LOG_INFO(Common, "floats {:.2f} {}", 3.14159, true);
+    LOG_INFO(Common, "strings {} {} {}", "literal", owned, std::string_view{owned}.substr(1));
+    LOG_INFO(Common, "enum {}", Color::Red);
+    LOG_INFO(Common, "no arguments");
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Deferred log messages match immediately formatted ones", "[common][logging]") {
+    const ScopedTraceFilter trace_filter;
+    AddBackend(std::make_unique<CaptureBackend>());
+    auto& capture = *static_cast<CaptureBackend*>(GetBackend(CaptureBackend::Name()));
+
+    SetDeferredFormatting(false);
+    LogSamples();
+    SetDeferredFormatting(true);
+    LogSamples();
+    // Logging from a thread that exits right away must not lose its messages.
+    std::thread{LogSamples}.join();
+    SetDeferredFormatting(false);
+
+    const auto messages = capture.WaitForMessages(15);
+    RemoveBackend(CaptureBackend::Name());
+    REQUIRE(messages.size() == 15);
+    REQUIRE(messages[0] == "ints -1 0xbeef 1099511627776");
+    REQUIRE(messages[2] == "strings literal owned wned");
+    for (std::size_t i = 0; i < 5; i++) {
+        REQUIRE(messages[i + 5] == messages[i]);
+        REQUIRE(messages[i + 10] == messages[i]);
+    }
+}
+
+TEST_CASE("Deferred logging falls back to formatting when the ring is full", "[common][logging]") {
+    const ScopedTraceFilter trace_filter;
+    AddBackend(std::make_unique<CaptureBackend>());
+    auto& capture = *static_cast<CaptureBackend*>(GetBackend(CaptureBackend::Name()));
+
+    SetDeferredFormatting(true);
+    const std::string large(1024, 'x');
+    constexpr std::size_t count = 1000;
+    for (std::size_t i = 0; i < count; i++) {
+        LOG_INFO(Common, "{} {}", i, large);
+    }
+    SetDeferredFormatting(false);
+
+    const auto messages = capture.WaitForMessages(count);
+    RemoveBackend(CaptureBackend::Name());
+    REQUIRE(messages.size() == count);
+    for (std::size_t i = 0; i < count; i++) {
+        REQUIRE(messages[i] == fmt::format("{} {}", i, large));
+    }
+}
+
+} // namespace Log
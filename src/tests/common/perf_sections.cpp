@@ -0,0 +1,48 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include "common/perf_sections.h"
+
+using namespace std::chrono_literals;
+using Common::PerfSection;
+
+namespace {
+
+std::chrono::nanoseconds Get(const Common::PerfSectionTimes& times, PerfSection section) {
+    return times[static_cast<std::size_t>(section)];
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ScopedPerfSection only counts time outside nested sections", "[common]") {
+    Common::SetPerfSectionsEnabled(true);
+    Common::TakePerfSectionTimes();
+    {
+        Common::ScopedPerfSection cpu{PerfSection::CPU};
+        std::this_thread::sleep_for(5ms);
+        {
+            Common::ScopedPerfSection services{PerfSection::Services};
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+    auto times = Common::TakePerfSectionTimes();
+    REQUIRE(Get(times, PerfSection::CPU) >= 5ms);
+    REQUIRE(Get(times, PerfSection::Services) >= 50ms);
+    // Counting the nested section in the outer one as well would make it the longer one
+    REQUIRE(Get(times, PerfSection::CPU) < Get(times, PerfSection::Services));
+
+    // Taking the times resets them, and nothing is counted while disabled
+    Common::SetPerfSectionsEnabled(false);
+    {
+        Common::ScopedPerfSection audio{PerfSection::Audio};
+        std::this_thread::sleep_for(1ms);
+    }
+    times = Common::TakePerfSectionTimes();
+    for (const auto time : times) {
+        REQUIRE(time == std::chrono::nanoseconds::zero());
+    }
+}
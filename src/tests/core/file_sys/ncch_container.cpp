@@ -0,0 +1,294 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "core/file_sys/ncch_container.h"
+#include "core/hw/aes/key.h"
+#include "core/loader/loader.h"
+
+using FileSys::LZSS_Decompress;
+using FileSys::LZSS_GetDecompressedSize;
+
+namespace {
+
+/**
+ * Builds ExeFS LZSS streams. The stream is read back to front, starting with a control byte whose
+ * bits select a literal or a match for each of the following tokens, most significant bit first.
+ */
+class LZSSWriter {
+public:
+    void Literal(u8 value) {
+        StartToken(false);
+        tokens.push_back(value);
+    }
+
+    /// A match copying size bytes, each taken from distance bytes above the one written.
+    void Match(u32 distance, u32 size) {
+        const u32 value = ((size - 3) << 12) | (distance - 3);
+        StartToken(true);
+        tokens.push_back(static_cast<u8>(value >> 8));
+        tokens.push_back(static_cast<u8>(value));
+    }
+
+    /// Returns the compressed file, with prefix stored uncompressed before the stream.
+    std::vector<u8> Finish(const std::vector<u8>& prefix, u32 decompressed_size) const {
+        std::vector<u8> compressed = prefix;
+        compressed.insert(compressed.end(), tokens.rbegin(), tokens.rend());
+        const u32 compressed_size = static_cast<u32>(compressed.size() + 8);
+        const u32 top_and_bottom = (8u << 24) | (compressed_size - static_cast<u32>(prefix.size()));
+        const u32 additional_size = decompressed_size - compressed_size;
+        compressed.resize(compressed_size);
+        std::memcpy(compressed.data() + compressed_size - 8, &top_and_bottom, sizeof(u32));
+        std::memcpy(compressed.data() + compressed_size - 4, &additional_size, sizeof(u32));
+        return compressed;
+    }
+
+private:
+    void StartToken(bool match) {
+        if (num_tokens % 8 == 0) {
+            control_index = tokens.size();
+            tokens.push_back(0);
+        }
+        if (match) {
+            tokens[control_index] |= 0x80 >> (num_tokens % 8);
+        }
+        num_tokens++;
+    }
+
+    std::vector<u8> tokens; ///< Stream bytes in the order they are read
+    std::size_t control_index = 0;
+    std::size_t num_tokens = 0;
+};
+
+/// The byte by byte decompression LZSS_Decompress replaced, used as a reference.
+bool ReferenceDecompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                         u32 decompressed_size) {
+    const u8* footer = compressed + compressed_size - 8;
+
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
+
+    u32 out = decompressed_size;
+    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
+    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+
+    std::memset(decompressed, 0, decompressed_size);
+    std::memcpy(decompressed, compressed, compressed_size);
+
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        for (unsigned i = 0; i < 8; i++) {
+            if (index <= stop_index || out <= 0)
+                break;
+
+            if (control & 0x80) {
+                if (index < 2)
+                    return false;
+                index -= 2;
+
+                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+                segment_offset &= 0x0FFF;
+                segment_offset += 2;
+
+                if (out < segment_size)
+                    return false;
+
+                for (unsigned j = 0; j < segment_size; j++) {
+                    if (out + segment_offset >= decompressed_size)
+                        return false;
+
+                    u8 data = decompressed[out + segment_offset];
+                    decompressed[--out] = data;
+                }
+            } else {
+                if (out < 1)
+                    return false;
+                decompressed[--out] = compressed[--index];
+            }
+            control <<= 1;
+        }
+    }
+    return true;
+}
+
+/// Decompresses with both implementations and checks they agree, returns the decompressed data.
+std::vector<u8> Decompress(const std::vector<u8>& compressed, u32 decompressed_size,
+                           bool expect_success = true) {
+    const u32 compressed_size = static_cast<u32>(compressed.size());
+    std::vector<u8> decompressed(decompressed_size, 0xCC);
+    std::vector<u8> reference(decompressed_size, 0xCC);
+    const bool result =
+        LZSS_Decompress(compressed.data(), compressed_size, decompressed.data(), decompressed_size);
+    REQUIRE(result == expect_success);
+    REQUIRE(ReferenceDecompress(compressed.data(), compressed_size, reference.data(),
+                                decompressed_size) == expect_success);
+    REQUIRE(decompressed == reference);
+    return decompressed;
+}
+
+std::vector<u8> ToBytes(std::string_view text) {
+    return {text.begin(), text.end()};
+}
+
+} // Anonymous namespace
+
+TEST_CASE("LZSS decompresses ExeFS files", "[core][file_sys]") {
+    LZSSWriter writer;
+    for (const char c : std::string_view{"abcd"}) {
+        writer.Literal(c);
+    }
+    // Overlapping match, repeats the last three bytes
+    writer.Match(3, 18);
+    // Matches that do not overlap what they write
+    writer.Match(8, 3);
+    writer.Match(24, 5);
+    writer.Literal('e');
+    writer.Literal('f');
+
+    const std::vector<u8> prefix = ToBytes("XY");
+    const u32 decompressed_size = 2 + 4 + 18 + 3 + 5 + 2;
+    const std::vector<u8> compressed = writer.Finish(prefix, decompressed_size);
+    REQUIRE(LZSS_GetDecompressedSize(compressed.data(), static_cast<u32>(compressed.size())) ==
+            decompressed_size);
+
+    // The output is written back to front, starting with the first token.
+    const std::vector<u8> decompressed = Decompress(compressed, decompressed_size);
+    REQUIRE(decompressed == ToBytes("XYfecbdcbbdcdcbdcbdcbdcbdcbdcbdcba"));
+}
+
+TEST_CASE("LZSS matches the byte by byte decompression", "[core][file_sys]") {
+    std::mt19937 random{0x3D5};
+    for (int iteration = 0; iteration < 200; iteration++) {
+        LZSSWriter writer;
+        u32 produced = 0;
+        const int num_tokens = std::uniform_int_distribution{1, 200}(random);
+        for (int i = 0; i < num_tokens; i++) {
+            if (produced < 3 || random() % 3 == 0) {
+                writer.Literal(static_cast<u8>(random()));
+                produced++;
+                continue;
+            }
+            // Matches only reach the bytes already written
+            const u32 size = std::uniform_int_distribution<u32>{3, 18}(random);
+            const u32 distance =
+                std::uniform_int_distribution<u32>{3, std::min<u32>(produced, 0x1002)}(random);
+            writer.Match(distance, size);
+            produced += size;
+        }
+        const std::vector<u8> prefix(random() % 16, 0x5A);
+        const u32 decompressed_size = static_cast<u32>(prefix.size()) + produced;
+        const std::vector<u8> compressed = writer.Finish(prefix, decompressed_size);
+        if (compressed.size() > decompressed_size) {
+            continue;
+        }
+        Decompress(compressed, decompressed_size);
+    }
+}
+
+TEST_CASE("LZSS rejects invalid files", "[core][file_sys]") {
+    LZSSWriter writer;
+    for (const char c : std::string_view{"abc"}) {
+        writer.Literal(c);
+    }
+    writer.Match(3, 10);
+    const std::vector<u8> compressed = writer.Finish({}, 16);
+    REQUIRE(compressed.size() == 14);
+    Decompress(compressed, 16);
+    std::vector<u8> decompressed(32);
+
+    SECTION("files smaller than their footer") {
+        REQUIRE_FALSE(LZSS_Decompress(compressed.data(), 7, decompressed.data(), 16));
+        REQUIRE_FALSE(LZSS_Decompress(compressed.data(), 0, decompressed.data(), 16));
+    }
+
+    SECTION("output smaller than the compressed file") {
+        REQUIRE_FALSE(LZSS_Decompress(compressed.data(), static_cast<u32>(compressed.size()),
+                                      decompressed.data(), 8));
+    }
+
+    SECTION("footers pointing outside of the file") {
+        for (const u32 top_and_bottom : {0xFF000004u, 0x08FFFFFFu, 0x08000000u | 15u}) {
+            std::vector<u8> corrupted = compressed;
+            std::memcpy(corrupted.data() + corrupted.size() - 8, &top_and_bottom, sizeof(u32));
+            REQUIRE_FALSE(LZSS_Decompress(corrupted.data(), static_cast<u32>(corrupted.size()),
+                                          decompressed.data(), 16));
+        }
+    }
+
+    SECTION("matches reaching past the end of the output") {
+        LZSSWriter bad_writer;
+        bad_writer.Literal('a');
+        bad_writer.Match(4, 3);
+        const std::vector<u8> bad = bad_writer.Finish({}, 16);
+        Decompress(bad, 16, false);
+    }
+}
+
+TEST_CASE("LZSS decompression", "[.][core][file_sys][benchmark]") {
+    // A code section sized file, mostly matches as in compiled code
+    constexpr u32 decompressed_size = 4 * 1024 * 1024;
+    std::mt19937 random{0x3D5};
+    LZSSWriter writer;
+    u32 produced = 0;
+    while (produced < decompressed_size - 18) {
+        if (produced < 0x1001 || random() % 4 == 0) {
+            writer.Literal(static_cast<u8>(random()));
+            produced++;
+            continue;
+        }
+        const u32 size = 3 + random() % 16;
+        writer.Match(3 + random() % 0xFFF, size);
+        produced += size;
+    }
+    const std::vector<u8> compressed = writer.Finish({}, produced);
+    std::vector<u8> decompressed(produced);
+
+    constexpr int iterations = 20;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        REQUIRE(LZSS_Decompress(compressed.data(), static_cast<u32>(compressed.size()),
+                                decompressed.data(), produced));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("LZSS: decompressed {} KiB in {:.3f}ms on average\n", produced / 1024,
+               elapsed.count() * 1e3 / iterations);
+}
+
+TEST_CASE("NCCH code loading", "[.][core][file_sys][benchmark]") {
+    // Path to a 3DS or CXI file, encrypted ones need the keys in the user sysdata directory
+    const char* path = std::getenv("CITRA_NCCH_FILE");
+    if (path == nullptr) {
+        WARN("CITRA_NCCH_FILE is not set, skipping");
+        return;
+    }
+    HW::AES::InitKeys();
+
+    // Everything the loader does with the NCCH before the first instruction can run: parsing the
+    // headers and reading, decrypting and decompressing the code.
+    constexpr int iterations = 10;
+    std::chrono::duration<double> total{};
+    std::size_t code_size = 0;
+    for (int i = 0; i < iterations; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        FileSys::NCCHContainer ncch(path);
+        REQUIRE(ncch.Load() == Loader::ResultStatus::Success);
+        std::vector<u8> code;
+        REQUIRE(ncch.LoadSectionExeFS(".code", code) == Loader::ResultStatus::Success);
+        total += std::chrono::steady_clock::now() - start;
+        code_size = code.size();
+    }
+
+    fmt::print("NCCH {}: loaded {} KiB of code in {:.3f}ms on average\n", path, code_size / 1024,
+               total.count() * 1e3 / iterations);
+}
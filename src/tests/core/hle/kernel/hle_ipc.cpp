@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
 #include "common/archives.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -391,4 +393,116 @@ TEST_CASE("HLERequestContext::WriteToOutgoingCommandBuffer", "[core][kernel]") {
     }
 }
 
+TEST_CASE("HLERequestContext::Reset", "[core][kernel]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto [server, client] = kernel.CreateSessionPair();
+    auto context = std::make_shared<HLERequestContext>(kernel, server, nullptr);
+
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    auto mem = std::make_shared<BufferMem>(Memory::CITRA_PAGE_SIZE);
+    MemoryRef buffer{mem};
+    std::fill(buffer.GetPtr(), buffer.GetPtr() + buffer.GetSize(), 0xAB);
+
+    VAddr target_address = 0x10000000;
+    auto result = process->vm_manager.MapBackingMemory(
+        target_address, buffer, static_cast<u32>(buffer.GetSize()), MemoryState::Private);
+    REQUIRE(result.Code() == RESULT_SUCCESS);
+
+    auto object = MakeObject(kernel);
+    const u32_le input[]{
+        IPC::MakeHeader(0, 0, 4),
+        IPC::StaticBufferDesc(buffer.GetSize(), 0),
+        target_address,
+        IPC::CopyHandleDesc(1),
+        process->handle_table.Create(object).Unwrap(),
+    };
+
+    context->PopulateFromIncomingCommandBuffer(input, process);
+    const u8* storage = context->GetStaticBuffer(0).data();
+    REQUIRE(object.use_count() == 3);
+
+    context->Reset(nullptr, nullptr);
+    CHECK(context->CommandBuffer()[0] == 0);
+    CHECK(context->GetStaticBuffer(0).empty());
+    CHECK(object.use_count() == 2);
+
+    std::fill(buffer.GetPtr(), buffer.GetPtr() + buffer.GetSize(), 0xCD);
+    context->Reset(server, nullptr);
+    context->PopulateFromIncomingCommandBuffer(input, process);
+    CHECK(context->GetStaticBuffer(0) == mem->Vector());
+    CHECK(context->GetStaticBuffer(0).data() == storage);
+
+    REQUIRE(process->vm_manager.UnmapRange(
+                target_address, static_cast<u32>(buffer.GetSize())) == RESULT_SUCCESS);
+}
+
+TEST_CASE("HLERequestContext round trip benchmark", "[.][core][kernel][benchmark]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto [server, client] = kernel.CreateSessionPair();
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    // A typical small request: a few parameters and a static buffer in each direction.
+    auto mem = std::make_shared<BufferMem>(Memory::CITRA_PAGE_SIZE);
+    MemoryRef buffer{mem};
+    constexpr VAddr input_address = 0x10000000;
+    constexpr VAddr output_address = input_address + 0x800;
+    constexpr u32 buffer_size = 0x100;
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(input_address, buffer, static_cast<u32>(buffer.GetSize()),
+                                  MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    const u32_le input[]{
+        IPC::MakeHeader(0x1234, 2, 2),
+        0x12345678,
+        0x9ABCDEF0,
+        IPC::StaticBufferDesc(buffer_size, 0),
+        input_address,
+    };
+    std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2> output{};
+    output[IPC::COMMAND_BUFFER_LENGTH] = IPC::StaticBufferDesc(buffer_size, 0);
+    output[IPC::COMMAND_BUFFER_LENGTH + 1] = output_address;
+
+    const auto HandleRequest = [&](HLERequestContext& context) {
+        context.PopulateFromIncomingCommandBuffer(input, process);
+        // The request is echoed back from the static buffer it was read into, passing a new
+        // vector to AddStaticBuffer would replace the storage the context keeps between requests.
+        u32* cmd_buf = context.CommandBuffer();
+        cmd_buf[0] = IPC::MakeHeader(0x1234, 1, 2);
+        cmd_buf[1] = RESULT_SUCCESS.raw;
+        cmd_buf[2] = IPC::StaticBufferDesc(buffer_size, 0);
+        cmd_buf[3] = 0;
+        context.WriteToOutgoingCommandBuffer(output.data(), *process);
+    };
+
+    constexpr std::size_t iterations = 1000000;
+    const auto Measure = [&](std::string_view name, auto&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++) {
+            func();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        fmt::print("{}: {:.1f} ns per request\n", name, elapsed.count() * 1e9 / iterations);
+    };
+
+    Measure("new context", [&] {
+        auto context = std::make_shared<HLERequestContext>(kernel, server, nullptr);
+        HandleRequest(*context);
+    });
+
+    auto pooled = std::make_shared<HLERequestContext>(kernel, server, nullptr);
+    Measure("pooled context", [&] {
+        pooled->Reset(server, nullptr);
+        HandleRequest(*pooled);
+        pooled->Reset(nullptr, nullptr);
+    });
+}
+
 } // namespace Kernel
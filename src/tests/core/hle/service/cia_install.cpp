@@ -0,0 +1,254 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <cryptopp/sha.h>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/file_sys/cia_common.h"
+#include "core/file_sys/cia_container.h"
+#include "core/file_sys/ticket.h"
+#include "core/file_sys/title_metadata.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/loader/loader.h"
+
+using Service::FS::MediaType;
+
+namespace {
+
+constexpr u64 TitleID = 0x00040000'0F800100;
+/// Size of an RSA-2048 signature with its type, which tickets and TMDs align their body after
+constexpr std::size_t SignedHeaderSize = 0x140;
+
+/// Installs into a scratch directory instead of the emulated SD card and NAND of the user.
+class ScratchUserDirectories {
+public:
+    ScratchUserDirectories()
+        : scratch{std::filesystem::temp_directory_path() / "citra_cia_install_test"},
+          old_sdmc{FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir)},
+          old_nand{FileUtil::GetUserPath(FileUtil::UserPath::NANDDir)} {
+        std::filesystem::remove_all(scratch);
+        std::filesystem::create_directories(scratch / "sdmc");
+        std::filesystem::create_directories(scratch / "nand");
+        FileUtil::UpdateUserPath(FileUtil::UserPath::SDMCDir, (scratch / "sdmc").string());
+        FileUtil::UpdateUserPath(FileUtil::UserPath::NANDDir, (scratch / "nand").string());
+    }
+
+    ~ScratchUserDirectories() {
+        FileUtil::UpdateUserPath(FileUtil::UserPath::SDMCDir, old_sdmc);
+        FileUtil::UpdateUserPath(FileUtil::UserPath::NANDDir, old_nand);
+        std::filesystem::remove_all(scratch);
+    }
+
+    std::string Path(std::string_view name) const {
+        return (scratch / name).string();
+    }
+
+private:
+    std::filesystem::path scratch;
+    std::string old_sdmc;
+    std::string old_nand;
+};
+
+std::array<u8, CryptoPP::SHA256::DIGESTSIZE> Hash(std::span<const u8> data) {
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    CryptoPP::SHA256().CalculateDigest(hash.data(), data.data(), data.size());
+    return hash;
+}
+
+/// Writes a signature header and body the way tickets and TMDs are laid out.
+template <typename Body>
+void WriteSigned(std::vector<u8>& cia, u64 offset, const Body& body) {
+    const u32_be signature_type = FileSys::Rsa2048Sha256;
+    std::memcpy(cia.data() + offset, &signature_type, sizeof(signature_type));
+    std::memcpy(cia.data() + offset + SignedHeaderSize, &body, sizeof(body));
+}
+
+/// Builds an unencrypted CIA holding a single content, with content_hash as its hash in the TMD.
+std::vector<u8> BuildCIA(std::span<const u8> content, const std::array<u8, 0x20>& content_hash) {
+    FileSys::CIAContainer::Header header{};
+    header.header_size = FileSys::CIA_HEADER_SIZE;
+    header.tik_size = SignedHeaderSize + sizeof(FileSys::Ticket::Body);
+    header.tmd_size = SignedHeaderSize + sizeof(FileSys::TitleMetadata::Body) +
+                      sizeof(FileSys::TitleMetadata::ContentChunk);
+    header.content_size = content.size();
+    header.SetContentPresent(0);
+
+    std::vector<u8> header_data(sizeof(header));
+    std::memcpy(header_data.data(), &header, sizeof(header));
+    FileSys::CIAContainer container;
+    REQUIRE(container.LoadHeader(header_data) == Loader::ResultStatus::Success);
+
+    const u64 content_offset = container.GetContentOffset();
+    std::vector<u8> cia(content_offset + content.size());
+    std::memcpy(cia.data(), &header, sizeof(header));
+
+    FileSys::Ticket::Body ticket{};
+    ticket.title_id = TitleID;
+    WriteSigned(cia, container.GetTicketOffset(), ticket);
+
+    FileSys::TitleMetadata::Body tmd{};
+    tmd.title_id = TitleID;
+    tmd.content_count = 1;
+    WriteSigned(cia, container.GetTitleMetadataOffset(), tmd);
+    FileSys::TitleMetadata::ContentChunk chunk{};
+    chunk.size = content.size();
+    chunk.hash = content_hash;
+    std::memcpy(cia.data() + container.GetTitleMetadataOffset() + SignedHeaderSize +
+                    sizeof(tmd),
+                &chunk, sizeof(chunk));
+
+    std::memcpy(cia.data() + content_offset, content.data(), content.size());
+    return cia;
+}
+
+std::vector<u8> MakeContent(std::size_t size) {
+    std::vector<u8> content(size);
+    for (std::size_t i = 0; i < size; i++) {
+        content[i] = static_cast<u8>(i * 7 + (i >> 12));
+    }
+    return content;
+}
+
+/// Writes the CIA to a CIAFile in chunks, as a guest install would, returns the first error.
+ResultCode WriteCIA(Service::AM::CIAFile& file, const std::vector<u8>& cia) {
+    constexpr std::size_t chunk_size = 0x3000;
+    for (std::size_t offset = 0; offset < cia.size(); offset += chunk_size) {
+        const std::size_t length = std::min(chunk_size, cia.size() - offset);
+        const auto result = file.Write(offset, length, true, cia.data() + offset);
+        if (result.Failed()) {
+            return result.Code();
+        }
+    }
+    return RESULT_SUCCESS;
+}
+
+std::string ContentPath() {
+    return Service::AM::GetTitleContentPath(MediaType::SDMC, TitleID);
+}
+
+std::string MetadataPath() {
+    return Service::AM::GetTitleMetadataPath(MediaType::SDMC, TitleID);
+}
+
+void WriteFile(const std::string& path, const std::vector<u8>& data) {
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.WriteBytes(data.data(), data.size()) == data.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CIAFile verifies content hashes", "[core][am]") {
+    const ScratchUserDirectories directories;
+    const std::vector<u8> content = MakeContent(0x20000);
+
+    SECTION("matching content is installed") {
+        const std::vector<u8> cia = BuildCIA(content, Hash(content));
+        {
+            Service::AM::CIAFile file(MediaType::SDMC);
+            REQUIRE(WriteCIA(file, cia) == RESULT_SUCCESS);
+            REQUIRE(file.Close());
+        }
+
+        std::vector<u8> installed;
+        FileUtil::IOFile app(Service::AM::GetTitleContentPath(MediaType::SDMC, TitleID), "rb");
+        installed.resize(app.GetSize());
+        app.ReadBytes(installed.data(), installed.size());
+        REQUIRE(installed == content);
+    }
+
+    SECTION("mismatching content aborts the install") {
+        auto hash = Hash(content);
+        hash[0] ^= 1;
+        const std::vector<u8> cia = BuildCIA(content, hash);
+
+        Service::AM::CIAFile file(MediaType::SDMC);
+        const ResultCode result = WriteCIA(file, cia);
+        REQUIRE(result == ResultCode(Service::AM::ErrCodes::InvalidCIAHeader, ErrorModule::AM,
+                                     ErrorSummary::InvalidArgument, ErrorLevel::Permanent));
+        REQUIRE_FALSE(file.Close());
+        REQUIRE_FALSE(FileUtil::Exists(ContentPath()));
+        REQUIRE_FALSE(FileUtil::Exists(MetadataPath()));
+    }
+
+    SECTION("aborted reinstalls keep the save data") {
+        {
+            Service::AM::CIAFile file(MediaType::SDMC);
+            REQUIRE(WriteCIA(file, BuildCIA(content, Hash(content))) == RESULT_SUCCESS);
+            REQUIRE(file.Close());
+        }
+        // SD save data lives in the directory of the title
+        const std::string save_path =
+            Service::AM::GetTitlePath(MediaType::SDMC, TitleID) + "data/00000001/save.bin";
+        REQUIRE(FileUtil::CreateFullPath(save_path));
+        WriteFile(save_path, {1, 2, 3});
+
+        auto hash = Hash(content);
+        hash[0] ^= 1;
+        Service::AM::CIAFile file(MediaType::SDMC);
+        REQUIRE(WriteCIA(file, BuildCIA(content, hash)) != RESULT_SUCCESS);
+        REQUIRE_FALSE(file.Close());
+        REQUIRE(FileUtil::GetSize(save_path) == 3);
+        // Only the TMD written by the aborted install is removed
+        REQUIRE(FileUtil::Exists(MetadataPath()));
+        REQUIRE_FALSE(FileUtil::Exists(
+            Service::AM::GetTitlePath(MediaType::SDMC, TitleID) + "content/00000001.tmd"));
+    }
+}
+
+TEST_CASE("InstallCIA installs through its pipeline", "[core][am]") {
+    const ScratchUserDirectories directories;
+    const std::string path = directories.Path("title.cia");
+    // Larger than the pipeline buffers, so that several of them are in flight
+    const std::vector<u8> content = MakeContent(0x1100000);
+
+    SECTION("matching content") {
+        WriteFile(path, BuildCIA(content, Hash(content)));
+        std::size_t last_written = 0;
+        std::size_t total_size = 0;
+        const auto status = Service::AM::InstallCIA(path, [&](std::size_t written,
+                                                              std::size_t total) {
+            REQUIRE(written >= last_written);
+            last_written = written;
+            total_size = total;
+        });
+        REQUIRE(status == Service::AM::InstallStatus::Success);
+        REQUIRE(last_written == total_size);
+        REQUIRE(FileUtil::GetSize(Service::AM::GetTitleContentPath(MediaType::SDMC, TitleID)) ==
+                content.size());
+    }
+
+    SECTION("mismatching content") {
+        auto hash = Hash(content);
+        hash[0] ^= 1;
+        WriteFile(path, BuildCIA(content, hash));
+        REQUIRE(Service::AM::InstallCIA(path) == Service::AM::InstallStatus::ErrorAborted);
+        REQUIRE_FALSE(FileUtil::Exists(ContentPath()));
+        REQUIRE_FALSE(FileUtil::Exists(MetadataPath()));
+    }
+}
+
+TEST_CASE("CIA install throughput", "[.][core][am][benchmark]") {
+    const ScratchUserDirectories directories;
+    const std::string path = directories.Path("title.cia");
+    const std::vector<u8> content = MakeContent(0x10000000);
+    WriteFile(path, BuildCIA(content, Hash(content)));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto status = Service::AM::InstallCIA(path);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(status == Service::AM::InstallStatus::Success);
+    fmt::print("CIA: installed {} MiB in {:.3f}s, {:.1f} MB/s\n", content.size() >> 20,
+               elapsed.count(), content.size() / elapsed.count() / 1e6);
+}
@@ -0,0 +1,276 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "core/hle/service/ldr_ro/cro_symbol_index.h"
+
+using Service::LDR::CROSymbolIndex;
+using Service::LDR::CROSymbolTable;
+
+namespace {
+
+/// Host copy of the export tree and named export table of a CRO, laid out as in guest memory.
+class ExportTree {
+public:
+    struct Child {
+        u16 next_index = 0;
+        bool is_end = false;
+    };
+
+    struct Node {
+        u16 test_bit = 0;
+        Child left;
+        Child right;
+        u16 export_table_index = 0;
+    };
+
+    struct Symbol {
+        std::string name;
+        u32 symbol_position;
+    };
+
+    /// Builds a tree that leads every name to its symbol. Names have to be unique.
+    explicit ExportTree(std::vector<Symbol> symbols_) : symbols{std::move(symbols_)} {
+        std::vector<u16> indices(symbols.size());
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            indices[i] = static_cast<u16>(i);
+        }
+        nodes.emplace_back();
+        nodes[0].left = Build(indices);
+    }
+
+    /**
+     * Adds a symbol that has the same name as an existing one but can't be reached by looking it
+     * up, as the tree walk always picks the existing one.
+     */
+    void AddShadowedSymbol(u16 existing, u32 symbol_position) {
+        const u16 shadowed = static_cast<u16>(symbols.size());
+        symbols.push_back({symbols[existing].name, symbol_position});
+
+        // Names are never long enough for the test bit, so the walk always takes the left child
+        Node node;
+        node.test_bit = 0x7FF8;
+        node.left = nodes[0].left;
+        node.right = {AddLeaf(shadowed), true};
+        nodes[0].left = {static_cast<u16>(nodes.size()), false};
+        nodes.push_back(node);
+    }
+
+    /// Looks up a name the way the RO service does, by walking the tree and checking the name.
+    std::optional<u32> Walk(const std::string& name) const {
+        const u16 found_id = WalkIndex(name);
+        if (found_id >= symbols.size() || symbols[found_id].name != name) {
+            return std::nullopt;
+        }
+        return symbols[found_id].symbol_position;
+    }
+
+    /// Builds the symbol table of the module, the same way CROHelper::BuildSymbolTable does.
+    CROSymbolTable BuildSymbolTable(std::string module_name) const {
+        CROSymbolTable table;
+        table.module_name = std::move(module_name);
+        table.named_exports.reserve(symbols.size());
+        for (const Node& node : nodes) {
+            for (const Child child : {node.left, node.right}) {
+                if (!child.is_end) {
+                    continue;
+                }
+                const u16 found_id = nodes[child.next_index].export_table_index;
+                if (found_id >= symbols.size()) {
+                    continue;
+                }
+                const Symbol& symbol = symbols[found_id];
+                if (WalkIndex(symbol.name) == found_id) {
+                    table.named_exports.emplace(symbol.name, symbol.symbol_position);
+                }
+            }
+        }
+        return table;
+    }
+
+    const std::vector<Symbol>& Symbols() const {
+        return symbols;
+    }
+
+private:
+    static bool TestBit(const std::string& name, u16 test_bit) {
+        const std::size_t test_byte = test_bit >> 3;
+        return test_byte < name.size() && ((name[test_byte] >> (test_bit & 7)) & 1);
+    }
+
+    /// Mirrors CROHelper::WalkExportTree.
+    u16 WalkIndex(const std::string& name) const {
+        Child next = nodes[0].left;
+        while (!next.is_end) {
+            const Node& node = nodes[next.next_index];
+            next = TestBit(name, node.test_bit) ? node.right : node.left;
+        }
+        return nodes[next.next_index].export_table_index;
+    }
+
+    u16 AddLeaf(u16 symbol) {
+        Node leaf;
+        leaf.export_table_index = symbol;
+        nodes.push_back(leaf);
+        return static_cast<u16>(nodes.size() - 1);
+    }
+
+    /// Splits the symbols on the first bit that tells their names apart.
+    Child Build(const std::vector<u16>& indices) {
+        if (indices.size() == 1) {
+            return {AddLeaf(indices[0]), true};
+        }
+
+        std::size_t max_length = 0;
+        for (const u16 index : indices) {
+            max_length = std::max(max_length, symbols[index].name.size());
+        }
+        for (u16 test_bit = 0; test_bit < max_length * 8; test_bit++) {
+            std::vector<u16> left;
+            std::vector<u16> right;
+            for (const u16 index : indices) {
+                (TestBit(symbols[index].name, test_bit) ? right : left).push_back(index);
+            }
+            if (left.empty() || right.empty()) {
+                continue;
+            }
+
+            const u16 node_index = static_cast<u16>(nodes.size());
+            nodes.emplace_back();
+            nodes[node_index].test_bit = test_bit;
+            // Building a child adds nodes, so the node can't be referenced across the calls
+            const Child left_child = Build(left);
+            const Child right_child = Build(right);
+            nodes[node_index].left = left_child;
+            nodes[node_index].right = right_child;
+            return {node_index, false};
+        }
+        UNREACHABLE_MSG("Export names are not unique");
+        return {};
+    }
+
+    std::vector<Node> nodes;
+    std::vector<Symbol> symbols;
+};
+
+/// Names like the ones of C++ symbols exported by CROs, with shared prefixes and varied lengths.
+std::vector<ExportTree::Symbol> MakeSymbols(std::size_t count, std::mt19937& random) {
+    std::vector<ExportTree::Symbol> symbols;
+    for (std::size_t i = 0; i < count; i++) {
+        const std::string name = fmt::format("_ZN2nn{}{}Func{}Ev", random() % 8, i, random() % 97);
+        symbols.push_back({name, static_cast<u32>(i << 4 | random() % 4)});
+    }
+    return symbols;
+}
+
+std::optional<u32> Lookup(const CROSymbolTable& table, const std::string& name) {
+    const auto it = table.named_exports.find(name);
+    if (it == table.named_exports.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CROSymbolIndex lookups match the export tree walk", "[core][ldr_ro]") {
+    std::mt19937 random{0x45};
+    std::vector<ExportTree::Symbol> symbols = MakeSymbols(300, random);
+    // Names that are prefixes of each other are told apart by the bits past the shorter one
+    symbols.push_back({"nnroAeabiAtexit", 0x100});
+    symbols.push_back({"nnroAeabiAtexit_", 0x200});
+    ExportTree tree(symbols);
+    tree.AddShadowedSymbol(0, 0x300);
+
+    CROSymbolIndex index;
+    const CROSymbolTable& table = index.Insert(0x1000, tree.BuildSymbolTable("module"));
+    REQUIRE(index.Find(0x1000) == &table);
+    REQUIRE(table.module_name == "module");
+    REQUIRE(table.named_exports.size() == symbols.size());
+
+    for (const auto& symbol : tree.Symbols()) {
+        REQUIRE(Lookup(table, symbol.name) == tree.Walk(symbol.name));
+    }
+    REQUIRE(Lookup(table, tree.Symbols()[0].name) == tree.Symbols()[0].symbol_position);
+
+    // Names that aren't exported, including ones leading to the leaf of an exported symbol
+    for (const std::string name :
+         {"", "nnroAeabiAtexi", "nnroAeabiAtexit__", "_ZN2nn", "missing"}) {
+        REQUIRE_FALSE(tree.Walk(name));
+        REQUIRE_FALSE(Lookup(table, name));
+    }
+}
+
+TEST_CASE("CROSymbolIndex tracks the loaded modules", "[core][ldr_ro]") {
+    std::mt19937 random{0x45};
+    const ExportTree first(MakeSymbols(10, random));
+    const ExportTree second(MakeSymbols(20, random));
+
+    CROSymbolIndex index;
+    REQUIRE(index.Find(0x1000) == nullptr);
+    index.Insert(0x1000, first.BuildSymbolTable("first"));
+    index.Insert(0x2000, second.BuildSymbolTable("second"));
+    REQUIRE(index.Size() == 2);
+    REQUIRE(index.Find(0x2000)->named_exports.size() == 20);
+
+    // Rebasing a module at the same address again replaces its table
+    index.Insert(0x1000, second.BuildSymbolTable("second"));
+    REQUIRE(index.Size() == 2);
+    REQUIRE(index.Find(0x1000)->module_name == "second");
+
+    index.Erase(0x1000);
+    REQUIRE(index.Find(0x1000) == nullptr);
+    REQUIRE(index.Find(0x2000) != nullptr);
+    index.Clear();
+    REQUIRE(index.Size() == 0);
+}
+
+TEST_CASE("CROSymbolIndex lookup", "[.][core][ldr_ro][benchmark]") {
+    // A game linking its modules, every import is looked up in every loaded module until found.
+    // The tree walk reads host memory here, walking it in guest memory is slower still.
+    constexpr std::size_t num_modules = 32;
+    constexpr std::size_t num_symbols = 2000;
+    std::mt19937 random{0x45};
+    std::vector<ExportTree> trees;
+    CROSymbolIndex index;
+    for (std::size_t i = 0; i < num_modules; i++) {
+        trees.emplace_back(MakeSymbols(num_symbols, random));
+        index.Insert(static_cast<VAddr>(i), trees.back().BuildSymbolTable(fmt::format("{}", i)));
+    }
+    std::vector<std::string> imports;
+    for (std::size_t i = 0; i < num_symbols; i++) {
+        imports.push_back(trees[random() % num_modules].Symbols()[random() % num_symbols].name);
+    }
+
+    const auto measure = [&](const char* method, auto&& find) {
+        std::size_t found = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const std::string& name : imports) {
+            for (std::size_t module = 0; module < num_modules; module++) {
+                if (find(module, name)) {
+                    found++;
+                    break;
+                }
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(found == imports.size());
+        fmt::print("CRO {}: resolved {} imports across {} modules in {:.3f}ms\n", method,
+                   imports.size(), num_modules, elapsed.count() * 1e3);
+    };
+    measure("tree walk", [&](std::size_t module, const std::string& name) {
+        return trees[module].Walk(name).has_value();
+    });
+    measure("symbol index", [&](std::size_t module, const std::string& name) {
+        return Lookup(*index.Find(static_cast<VAddr>(module)), name).has_value();
+    });
+}
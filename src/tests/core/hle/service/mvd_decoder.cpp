@@ -0,0 +1,194 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/hle/service/mvd/mvd_decoder.h"
+
+using namespace Service::MVD;
+
+namespace {
+
+/// A YUV 4:2:0 frame with every plane filled with a single value
+struct SolidFrame {
+    SolidFrame(u32 width_, u32 height_, u8 y, u8 u, u8 v)
+        : width{width_}, height{height_}, luma(width * height, y),
+          chroma_u(width * height / 4, u), chroma_v(width * height / 4, v) {}
+
+    YUVFrame Planes() const {
+        return {
+            .planes = {luma.data(), chroma_u.data(), chroma_v.data()},
+            .strides = {static_cast<s32>(width), static_cast<s32>(width / 2),
+                        static_cast<s32>(width / 2)},
+            .width = width,
+            .height = height,
+        };
+    }
+
+    u32 width;
+    u32 height;
+    std::vector<u8> luma;
+    std::vector<u8> chroma_u;
+    std::vector<u8> chroma_v;
+};
+
+u16 Pixel(const std::vector<u8>& output, std::size_t index) {
+    return static_cast<u16>(output[index * 2] | (output[index * 2 + 1] << 8));
+}
+
+/// Splits an Annex B byte stream at its start codes, keeping the start codes with the units.
+std::vector<std::vector<u8>> SplitNALUnits(const std::vector<u8>& stream) {
+    std::vector<std::size_t> starts;
+    for (std::size_t i = 0; i + 3 <= stream.size(); ++i) {
+        if (stream[i] == 0 && stream[i + 1] == 0 && stream[i + 2] == 1) {
+            starts.push_back(i > 0 && stream[i - 1] == 0 ? i - 1 : i);
+            i += 2;
+        }
+    }
+    starts.push_back(stream.size());
+
+    std::vector<std::vector<u8>> units;
+    for (std::size_t i = 0; i + 1 < starts.size(); ++i) {
+        units.emplace_back(stream.begin() + starts[i], stream.begin() + starts[i + 1]);
+    }
+    return units;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MVD NAL units are converted to Annex B", "[core][mvd]") {
+    SECTION("3-byte start code") {
+        const std::vector<u8> memory{0, 0, 1, 0x67, 0xAA, 0xFF};
+        const auto nal_unit = PrepareNALUnit(memory, 5);
+        REQUIRE(nal_unit);
+        REQUIRE(nal_unit->data == std::vector<u8>{0, 0, 1, 0x67, 0xAA});
+        REQUIRE(nal_unit->type == 7);
+    }
+    SECTION("4-byte start code") {
+        const std::vector<u8> memory{0, 0, 0, 1, 0x65, 0xBB};
+        const auto nal_unit = PrepareNALUnit(memory, 6);
+        REQUIRE(nal_unit);
+        REQUIRE(nal_unit->data == memory);
+        REQUIRE(nal_unit->type == 5);
+    }
+    SECTION("missing start code") {
+        const std::vector<u8> memory{0x68, 0xCC};
+        const auto nal_unit = PrepareNALUnit(memory, 2);
+        REQUIRE(nal_unit);
+        REQUIRE(nal_unit->data == std::vector<u8>{0, 0, 1, 0x68, 0xCC});
+        REQUIRE(nal_unit->type == 8);
+    }
+}
+
+TEST_CASE("MVD rejects invalid NAL units", "[core][mvd]") {
+    const std::vector<u8> memory{0, 0, 0, 1, 0x65, 0xBB};
+    // Empty units and units that are only a start code
+    REQUIRE_FALSE(PrepareNALUnit(memory, 0));
+    REQUIRE_FALSE(PrepareNALUnit(std::span{memory}.subspan(1), 3));
+    REQUIRE_FALSE(PrepareNALUnit(memory, 4));
+    // Units reaching past the end of the memory they are read from
+    REQUIRE_FALSE(PrepareNALUnit(memory, 7));
+    REQUIRE_FALSE(PrepareNALUnit(std::span<const u8>{}, 1));
+    REQUIRE_FALSE(PrepareNALUnit(memory, 0xFFFFFFFF));
+}
+
+TEST_CASE("MVD frames are converted to the output format", "[core][mvd]") {
+    std::vector<u8> output;
+
+    SECTION("YUYV422 keeps the samples of each pixel pair") {
+        SolidFrame frame(4, 2, 0, 0x80, 0x90);
+        for (std::size_t i = 0; i < frame.luma.size(); ++i) {
+            frame.luma[i] = static_cast<u8>(i);
+        }
+        frame.chroma_u = {0x80, 0x81};
+        frame.chroma_v = {0x90, 0x91};
+        ConvertFrame(frame.Planes(), OutputFormat::YUYV422, 4, 2, output);
+        REQUIRE(output == std::vector<u8>{0, 0x80, 1, 0x90, 2, 0x81, 3, 0x91, //
+                                          4, 0x80, 5, 0x90, 6, 0x81, 7, 0x91});
+    }
+
+    SECTION("RGB565 and BGR565 swap the red and blue channels") {
+        // Limited range BT.601 red
+        const SolidFrame frame(4, 2, 81, 90, 240);
+        ConvertFrame(frame.Planes(), OutputFormat::RGB565, 4, 2, output);
+        REQUIRE(output.size() == 4 * 2 * 2);
+        REQUIRE(Pixel(output, 0) == 0xF800);
+        REQUIRE(Pixel(output, 7) == 0xF800);
+
+        ConvertFrame(frame.Planes(), OutputFormat::BGR565, 4, 2, output);
+        REQUIRE(Pixel(output, 0) == 0x001F);
+    }
+
+    SECTION("frames are scaled to the output size") {
+        const SolidFrame white(16, 8, 235, 128, 128);
+        ConvertFrame(white.Planes(), OutputFormat::RGB565, 8, 2, output);
+        REQUIRE(output.size() == 8 * 2 * 2);
+        for (std::size_t i = 0; i < 8 * 2; ++i) {
+            REQUIRE(Pixel(output, i) == 0xFFFF);
+        }
+
+        const SolidFrame black(4, 4, 16, 128, 128);
+        ConvertFrame(black.Planes(), OutputFormat::RGB565, 8, 8, output);
+        REQUIRE(output.size() == 8 * 8 * 2);
+        REQUIRE(Pixel(output, 8 * 8 - 1) == 0x0000);
+    }
+}
+
+TEST_CASE("MVD frame conversion", "[.][core][mvd][benchmark]") {
+    // A Moflex sized frame, converted to the top screen size
+    const SolidFrame frame(800, 480, 81, 90, 240);
+    std::vector<u8> output;
+
+    for (const auto format : {OutputFormat::YUYV422, OutputFormat::RGB565}) {
+        constexpr int iterations = 500;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            ConvertFrame(frame.Planes(), format, 400, 240, output);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        fmt::print("MVD format 0x{:X}: {:.3f}ms per frame\n", static_cast<u32>(format),
+                   elapsed.count() * 1e3 / iterations);
+    }
+}
+
+TEST_CASE("MVD H.264 decode throughput", "[.][core][mvd][benchmark]") {
+    // Path to a raw H.264 Annex B clip, such as one extracted from a Moflex video
+    const char* path = std::getenv("CITRA_MVD_CLIP");
+    if (path == nullptr) {
+        WARN("CITRA_MVD_CLIP is not set, skipping");
+        return;
+    }
+
+    FileUtil::IOFile file(path, "rb");
+    REQUIRE(file.IsOpen());
+    std::vector<u8> stream(file.GetSize());
+    REQUIRE(file.ReadBytes(stream.data(), stream.size()) == stream.size());
+    const auto units = SplitNALUnits(stream);
+    REQUIRE(!units.empty());
+
+    for (const auto format : {OutputFormat::YUYV422, OutputFormat::RGB565}) {
+        H264Decoder decoder;
+        REQUIRE(decoder.IsValid());
+        decoder.SetOutput(format, 400, 240);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& unit : units) {
+            decoder.QueueNALUnit(unit);
+        }
+        decoder.Flush();
+        const std::chrono::duration<double> queue_time = std::chrono::steady_clock::now() - start;
+        decoder.WaitIdle();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const u64 frames = decoder.GetDecodedFrameCount();
+        fmt::print("MVD format 0x{:X}: decoded {} frames from {} NAL units in {:.3f}s, {:.1f} fps "
+                   "(queueing took {:.3f}ms)\n",
+                   static_cast<u32>(format), frames, units.size(), elapsed.count(),
+                   frames / elapsed.count(), queue_time.count() * 1e3);
+    }
+}
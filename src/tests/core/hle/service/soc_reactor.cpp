@@ -0,0 +1,157 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifndef _WIN32
+
+#include <array>
+#include <chrono>
+#include <future>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <catch2/catch_test_macros.hpp>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "core/hle/service/soc_reactor.h"
+
+using namespace std::chrono_literals;
+using Service::SOC::SocketReactor;
+
+namespace {
+
+/// Echo server on a loopback port that serves a single connection.
+class EchoServer {
+public:
+    EchoServer() {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        REQUIRE(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        REQUIRE(listen(listen_fd, 1) == 0);
+        socklen_t addr_len = sizeof(addr);
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+        port = ntohs(addr.sin_port);
+
+        thread = std::thread([this] {
+            const int client = accept(listen_fd, nullptr, nullptr);
+            std::array<char, 256> buffer;
+            ssize_t received;
+            while ((received = recv(client, buffer.data(), buffer.size(), 0)) > 0) {
+                send(client, buffer.data(), received, 0);
+            }
+            close(client);
+        });
+    }
+
+    ~EchoServer() {
+        thread.join();
+        close(listen_fd);
+    }
+
+    /// Connects a non-blocking client socket to the server.
+    int Connect() const {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+
+private:
+    int listen_fd;
+    u16 port;
+    std::thread thread;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("SocketReactor wakes up when echoed data arrives", "[core][service][soc]") {
+    EchoServer server;
+    const int fd = server.Connect();
+    SocketReactor reactor;
+
+    std::array<char, 16> buffer;
+    REQUIRE(recv(fd, buffer.data(), buffer.size(), 0) == -1);
+
+    for (int round = 0; round < 3; round++) {
+        std::promise<bool> woken;
+        reactor.Wait({{fd, true, false}}, -1ms,
+                     [&woken](bool timed_out) { woken.set_value(timed_out); });
+
+        REQUIRE(send(fd, "ping", 4, 0) == 4);
+        auto future = woken.get_future();
+        REQUIRE(future.wait_for(5s) == std::future_status::ready);
+        REQUIRE_FALSE(future.get());
+
+        REQUIRE(recv(fd, buffer.data(), buffer.size(), 0) == 4);
+        REQUIRE(std::string_view(buffer.data(), 4) == "ping");
+    }
+
+    close(fd);
+}
+
+TEST_CASE("SocketReactor only wakes up for the requested readiness", "[core][service][soc]") {
+    EchoServer server;
+    const int fd = server.Connect();
+    SocketReactor reactor;
+
+    // The socket is writable right away but nothing has been received yet.
+    std::promise<bool> read_woken;
+    reactor.Wait({{fd, true, false}}, 100ms,
+                 [&read_woken](bool timed_out) { read_woken.set_value(timed_out); });
+    std::promise<bool> write_woken;
+    reactor.Wait({{fd, false, true}}, -1ms,
+                 [&write_woken](bool timed_out) { write_woken.set_value(timed_out); });
+
+    auto write_future = write_woken.get_future();
+    REQUIRE(write_future.wait_for(5s) == std::future_status::ready);
+    REQUIRE_FALSE(write_future.get());
+
+    auto read_future = read_woken.get_future();
+    REQUIRE(read_future.wait_for(5s) == std::future_status::ready);
+    REQUIRE(read_future.get());
+
+    close(fd);
+}
+
+TEST_CASE("SocketReactor cancels waits on a closing socket", "[core][service][soc]") {
+    EchoServer server;
+    const int fd = server.Connect();
+    SocketReactor reactor;
+
+    std::promise<bool> woken;
+    reactor.Wait({{fd, true, false}}, -1ms,
+                 [&woken](bool timed_out) { woken.set_value(timed_out); });
+    reactor.Cancel(fd);
+
+    auto future = woken.get_future();
+    REQUIRE(future.wait_for(0s) == std::future_status::ready);
+    REQUIRE_FALSE(future.get());
+
+    close(fd);
+}
+
+TEST_CASE("SocketReactor completes waits without sockets on its thread", "[core][service][soc]") {
+    // SOC_U relies on this to defer work until after a savestate has been loaded.
+    SocketReactor reactor;
+    std::promise<std::pair<bool, std::thread::id>> woken;
+    reactor.Wait({}, 0ms, [&woken](bool timed_out) {
+        woken.set_value({timed_out, std::this_thread::get_id()});
+    });
+
+    auto future = woken.get_future();
+    REQUIRE(future.wait_for(5s) == std::future_status::ready);
+    const auto [timed_out, thread_id] = future.get();
+    REQUIRE(timed_out);
+    REQUIRE(thread_id != std::this_thread::get_id());
+}
+
+#endif // _WIN32
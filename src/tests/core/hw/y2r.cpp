@@ -0,0 +1,158 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/color.h"
+#include "common/thread_worker.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+
+using namespace Service::Y2R;
+
+namespace {
+
+constexpr VAddr base_address = 0x10000000;
+constexpr u32 input_size = 0x200000;
+constexpr u32 buffer_size = 0x800000;
+constexpr VAddr output_address = base_address + input_size;
+
+/// Maps a buffer holding random YUV planes followed by space for the output.
+struct Y2RFixture {
+    Y2RFixture() : mem{std::make_shared<BufferMem>(buffer_size)}, buffer{mem} {
+        process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+        process->vm_manager.MapBackingMemory(base_address, buffer, buffer_size,
+                                             Kernel::MemoryState::Private);
+        memory.SetCurrentPageTable(process->vm_manager.page_table);
+
+        u32 seed = 0x12345678;
+        std::generate(buffer.GetPtr(), buffer.GetPtr() + input_size, [&seed] {
+            seed = seed * 1664525 + 1013904223;
+            return static_cast<u8>(seed >> 24);
+        });
+    }
+
+    /// Returns a configuration converting a 4:2:0 image from the start of the buffer.
+    static ConversionConfiguration MakeConfig(u16 width, u16 height, OutputFormat format) {
+        ConversionConfiguration cvt{};
+        cvt.input_format = InputFormat::YUV420_Indiv8;
+        cvt.output_format = format;
+        cvt.rotation = Rotation::None;
+        cvt.block_alignment = BlockAlignment::Linear;
+        REQUIRE(cvt.SetInputLineWidth(width) == RESULT_SUCCESS);
+        REQUIRE(cvt.SetInputLines(height) == RESULT_SUCCESS);
+        REQUIRE(cvt.SetStandardCoefficient(StandardCoefficient::ITU_Rec601) == RESULT_SUCCESS);
+        cvt.alpha = 0xFF;
+
+        const u32 size = width * height;
+        cvt.src_Y = {base_address, size, width, 0};
+        cvt.src_U = {base_address + size, size / 4, static_cast<u16>(width / 2), 0};
+        cvt.src_V = {base_address + size + size / 4, size / 4, static_cast<u16>(width / 2), 0};
+        cvt.src_YUYV = {base_address, size * 2, static_cast<u16>(width * 2), 0};
+        const u16 pixel_size = format == OutputFormat::RGBA8  ? 4
+                               : format == OutputFormat::RGB8 ? 3
+                                                              : 2;
+        cvt.dst = {output_address, size * pixel_size, static_cast<u16>(width * pixel_size), 0};
+        return cvt;
+    }
+
+    /// Runs a conversion and returns the output
+    std::vector<u8> Convert(ConversionConfiguration cvt, Common::ThreadWorker* workers) {
+        std::fill(buffer.GetPtr() + input_size, buffer.GetPtr() + buffer_size, 0);
+        const u32 output_size = cvt.dst.image_size;
+        HW::Y2R::PerformConversion(memory, cvt, workers);
+        const u8* output = buffer.GetPtr() + input_size;
+        return std::vector<u8>(output, output + output_size);
+    }
+
+    Core::Timing timing{1, 100};
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel{memory, timing, [] {}, 0, 1, 0};
+    std::shared_ptr<Kernel::Process> process;
+    std::shared_ptr<BufferMem> mem;
+    MemoryRef buffer;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("Y2R conversion matches the reference formula", "[core][y2r]") {
+    Y2RFixture fixture;
+    constexpr u16 width = 64;
+    constexpr u16 height = 24;
+    const auto cvt = Y2RFixture::MakeConfig(width, height, OutputFormat::RGBA8);
+
+    std::vector<u8> expected(width * height * 4);
+    const u8* input_Y = fixture.buffer.GetPtr();
+    const u8* input_U = input_Y + width * height;
+    const u8* input_V = input_U + width * height / 4;
+    const auto& c = cvt.coefficients;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const s32 Y = input_Y[y * width + x];
+            const s32 U = input_U[(y / 2) * (width / 2) + x / 2];
+            const s32 V = input_V[(y / 2) * (width / 2) + x / 2];
+            const s32 r = ((c[0] * Y + c[1] * V) >> 3) + c[5] + 0x18;
+            const s32 g = ((c[0] * Y - c[2] * V - c[3] * U) >> 3) + c[6] + 0x18;
+            const s32 b = ((c[0] * Y + c[4] * U) >> 3) + c[7] + 0x18;
+            const Common::Vec4<u8> color{static_cast<u8>(std::clamp(r >> 5, 0, 0xFF)),
+                                         static_cast<u8>(std::clamp(g >> 5, 0, 0xFF)),
+                                         static_cast<u8>(std::clamp(b >> 5, 0, 0xFF)), 0xFF};
+            Common::Color::EncodeRGBA8(color, &expected[(y * width + x) * 4]);
+        }
+    }
+
+    Common::ThreadWorker workers(4, "Y2R test");
+    CHECK(fixture.Convert(cvt, nullptr) == expected);
+    CHECK(fixture.Convert(cvt, &workers) == expected);
+}
+
+TEST_CASE("Y2R threaded conversion keeps the strip order", "[core][y2r]") {
+    Y2RFixture fixture;
+    Common::ThreadWorker workers(3, "Y2R test");
+
+    for (const auto rotation : {Rotation::None, Rotation::Clockwise_90, Rotation::Clockwise_180,
+                                Rotation::Clockwise_270}) {
+        for (const auto alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+            auto cvt = Y2RFixture::MakeConfig(136, 80, OutputFormat::RGB565);
+            cvt.input_format = InputFormat::YUYV422_Interleaved;
+            cvt.rotation = rotation;
+            cvt.block_alignment = alignment;
+            CHECK(fixture.Convert(cvt, nullptr) == fixture.Convert(cvt, &workers));
+        }
+    }
+}
+
+TEST_CASE("Y2R conversion throughput", "[.][core][y2r][benchmark]") {
+    Y2RFixture fixture;
+    Common::ThreadWorker workers(4, "Y2R benchmark");
+    constexpr u16 width = 400;
+    constexpr u16 height = 240;
+    constexpr int iterations = 500;
+
+    for (const auto format : {OutputFormat::RGB565, OutputFormat::RGB8, OutputFormat::RGBA8}) {
+        for (const bool threaded : {false, true}) {
+            const auto cvt = Y2RFixture::MakeConfig(width, height, format);
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                auto frame_cvt = cvt;
+                HW::Y2R::PerformConversion(fixture.memory, frame_cvt,
+                                           threaded ? &workers : nullptr);
+            }
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            fmt::print("Y2R {}x{} YUV420 -> format {} threaded={}: {:.3f}ms per frame, {:.1f} "
+                       "Mpixel/s\n",
+                       width, height, static_cast<int>(format), threaded,
+                       elapsed.count() * 1e3 / iterations,
+                       width * height * iterations / elapsed.count() / 1e6);
+        }
+    }
+}
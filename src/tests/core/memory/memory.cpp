@@ -2,7 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
 #include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
 #include "core/core_timing.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
@@ -52,3 +57,141 @@ TEST_CASE("memory.IsValidVirtualAddress", "[core][memory]") {
         CHECK(memory.IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("memory.DirtyTracking", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    memory.MapMemoryRegion(*process->vm_manager.page_table, Memory::LINEAR_HEAP_VADDR,
+                           4 * Memory::CITRA_PAGE_SIZE, memory.GetFCRAMRef(0));
+    memory.SetCurrentPageTable(process->vm_manager.page_table);
+
+    constexpr PAddr page0 = Memory::FCRAM_PADDR;
+    constexpr PAddr page1 = Memory::FCRAM_PADDR + Memory::CITRA_PAGE_SIZE;
+    constexpr PAddr page2 = Memory::FCRAM_PADDR + 2 * Memory::CITRA_PAGE_SIZE;
+    constexpr u32 range = 4 * Memory::CITRA_PAGE_SIZE;
+
+    SECTION("writes are ignored while tracking is disabled") {
+        memory.Write32(Memory::LINEAR_HEAP_VADDR, 0xDEADBEEF);
+        memory.SetDirtyTracking(true);
+        CHECK(memory.GetAndClearDirtyPages(page0, range).empty());
+    }
+
+    SECTION("writes mark the pages they touch") {
+        memory.SetDirtyTracking(true);
+        memory.Write32(Memory::LINEAR_HEAP_VADDR + 0x10, 0xDEADBEEF);
+        memory.Write8(Memory::LINEAR_HEAP_VADDR + 2 * Memory::CITRA_PAGE_SIZE, 0xFF);
+        CHECK(memory.GetAndClearDirtyPages(page0, range) == std::vector<PAddr>{page0, page2});
+        CHECK(memory.GetAndClearDirtyPages(page0, range).empty());
+    }
+
+    SECTION("exclusive writes only mark pages when they succeed") {
+        memory.Write32(Memory::LINEAR_HEAP_VADDR, 1);
+        memory.SetDirtyTracking(true);
+        CHECK_FALSE(memory.WriteExclusive32(Memory::LINEAR_HEAP_VADDR, 3, 2));
+        CHECK(memory.GetAndClearDirtyPages(page0, range).empty());
+        CHECK(memory.WriteExclusive32(Memory::LINEAR_HEAP_VADDR, 3, 1));
+        CHECK(memory.GetAndClearDirtyPages(page0, range) == std::vector<PAddr>{page0});
+    }
+
+    SECTION("block writes mark every page in the range") {
+        memory.SetDirtyTracking(true);
+        const std::vector<u8> data(Memory::CITRA_PAGE_SIZE, 0xAB);
+        memory.WriteBlock(*process, Memory::LINEAR_HEAP_VADDR + 0x800, data.data(), data.size());
+        CHECK(memory.GetAndClearDirtyPages(page0, range) == std::vector<PAddr>{page0, page1});
+
+        memory.ZeroBlock(*process, Memory::LINEAR_HEAP_VADDR + 2 * Memory::CITRA_PAGE_SIZE, 4);
+        memory.CopyBlock(*process, Memory::LINEAR_HEAP_VADDR + Memory::CITRA_PAGE_SIZE,
+                         Memory::LINEAR_HEAP_VADDR, 4);
+        CHECK(memory.GetAndClearDirtyPages(page0, range) == std::vector<PAddr>{page1, page2});
+    }
+
+    SECTION("only the queried range is cleared") {
+        memory.SetDirtyTracking(true);
+        memory.MarkRegionDirty(page0, range);
+        CHECK(memory.GetAndClearDirtyPages(page1, 1) == std::vector<PAddr>{page1});
+        CHECK(memory.GetAndClearDirtyPages(page0, range).size() == 3);
+    }
+
+    SECTION("disabling tracking clears the bitmap") {
+        memory.SetDirtyTracking(true);
+        memory.Write32(Memory::LINEAR_HEAP_VADDR, 0xDEADBEEF);
+        memory.SetDirtyTracking(false);
+        memory.SetDirtyTracking(true);
+        CHECK(memory.GetAndClearDirtyPages(page0, range).empty());
+    }
+}
+
+TEST_CASE("memory.BlockOperations", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    auto& page_table = *process->vm_manager.page_table;
+
+    // Back the middle page with memory that is not contiguous with its neighbours, so that block
+    // operations have to split the range.
+    constexpr VAddr base = Memory::LINEAR_HEAP_VADDR;
+    constexpr u32 page_size = Memory::CITRA_PAGE_SIZE;
+    memory.MapMemoryRegion(page_table, base, page_size, memory.GetFCRAMRef(0));
+    memory.MapMemoryRegion(page_table, base + page_size, page_size,
+                           memory.GetFCRAMRef(8 * page_size));
+    memory.MapMemoryRegion(page_table, base + 2 * page_size, page_size,
+                           memory.GetFCRAMRef(2 * page_size));
+
+    std::vector<u8> data(3 * page_size - 0x20);
+    std::iota(data.begin(), data.end(), u8{0});
+    memory.WriteBlock(*process, base + 0x10, data.data(), data.size());
+    CHECK(*memory.GetFCRAMPointer(8 * page_size) == data[page_size - 0x10]);
+
+    std::vector<u8> read(data.size());
+    memory.ReadBlock(*process, base + 0x10, read.data(), read.size());
+    CHECK(read == data);
+
+    memory.ZeroBlock(*process, base + page_size - 4, 8);
+    memory.ReadBlock(*process, base + 0x10, read.data(), read.size());
+    CHECK(std::all_of(read.begin() + page_size - 0x14, read.begin() + page_size - 0xC,
+                      [](u8 value) { return value == 0; }));
+    CHECK(read[page_size - 0xC] == data[page_size - 0xC]);
+
+    memory.CopyBlock(*process, base + 2 * page_size, base, page_size);
+    CHECK(std::memcmp(memory.GetFCRAMPointer(2 * page_size), memory.GetFCRAMPointer(0),
+                      page_size) == 0);
+}
+
+TEST_CASE("memory.BlockOperations benchmark", "[.][core][memory][benchmark]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    constexpr u32 region_size = 16 * 1024 * 1024;
+    constexpr VAddr src = Memory::LINEAR_HEAP_VADDR;
+    constexpr VAddr dest = Memory::LINEAR_HEAP_VADDR + region_size / 2;
+    memory.MapMemoryRegion(*process->vm_manager.page_table, src, region_size,
+                           memory.GetFCRAMRef(0));
+
+    std::vector<u8> buffer(region_size / 2);
+    for (const u32 size : {0x100u, 0x1000u, 0x10000u, 4u * 1024 * 1024}) {
+        const std::size_t iterations = std::max<std::size_t>(1, 256 * 1024 * 1024 / size);
+        const auto Measure = [&](std::string_view name, auto&& func) {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < iterations; i++) {
+                func();
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            fmt::print("{:>10} {:>8} bytes: {:8.1f} ns/op, {:8.1f} MiB/s\n", name, size,
+                       elapsed.count() * 1e9 / iterations,
+                       iterations * size / elapsed.count() / (1024 * 1024));
+        };
+
+        Measure("ReadBlock", [&] { memory.ReadBlock(*process, src, buffer.data(), size); });
+        Measure("WriteBlock", [&] { memory.WriteBlock(*process, dest, buffer.data(), size); });
+        Measure("CopyBlock", [&] { memory.CopyBlock(*process, dest, src, size); });
+        Measure("ZeroBlock", [&] { memory.ZeroBlock(*process, dest, size); });
+    }
+}
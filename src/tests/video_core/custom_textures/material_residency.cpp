@@ -0,0 +1,110 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/frontend/image_interface.h"
+#include "video_core/custom_textures/material.h"
+#include "video_core/custom_textures/material_residency.h"
+
+using namespace VideoCore;
+
+namespace {
+
+constexpr u64 TextureSize = 100;
+
+/// Builds decoded materials with a single color map of TextureSize bytes.
+class MaterialSet {
+public:
+    Material* Add(u64 last_used, DecodeState state = DecodeState::Decoded) {
+        auto& texture = textures.emplace_back(std::make_unique<CustomTexture>(image_interface));
+        texture->type = MapType::Color;
+        texture->hashes = {static_cast<u64>(textures.size())};
+        texture->data.resize(TextureSize);
+
+        Material& material = materials.emplace_back();
+        material.size = TextureSize;
+        material.last_used = last_used;
+        material.state = state;
+        material.AddMapTexture(texture.get());
+        return &material;
+    }
+
+private:
+    Frontend::ImageInterface image_interface;
+    std::vector<std::unique_ptr<CustomTexture>> textures;
+    std::deque<Material> materials;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("MaterialResidency evicts least recently used materials",
+          "[video_core][custom_textures]") {
+    constexpr u64 current_frame = 5;
+    MaterialSet set;
+    MaterialResidency residency{3 * TextureSize};
+
+    Material* const oldest = set.Add(1);
+    Material* const old = set.Add(2);
+    Material* const recent = set.Add(3);
+    Material* const current = set.Add(current_frame);
+    Material* const uploading = set.Add(0);
+    Material* const shared = set.Add(0);
+    shared->Map(MapType::Color)->hashes.push_back(0xCAFEBABE);
+    Material* const packed = set.Add(0);
+    const std::array<u8, TextureSize> pack_file{};
+    packed->Map(MapType::Color)->packed_data = pack_file;
+    Material* const pending = set.Add(0, DecodeState::Pending);
+
+    const std::array materials{oldest, old, recent, current, uploading, shared, packed, pending};
+    for (Material* const material : materials) {
+        residency.Track(material);
+    }
+    const auto is_uploading = [uploading](const Material* material) {
+        return material == uploading;
+    };
+
+    residency.Update(current_frame, is_uploading);
+
+    // Shared and packed materials do not count against the budget and are never unloaded.
+    REQUIRE(residency.ResidentBytes() == 3 * TextureSize);
+    REQUIRE(residency.EvictedBytes() == 2 * TextureSize);
+    REQUIRE(oldest->IsUnloaded());
+    REQUIRE(oldest->Map(MapType::Color)->data.empty());
+    REQUIRE(old->IsUnloaded());
+    for (Material* const material : {recent, current, uploading, shared, packed}) {
+        REQUIRE(material->IsDecoded());
+        REQUIRE(material->size == TextureSize);
+    }
+    REQUIRE(pending->IsPending());
+
+    SECTION("materials are accounted once decoded") {
+        pending->last_used = current_frame;
+        pending->state = DecodeState::Decoded;
+        residency.Update(current_frame, is_uploading);
+        REQUIRE(residency.ResidentBytes() == 3 * TextureSize);
+        REQUIRE(residency.EvictedBytes() == 3 * TextureSize);
+        REQUIRE(recent->IsUnloaded());
+        REQUIRE(pending->IsDecoded());
+    }
+
+    SECTION("materials used this frame or uploading are kept over the budget") {
+        pending->last_used = current_frame + 1;
+        pending->state = DecodeState::Decoded;
+        residency.Update(current_frame + 1, [](const Material*) { return true; });
+        REQUIRE(residency.ResidentBytes() == 4 * TextureSize);
+        REQUIRE(residency.EvictedBytes() == 2 * TextureSize);
+
+        residency.Update(current_frame + 1, [](const Material*) { return false; });
+        REQUIRE(residency.ResidentBytes() == 3 * TextureSize);
+        REQUIRE(residency.EvictedBytes() == 3 * TextureSize);
+        REQUIRE(uploading->IsUnloaded());
+        REQUIRE(recent->IsDecoded());
+        REQUIRE(pending->IsDecoded());
+    }
+}
@@ -0,0 +1,170 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/frontend/image_interface.h"
+#include "video_core/custom_textures/texture_pack.h"
+
+using namespace VideoCore;
+
+namespace {
+
+std::string MakeTempDirectory(std::string_view name) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    return path.string() + '/';
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Packed textures round trip", "[video_core][custom_textures]") {
+    const std::string load_path = MakeTempDirectory("citra_texture_pack_test");
+    Frontend::ImageInterface image_interface;
+
+    // Two rows of 2x2 RGBA8 pixels, stored flipped by the packer.
+    const std::vector<u8> color = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    const std::vector<u8> normal(16, 0x80);
+    REQUIRE(image_interface.EncodePNG(load_path + "tex1_2x2_00000000DEADBEEF_12.png", 2, 2, color));
+    REQUIRE(image_interface.EncodePNG(load_path + "tex1_2x2_00000000DEADBEEF_12.norm.png", 2, 2,
+                                      normal));
+    REQUIRE(FileUtil::WriteStringToFile(true, load_path + "pack.json", R"({
+        "options": {"skip_mipmap": false, "flip_png_files": true, "use_new_hash": true},
+        "textures": {"00000000CAFEBABE": "tex1_2x2_00000000DEADBEEF_12.png"}
+    })") != 0);
+
+    const std::string pack_path = load_path + std::string{PACKED_TEXTURES_FILE};
+    REQUIRE(WritePackedTextures(load_path, pack_path, image_interface));
+
+    PackedTextures packed;
+    REQUIRE(packed.Open(pack_path));
+    REQUIRE_FALSE(packed.SkipMipmaps());
+    REQUIRE(packed.UseNewHash());
+
+    const auto entries = packed.Entries();
+    REQUIRE(entries.size() == 3);
+    REQUIRE(entries[0].hash == 0xCAFEBABE);
+    REQUIRE(entries[1].hash == 0xDEADBEEF);
+    REQUIRE(entries[1].map_type == static_cast<u32>(MapType::Color));
+    REQUIRE(entries[2].hash == 0xDEADBEEF);
+    REQUIRE(entries[2].map_type == static_cast<u32>(MapType::Normal));
+
+    const std::vector<u8> flipped = {9, 10, 11, 12, 13, 14, 15, 16, 1, 2, 3, 4, 5, 6, 7, 8};
+    for (const PackedEntry& entry : entries) {
+        REQUIRE(entry.width == 2);
+        REQUIRE(entry.height == 2);
+        REQUIRE(entry.format == static_cast<u32>(CustomPixelFormat::RGBA8));
+        const auto data = packed.Data(entry);
+        const bool is_color = entry.map_type == static_cast<u32>(MapType::Color);
+        const auto& expected = is_color ? flipped : normal;
+        REQUIRE(std::equal(data.begin(), data.end(), expected.begin(), expected.end()));
+    }
+
+    // Anything that is not a packed texture file is rejected.
+    REQUIRE_FALSE(PackedTextures{}.Open(load_path + "pack.json"));
+
+    std::filesystem::remove_all(load_path);
+}
+
+TEST_CASE("Packed texture entries must hold their texture", "[video_core][custom_textures]") {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "citra_texture_pack_entries.ctp").string();
+
+    // A file with 64 bytes of texture data and a single entry referring to it.
+    const auto open_with_entry = [&path](CustomPixelFormat format, u32 width, u32 height,
+                                         u64 size) {
+        const PackedHeader header{
+            .magic = PackedHeader::MAGIC,
+            .version = PackedHeader::VERSION,
+            .flags = 0,
+            .num_entries = 1,
+            .index_offset = sizeof(PackedHeader) + 64,
+        };
+        const PackedEntry entry{
+            .hash = 0xDEADBEEF,
+            .map_type = static_cast<u32>(MapType::Color),
+            .format = static_cast<u32>(format),
+            .width = width,
+            .height = height,
+            .offset = sizeof(PackedHeader),
+            .size = size,
+        };
+        const std::vector<u8> data(64);
+        {
+            FileUtil::IOFile file{path, "wb"};
+            REQUIRE(file.WriteObject(header) == 1);
+            REQUIRE(file.WriteBytes(data.data(), data.size()) == data.size());
+            REQUIRE(file.WriteObject(entry) == 1);
+        }
+        return PackedTextures{}.Open(path);
+    };
+
+    REQUIRE(open_with_entry(CustomPixelFormat::RGBA8, 4, 4, 64));
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::RGBA8, 4, 5, 64));
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::RGBA8, 2, 2, 0));
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::RGBA8, 0, 0, 0));
+    // Compressed formats are stored in whole blocks.
+    REQUIRE(open_with_entry(CustomPixelFormat::BC1, 8, 8, 32));
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::BC1, 9, 8, 32));
+    REQUIRE(open_with_entry(CustomPixelFormat::BC7, 4, 4, 16));
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::ASTC6, 12, 8, 32));
+    // Data past the end of the file.
+    REQUIRE_FALSE(open_with_entry(CustomPixelFormat::RGBA8, 4, 4, 128));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Packed texture loading", "[.][video_core][custom_textures][benchmark]") {
+    constexpr std::size_t num_textures = 1000;
+    const std::string load_path = MakeTempDirectory("citra_texture_pack_bench");
+    Frontend::ImageInterface image_interface;
+    const std::vector<u8> pixels(16 * 16 * 4, 0x80);
+    for (std::size_t i = 0; i < num_textures; i++) {
+        const std::string name = fmt::format("tex1_16x16_{:016X}_12.png", i + 1);
+        REQUIRE(image_interface.EncodePNG(load_path + name, 16, 16, pixels));
+    }
+
+    // What loading a pack directory costs before any texture is decoded.
+    auto start = std::chrono::steady_clock::now();
+    const PackConfig config = ReadPackConfig(load_path);
+    FileUtil::FSTEntry texture_dir;
+    std::vector<FileUtil::FSTEntry> files;
+    FileUtil::ScanDirectoryTree(load_path, texture_dir, 64);
+    FileUtil::GetAllFilesFromNestedEntries(texture_dir, files);
+    std::size_t num_parsed = 0;
+    for (const FileUtil::FSTEntry& file : files) {
+        CustomTexture texture{image_interface};
+        num_parsed += !file.isDirectory && ParseTextureFilename(config, file, &texture);
+    }
+    const std::chrono::duration<double> scan_time = std::chrono::steady_clock::now() - start;
+    REQUIRE(num_parsed == num_textures);
+
+    const std::string pack_path = load_path + std::string{PACKED_TEXTURES_FILE};
+    start = std::chrono::steady_clock::now();
+    REQUIRE(WritePackedTextures(load_path, pack_path, image_interface));
+    const std::chrono::duration<double> pack_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    PackedTextures packed;
+    REQUIRE(packed.Open(pack_path));
+    u64 total_size = 0;
+    for (const PackedEntry& entry : packed.Entries()) {
+        total_size += packed.Data(entry).size();
+    }
+    const std::chrono::duration<double> open_time = std::chrono::steady_clock::now() - start;
+    REQUIRE(packed.Entries().size() == num_textures);
+
+    fmt::print("Texture pack with {} textures: directory scan {:.3f}ms, packing {:.3f}s, packed "
+               "file open {:.3f}ms ({} KiB)\n",
+               num_textures, scan_time.count() * 1e3, pack_time.count(), open_time.count() * 1e3,
+               total_size >> 10);
+    std::filesystem::remove_all(load_path);
+}
@@ -0,0 +1,67 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/custom_textures/usage_history.h"
+
+using VideoCore::TextureUsageHistory;
+
+namespace {
+
+bool Contains(std::span<const u64> hashes, u64 hash) {
+    return std::find(hashes.begin(), hashes.end(), hash) != hashes.end();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TextureUsageHistory links textures of nearby frames", "[video_core][custom_textures]") {
+    TextureUsageHistory history;
+    history.Record(1);
+    history.Record(2);
+    history.EndFrame();
+    history.Record(3);
+    history.EndFrame();
+    history.EndFrame();
+    history.Record(4);
+    history.EndFrame();
+
+    REQUIRE(Contains(history.Next(1), 2));
+    REQUIRE(Contains(history.Next(1), 3));
+    REQUIRE(Contains(history.Next(2), 1));
+    REQUIRE_FALSE(Contains(history.Next(1), 1));
+    // Textures of frames further apart are not linked.
+    REQUIRE(history.Next(3).empty());
+    REQUIRE_FALSE(Contains(history.Next(1), 4));
+
+    for (u64 hash = 100; hash < 100 + 2 * TextureUsageHistory::MAX_LINKS; hash++) {
+        history.Record(hash);
+    }
+    history.EndFrame();
+    REQUIRE(history.Next(100).size() == TextureUsageHistory::MAX_LINKS - 1);
+    REQUIRE(history.Next(163).size() == TextureUsageHistory::MAX_LINKS);
+}
+
+TEST_CASE("TextureUsageHistory is saved and loaded", "[video_core][custom_textures]") {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "citra_texture_usage_test.bin").string();
+    std::filesystem::remove(path);
+
+    TextureUsageHistory history;
+    REQUIRE_FALSE(history.Load(path));
+    history.Record(0xDEADBEEF);
+    history.Record(0xCAFEBABE);
+    history.EndFrame();
+    REQUIRE(history.Save(path));
+
+    TextureUsageHistory loaded;
+    REQUIRE(loaded.Load(path));
+    REQUIRE(loaded.Size() == 2);
+    REQUIRE(Contains(loaded.Next(0xDEADBEEF), 0xCAFEBABE));
+    REQUIRE(Contains(loaded.Next(0xCAFEBABE), 0xDEADBEEF));
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,120 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/geometry_shader_batch.h"
+
+using Pica::GeometryShaderBatch;
+using Pica::Shader::AttributeBuffer;
+using Pica::float24;
+
+namespace {
+
+/**
+ * Emits the number of triangles given by the x component of input 0, with vertices made from the
+ * invocation index in input 1 and from b15, and sets the winding before every second triangle.
+ */
+class TriangleEngine final : public Pica::Shader::ShaderEngine {
+public:
+    explicit TriangleEngine(bool input_to_uniform_) : input_to_uniform{input_to_uniform_} {}
+
+    void SetupBatch(Pica::Shader::ShaderSetup& setup, unsigned int entry_point) override {}
+
+    void Run(const Pica::Shader::ShaderSetup& setup,
+             Pica::Shader::UnitState& state) const override {
+        const auto input = [&](int index) {
+            return input_to_uniform ? setup.uniforms.f[index] : state.registers.input[index];
+        };
+        const int num_triangles = static_cast<int>(input(0).x.ToFloat32());
+        const float24 invocation = input(1).x;
+        auto& handlers = *state.emitter_ptr->handlers;
+        for (int triangle = 0; triangle < num_triangles; triangle++) {
+            if (triangle % 2 == 1) {
+                handlers.winding_setter();
+            }
+            for (int vertex = 0; vertex < 3; vertex++) {
+                AttributeBuffer output{};
+                output.attr[0].x = invocation;
+                output.attr[0].y = float24::FromFloat32(static_cast<float>(triangle * 3 + vertex));
+                output.attr[0].z = float24::FromFloat32(setup.uniforms.b[15] ? 1.0f : 0.0f);
+                handlers.vertex_handler(output);
+            }
+        }
+    }
+
+private:
+    bool input_to_uniform;
+};
+
+/// An emitted vertex, or a winding call when winding is set
+struct Emitted {
+    bool winding;
+    float invocation;
+    float index;
+    float b15;
+
+    bool operator==(const Emitted&) const = default;
+};
+
+/// Queues count invocations as the geometry pipeline does, running them in a few batches.
+std::vector<Emitted> RunBatch(std::size_t count, bool input_to_uniform, bool parallel) {
+    std::vector<Emitted> emitted;
+    Pica::Shader::ShaderSetup setup;
+    Pica::Shader::GSUnitState unit;
+    unit.SetVertexHandler(
+        [&emitted](const AttributeBuffer& vertex) {
+            emitted.push_back({false, vertex.attr[0].x.ToFloat32(), vertex.attr[0].y.ToFloat32(),
+                               vertex.attr[0].z.ToFloat32()});
+        },
+        [&emitted] { emitted.push_back({true, 0.0f, 0.0f, 0.0f}); });
+
+    const TriangleEngine engine(input_to_uniform);
+    GeometryShaderBatch batch;
+    setup.uniforms.b[15] = false;
+    for (std::size_t i = 0; i < count; i++) {
+        auto& num_triangles = input_to_uniform ? setup.uniforms.f[0] : unit.registers.input[0];
+        auto& invocation = input_to_uniform ? setup.uniforms.f[1] : unit.registers.input[1];
+        num_triangles.x = float24::FromFloat32(static_cast<float>(i % 4 + 1));
+        if (i % 100 == 50) {
+            // Flush with a primitive left unfinished, the inputs it got so far have to be kept
+            batch.Run(engine, setup, unit, parallel);
+        }
+        invocation.x = float24::FromFloat32(static_cast<float>(i));
+        batch.Queue(setup, unit, input_to_uniform);
+        // Only the first invocation after a draw starts sees b15 unset
+        setup.uniforms.b[15] = true;
+        if (batch.IsFull()) {
+            batch.Run(engine, setup, unit, parallel);
+        }
+    }
+    batch.Run(engine, setup, unit, parallel);
+    REQUIRE(batch.IsEmpty());
+    REQUIRE(setup.uniforms.b[15]);
+    return emitted;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GeometryShaderBatch runs invocations in submission order", "[video_core]") {
+    for (const bool input_to_uniform : {true, false}) {
+        for (const std::size_t count : {1, 63, 64, 200, 512, 700}) {
+            const std::vector<Emitted> serial = RunBatch(count, input_to_uniform, false);
+
+            // Every invocation emits its own triangles, with b15 only unset for the first one
+            std::size_t expected_size = 0;
+            for (std::size_t i = 0; i < count; i++) {
+                const std::size_t num_triangles = i % 4 + 1;
+                expected_size += num_triangles * 3 + num_triangles / 2;
+            }
+            REQUIRE(serial.size() == expected_size);
+            REQUIRE(serial.front() == Emitted{false, 0.0f, 0.0f, 0.0f});
+            REQUIRE(serial.back() == Emitted{false, static_cast<float>(count - 1),
+                                             static_cast<float>(((count - 1) % 4 + 1) * 3 - 1),
+                                             count > 1 ? 1.0f : 0.0f});
+
+            REQUIRE(RunBatch(count, input_to_uniform, true) == serial);
+        }
+    }
+}
@@ -0,0 +1,183 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "video_core/regs.h"
+#include "video_core/renderer_opengl/gl_shader_decompiler.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+using namespace OpenGL;
+using TevStageConfig = Pica::TexturingRegs::TevStageConfig;
+
+namespace {
+
+/// Sets up a stage computing texture0 * primary color, with the alpha taken from the constant.
+void SetupModulateStage(TevStageConfig& stage) {
+    stage.color_source1.Assign(TevStageConfig::Source::Texture0);
+    stage.color_source2.Assign(TevStageConfig::Source::PrimaryColor);
+    stage.alpha_source1.Assign(TevStageConfig::Source::Constant);
+    stage.color_op.Assign(TevStageConfig::Operation::Modulate);
+    stage.alpha_op.Assign(TevStageConfig::Operation::Replace);
+}
+
+/// Sets up a stage passing the previous stage output through, which generates no code.
+void SetupPassThroughStage(TevStageConfig& stage) {
+    stage.color_source1.Assign(TevStageConfig::Source::Previous);
+    stage.alpha_source1.Assign(TevStageConfig::Source::Previous);
+}
+
+/// Builds a stage with random sources, modifiers and operations.
+TevStageConfig RandomStage(std::mt19937& random) {
+    using Source = TevStageConfig::Source;
+    using ColorModifier = TevStageConfig::ColorModifier;
+    constexpr std::array sources{Source::PrimaryColor,    Source::PrimaryFragmentColor,
+                                 Source::Texture0,        Source::Texture1,
+                                 Source::Texture2,        Source::PreviousBuffer,
+                                 Source::Constant,        Source::Previous};
+    constexpr std::array color_modifiers{
+        ColorModifier::SourceColor, ColorModifier::OneMinusSourceColor,
+        ColorModifier::SourceAlpha, ColorModifier::OneMinusSourceAlpha,
+        ColorModifier::SourceRed,   ColorModifier::SourceGreen,
+        ColorModifier::SourceBlue,
+    };
+    const auto pick = [&random](const auto& values) {
+        return values[random() % values.size()];
+    };
+
+    TevStageConfig stage{};
+    stage.color_source1.Assign(pick(sources));
+    stage.color_source2.Assign(pick(sources));
+    stage.color_source3.Assign(pick(sources));
+    stage.alpha_source1.Assign(pick(sources));
+    stage.alpha_source2.Assign(pick(sources));
+    stage.alpha_source3.Assign(pick(sources));
+    stage.color_modifier1.Assign(pick(color_modifiers));
+    stage.color_modifier2.Assign(pick(color_modifiers));
+    stage.alpha_modifier1.Assign(static_cast<TevStageConfig::AlphaModifier>(random() % 8));
+    stage.alpha_modifier2.Assign(static_cast<TevStageConfig::AlphaModifier>(random() % 8));
+    stage.color_op.Assign(static_cast<TevStageConfig::Operation>(random() % 10));
+    stage.alpha_op.Assign(static_cast<TevStageConfig::Operation>(random() % 10));
+    stage.color_scale.Assign(random() % 3);
+    stage.alpha_scale.Assign(random() % 3);
+    return stage;
+}
+
+/// Reads the raw configurations stored in a transferable shader disk cache file.
+std::vector<ShaderDiskCacheRaw> LoadTransferable(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    u32 version{};
+    if (!file.IsOpen() || file.ReadBytes(&version, sizeof(version)) != sizeof(version)) {
+        return {};
+    }
+
+    std::vector<ShaderDiskCacheRaw> raws;
+    while (file.Tell() < file.GetSize()) {
+        u32 kind{};
+        ShaderDiskCacheRaw entry;
+        // Raw entries are the only kind of transferable entry
+        if (file.ReadBytes(&kind, sizeof(kind)) != sizeof(kind) || kind != 0 ||
+            !entry.Load(file)) {
+            break;
+        }
+        raws.push_back(std::move(entry));
+    }
+    return raws;
+}
+
+/// Generates the shader of every configuration and prints the time it took.
+void BenchmarkGeneration(const std::vector<PicaFSConfig>& configs) {
+    std::size_t total_size = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& config : configs) {
+        total_size += GenerateFragmentShader(config, true).code.size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    fmt::print("GenerateFragmentShader: generated {} shaders ({} KiB) in {:.3f}ms, {:.1f}us per "
+               "shader\n",
+               configs.size(), total_size / 1024, elapsed.count() * 1e3,
+               elapsed.count() * 1e6 / configs.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GenerateFragmentShader TEV stages", "[video_core][renderer_opengl]") {
+    Pica::Regs regs{};
+    auto& texturing = regs.texturing;
+    for (TevStageConfig* stage : {&texturing.tev_stage1, &texturing.tev_stage2,
+                                  &texturing.tev_stage4, &texturing.tev_stage5}) {
+        SetupPassThroughStage(*stage);
+    }
+    SetupModulateStage(texturing.tev_stage0);
+    SetupModulateStage(texturing.tev_stage3);
+
+    const PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
+    const std::string code = GenerateFragmentShader(config, true).code;
+
+    // The same stage is emitted from the stage cache in both slots, reading its own constant
+    REQUIRE(code.find("const int tev_stage = 0;") != std::string::npos);
+    REQUIRE(code.find("const int tev_stage = 3;") != std::string::npos);
+    REQUIRE(code.find("const int tev_stage = 1;") == std::string::npos);
+    REQUIRE(code.find("const_color[tev_stage]") != std::string::npos);
+
+    // Texture 0 is sampled once for both stages, and unused textures aren't sampled
+    REQUIRE(code.find("vec4 texcolor0 = ") != std::string::npos);
+    REQUIRE(code.find("vec4 texcolor0 = ", code.find("vec4 texcolor0 = ") + 1) ==
+            std::string::npos);
+    REQUIRE(code.find("vec4 texcolor1 = ") == std::string::npos);
+
+    REQUIRE(GenerateFragmentShader(config, true).code == code);
+}
+
+TEST_CASE("GenerateFragmentShader synthetic configurations",
+          "[.][video_core][renderer_opengl][benchmark]") {
+    // Games combine a limited set of stages in many ways, build the configurations the same way
+    constexpr std::size_t num_configs = 2000;
+    std::mt19937 random{0x36};
+    std::vector<TevStageConfig> stages(64);
+    for (auto& stage : stages) {
+        stage = RandomStage(random);
+    }
+
+    std::vector<PicaFSConfig> configs;
+    for (std::size_t i = 0; i < num_configs; i++) {
+        Pica::Regs regs{};
+        auto& texturing = regs.texturing;
+        for (TevStageConfig* stage : {&texturing.tev_stage0, &texturing.tev_stage1,
+                                      &texturing.tev_stage2, &texturing.tev_stage3,
+                                      &texturing.tev_stage4, &texturing.tev_stage5}) {
+            *stage = stages[random() % stages.size()];
+        }
+        configs.push_back(PicaFSConfig::BuildFromRegs(regs));
+    }
+
+    BenchmarkGeneration(configs);
+}
+
+TEST_CASE("GenerateFragmentShader shader cache", "[.][video_core][renderer_opengl][benchmark]") {
+    // Path to a transferable shader cache, as found in shaders/opengl/transferable
+    const char* path = std::getenv("CITRA_SHADER_CACHE");
+    if (path == nullptr) {
+        WARN("CITRA_SHADER_CACHE is not set, skipping");
+        return;
+    }
+
+    std::vector<PicaFSConfig> configs;
+    for (const auto& raw : LoadTransferable(path)) {
+        if (raw.GetProgramType() == ProgramType::FS) {
+            configs.push_back(PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig()));
+        }
+    }
+    REQUIRE(!configs.empty());
+
+    BenchmarkGeneration(configs);
+}
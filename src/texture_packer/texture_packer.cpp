@@ -0,0 +1,52 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+#include "core/frontend/image_interface.h"
+#include "video_core/custom_textures/texture_pack.h"
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " <pack directory> [output file]\n"
+                 "Converts the custom textures in a pack directory, such as\n"
+                 "load/textures/<program id>, to a single packed texture file. The output\n"
+                 "defaults to "
+              << VideoCore::PACKED_TEXTURES_FILE
+              << " in the pack directory, where it is picked up instead of\n"
+                 "the individual texture files.\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3 || std::string{argv[1]} == "-h" ||
+        std::string{argv[1]} == "--help") {
+        PrintHelp(argv[0]);
+        return argc < 2 || argc > 3 ? -1 : 0;
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    std::string load_path = argv[1];
+    if (!FileUtil::IsDirectory(load_path)) {
+        std::cerr << load_path << " is not a directory\n";
+        return -1;
+    }
+    if (load_path.back() != '/' && load_path.back() != '\\') {
+        load_path += '/';
+    }
+    const std::string pack_path =
+        argc == 3 ? std::string{argv[2]} : load_path + std::string{VideoCore::PACKED_TEXTURES_FILE};
+
+    Frontend::ImageInterface image_interface;
+    if (!VideoCore::WritePackedTextures(load_path, pack_path, image_interface)) {
+        return -1;
+    }
+    return 0;
+}
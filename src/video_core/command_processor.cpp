@@ -10,6 +10,7 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/perf_sections.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
@@ -240,11 +241,15 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     ASSERT(!g_state.geometry_pipeline.NeedIndexInput());
                     g_state.geometry_pipeline.Setup(shader_engine);
                     g_state.geometry_pipeline.SubmitVertex(output);
+                    g_state.geometry_pipeline.Flush();
 
                     // TODO: If drawing after every immediate mode triangle kills performance,
                     // change it to flush triangles whenever a drawing config register changes
                     // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+                    {
+                        Common::ScopedPerfSection section{Common::PerfSection::Rasterizer};
+                        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+                    }
                     if (g_debug_context) {
                         g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
                                                  nullptr);
@@ -303,8 +308,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         bool is_indexed = (id == PICA_REG_INDEX(pipeline.trigger_draw_indexed));
 
-        if (accelerate_draw &&
-            VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed)) {
+        bool accelerated = false;
+        if (accelerate_draw) {
+            Common::ScopedPerfSection section{Common::PerfSection::Rasterizer};
+            accelerated = VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed);
+        }
+        if (accelerated) {
             if (g_debug_context) {
                 g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
             }
@@ -416,13 +425,17 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             // Send to geometry pipeline
             g_state.geometry_pipeline.SubmitVertex(vs_output);
         }
+        g_state.geometry_pipeline.Flush();
 
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(
                 VideoCore::g_memory->GetPhysicalPointer(range.first), range.second, range.first);
         }
 
-        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        {
+            Common::ScopedPerfSection section{Common::PerfSection::Rasterizer};
+            VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        }
         if (g_debug_context) {
             g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
         }
@@ -33,4 +33,29 @@ bool IsCustomFormatCompressed(CustomPixelFormat format) {
     return format != CustomPixelFormat::RGBA8 && format != CustomPixelFormat::Invalid;
 }
 
+u64 GetCustomFormatSize(CustomPixelFormat format, u32 width, u32 height) {
+    const auto block_size = [&](u32 block_width, u32 block_height, u64 bytes) {
+        const u64 blocks_x = (u64{width} + block_width - 1) / block_width;
+        const u64 blocks_y = (u64{height} + block_height - 1) / block_height;
+        return blocks_x * blocks_y * bytes;
+    };
+    switch (format) {
+    case CustomPixelFormat::RGBA8:
+        return u64{width} * height * 4;
+    case CustomPixelFormat::BC1:
+        return block_size(4, 4, 8);
+    case CustomPixelFormat::BC3:
+    case CustomPixelFormat::BC5:
+    case CustomPixelFormat::BC7:
+    case CustomPixelFormat::ASTC4:
+        return block_size(4, 4, 16);
+    case CustomPixelFormat::ASTC6:
+        return block_size(6, 6, 16);
+    case CustomPixelFormat::ASTC8:
+        return block_size(8, 8, 16);
+    default:
+        return 0;
+    }
+}
+
 } // namespace VideoCore
@@ -33,4 +33,7 @@ std::string_view CustomPixelFormatAsString(CustomPixelFormat format);
 
 bool IsCustomFormatCompressed(CustomPixelFormat format);
 
+/// Returns the size in bytes of the base level of a texture with the given format and size.
+u64 GetCustomFormatSize(CustomPixelFormat format, u32 width, u32 height);
+
 } // namespace VideoCore
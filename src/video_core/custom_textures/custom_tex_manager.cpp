@@ -2,12 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <json.hpp>
 #include "common/file_util.h"
 #include "common/memory_detect.h"
 #include "common/microprofile.h"
 #include "common/settings.h"
-#include "common/string_util.h"
 #include "common/texture.h"
 #include "core/core.h"
 #include "core/frontend/image_interface.h"
@@ -24,51 +24,48 @@ MICROPROFILE_DEFINE(CustomTexManager_TickFrame, "CustomTexManager", "TickFrame",
 
 constexpr std::size_t MAX_UPLOADS_PER_TICK = 8;
 
+constexpr u64 MiB = 1024 * 1024;
+
 bool IsPow2(u32 value) {
     return value != 0 && (value & (value - 1)) == 0;
 }
 
-CustomFileFormat MakeFileFormat(std::string_view ext) {
-    if (ext == "png") {
-        return CustomFileFormat::PNG;
-    } else if (ext == "dds") {
-        return CustomFileFormat::DDS;
-    } else if (ext == "ktx") {
-        return CustomFileFormat::KTX;
-    }
-    return CustomFileFormat::None;
-}
-
-MapType MakeMapType(std::string_view ext) {
-    if (ext == "norm") {
-        return MapType::Normal;
-    }
-    LOG_ERROR(Render, "Unknown material extension {}", ext);
-    return MapType::Color;
-}
-
 } // Anonymous namespace
 
 CustomTexManager::CustomTexManager(Core::System& system_)
     : system{system_}, image_interface{*system.GetImageInterface()},
+      memory_budget{Settings::values.custom_texture_budget.GetValue() * MiB},
+      residency{memory_budget},
       async_custom_loading{Settings::values.async_custom_loading.GetValue()} {}
 
-CustomTexManager::~CustomTexManager() = default;
+CustomTexManager::~CustomTexManager() {
+    if (!usage_history_path.empty()) {
+        usage_history.Save(usage_history_path);
+    }
+    if (memory_budget != 0 && textures_loaded) {
+        LOG_INFO(Render,
+                 "Custom texture streaming: {} MiB resident, {} MiB evicted, {} prefetched, "
+                 "{} hits, {} misses, {} ms stalled",
+                 stats.resident_bytes / MiB, stats.evicted_bytes / MiB, stats.num_prefetched,
+                 stats.num_hits, stats.num_misses, stats.stall_time.count() / 1000);
+    }
+}
 
 void CustomTexManager::TickFrame() {
     MICROPROFILE_SCOPE(CustomTexManager_TickFrame);
     if (!textures_loaded) {
         return;
     }
+    const auto now = std::chrono::steady_clock::now();
     std::size_t num_uploads = 0;
-    for (auto it = async_uploads.begin(); it != async_uploads.end();) {
-        if (num_uploads >= MAX_UPLOADS_PER_TICK) {
-            return;
-        }
+    for (auto it = async_uploads.begin();
+         it != async_uploads.end() && num_uploads < MAX_UPLOADS_PER_TICK;) {
         switch (it->material->state) {
         case DecodeState::Decoded:
             it->func();
             num_uploads++;
+            stats.stall_time +=
+                std::chrono::duration_cast<std::chrono::microseconds>(now - it->requested);
             [[fallthrough]];
         case DecodeState::Failed:
             it = async_uploads.erase(it);
@@ -78,6 +75,11 @@ void CustomTexManager::TickFrame() {
             break;
         }
     }
+    if (memory_budget != 0) {
+        usage_history.EndFrame();
+        UpdateResidency();
+    }
+    current_frame++;
 }
 
 void CustomTexManager::FindCustomTextures() {
@@ -95,7 +97,21 @@ void CustomTexManager::FindCustomTextures() {
     if (!FileUtil::Exists(load_path)) {
         FileUtil::CreateFullPath(load_path);
     }
-    ReadConfig(load_path);
+    if (memory_budget != 0) {
+        const std::string history_dir =
+            fmt::format("{}custom_textures/", GetUserPath(FileUtil::UserPath::CacheDir));
+        FileUtil::CreateFullPath(history_dir);
+        usage_history_path = fmt::format("{}{:016X}.bin", history_dir, program_id);
+        if (usage_history.Load(usage_history_path)) {
+            LOG_INFO(Render, "Loaded custom texture usage history of {} textures",
+                     usage_history.Size());
+        }
+    }
+    if (LoadPackedTextures(load_path + std::string{PACKED_TEXTURES_FILE})) {
+        textures_loaded = true;
+        return;
+    }
+    config = ReadPackConfig(load_path);
 
     FileUtil::FSTEntry texture_dir;
     std::vector<FileUtil::FSTEntry> textures;
@@ -109,7 +125,7 @@ void CustomTexManager::FindCustomTextures() {
         }
         custom_textures.push_back(std::make_unique<CustomTexture>(image_interface));
         CustomTexture* const texture{custom_textures.back().get()};
-        if (!ParseFilename(file, texture)) {
+        if (!ParseTextureFilename(config, file, texture)) {
             continue;
         }
         for (const u64 hash : texture->hashes) {
@@ -124,53 +140,37 @@ void CustomTexManager::FindCustomTextures() {
     textures_loaded = true;
 }
 
-bool CustomTexManager::ParseFilename(const FileUtil::FSTEntry& file, CustomTexture* texture) {
-    auto parts = Common::SplitString(file.virtualName, '.');
-    if (parts.size() > 3) {
-        LOG_ERROR(Render, "Invalid filename {}, ignoring", file.virtualName);
+bool CustomTexManager::LoadPackedTextures(const std::string& path) {
+    if (!FileUtil::Exists(path) || !packed_textures.Open(path)) {
         return false;
     }
-    // The last string should always be the file extension.
-    const CustomFileFormat file_format = MakeFileFormat(parts.back());
-    if (file_format == CustomFileFormat::None) {
-        return false;
-    }
-    if (file_format == CustomFileFormat::DDS && refuse_dds) {
-        LOG_ERROR(Render, "Legacy pack is attempting to use DDS textures, skipping!");
-        return false;
-    }
-    texture->file_format = file_format;
-    parts.pop_back();
-
-    // This means the texture is a material type other than color.
-    texture->type = MapType::Color;
-    if (parts.size() > 1) {
-        texture->type = MakeMapType(parts.back());
-        parts.pop_back();
-    }
-
-    // First look if this file is mapped to any number of hashes.
-    std::vector<u64>& hashes = texture->hashes;
-    const auto it = path_to_hash_map.find(file.virtualName);
-    if (it != path_to_hash_map.end()) {
-        hashes = it->second;
-    }
-
-    // It's also possible for pack creators to retain the default texture name
-    // still map the texture to another hash. Support that as well.
-    u32 width;
-    u32 height;
-    u32 format;
-    unsigned long long hash{};
-    const bool is_parsed = std::sscanf(parts.back().c_str(), "tex1_%ux%u_%llX_%u", &width, &height,
-                                       &hash, &format) == 4;
-    const bool is_mapped =
-        !hashes.empty() && std::find(hashes.begin(), hashes.end(), hash) != hashes.end();
-    if (is_parsed && !is_mapped) {
-        hashes.push_back(hash);
+    // Packed textures are stored flipped and decoded, only the options affecting uploads apply.
+    config = {};
+    config.skip_mipmap = packed_textures.SkipMipmaps();
+    config.use_new_hash = packed_textures.UseNewHash();
+
+    const auto entries = packed_textures.Entries();
+    custom_textures.reserve(entries.size());
+    for (const PackedEntry& entry : entries) {
+        custom_textures.push_back(std::make_unique<CustomTexture>(image_interface));
+        CustomTexture* const texture{custom_textures.back().get()};
+        texture->path = fmt::format("{}:{:016X}", path, u64{entry.hash});
+        texture->width = entry.width;
+        texture->height = entry.height;
+        texture->hashes = {entry.hash};
+        texture->format = static_cast<CustomPixelFormat>(u32{entry.format});
+        texture->file_format = CustomFileFormat::None;
+        texture->packed_data = packed_textures.Data(entry);
+        texture->type = static_cast<MapType>(u32{entry.map_type});
+
+        auto& material = material_map[entry.hash];
+        if (!material) {
+            material = std::make_unique<Material>();
+        }
+        material->hash = entry.hash;
+        material->AddMapTexture(texture);
     }
-
-    texture->path = file.physicalName;
+    LOG_INFO(Render, "Loaded {} packed textures from {}", entries.size(), path);
     return true;
 }
 
@@ -219,7 +219,7 @@ void CustomTexManager::PreloadTextures(const std::atomic_bool& stop_run,
             if (stop_run) {
                 return;
             }
-            material->LoadFromDisk(flip_png_files);
+            material->LoadFromDisk(config.flip_png_files);
             size_sum += material->size;
             if (callback) {
                 callback(VideoCore::LoadCallbackStage::Preload, preloaded, custom_textures.size());
@@ -229,6 +229,9 @@ void CustomTexManager::PreloadTextures(const std::atomic_bool& stop_run,
     });
     workers->WaitForRequests();
     async_custom_loading = false;
+    // Everything is resident, so there is nothing to stream or evict.
+    memory_budget = 0;
+    usage_history_path.clear();
 }
 
 void CustomTexManager::DumpTexture(const SurfaceParams& params, u32 level, std::span<u8> data,
@@ -290,71 +293,79 @@ Material* CustomTexManager::GetMaterial(u64 data_hash) {
 }
 
 bool CustomTexManager::Decode(Material* material, std::function<bool()>&& upload) {
+    material->last_used = current_frame;
+    if (memory_budget != 0) {
+        usage_history.Record(material->hash);
+    }
     if (!async_custom_loading) {
-        material->LoadFromDisk(flip_png_files);
+        if (material->IsDecoded()) {
+            stats.num_hits++;
+            return upload();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        material->LoadFromDisk(config.flip_png_files);
+        stats.stall_time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        stats.num_misses++;
+        if (memory_budget != 0) {
+            residency.Track(material);
+        }
         return upload();
     }
     if (material->IsUnloaded()) {
-        material->state = DecodeState::Pending;
-        workers->QueueWork([material, this] { material->LoadFromDisk(flip_png_files); });
+        QueueDecode(material);
+        stats.num_misses++;
+    } else {
+        stats.num_hits++;
     }
+    Prefetch(material->hash);
     async_uploads.push_back({
         .material = material,
         .func = std::move(upload),
+        .requested = std::chrono::steady_clock::now(),
     });
     return false;
 }
 
-void CustomTexManager::ReadConfig(const std::string& load_path) {
-    const std::string config_path = load_path + "pack.json";
-    FileUtil::IOFile config_file{config_path, "r"};
-    if (!config_file.IsOpen()) {
-        LOG_INFO(Render, "Unable to find pack config file, using legacy defaults");
-        refuse_dds = true;
-        return;
+void CustomTexManager::QueueDecode(Material* material) {
+    material->state = DecodeState::Pending;
+    workers->QueueWork([material, this] { material->LoadFromDisk(config.flip_png_files); });
+    if (memory_budget != 0) {
+        residency.Track(material);
     }
-    std::string config(config_file.GetSize(), '\0');
-    const std::size_t read_size = config_file.ReadBytes(config.data(), config.size());
-    if (!read_size) {
+}
+
+void CustomTexManager::Prefetch(u64 hash) {
+    if (memory_budget == 0) {
         return;
     }
-
-    nlohmann::json json = nlohmann::json::parse(config, nullptr, false, true);
-
-    const auto& options = json["options"];
-    skip_mipmap = options["skip_mipmap"].get<bool>();
-    flip_png_files = options["flip_png_files"].get<bool>();
-    use_new_hash = options["use_new_hash"].get<bool>();
-    refuse_dds = skip_mipmap || !use_new_hash;
-
-    const auto& textures = json["textures"];
-    for (const auto& material : textures.items()) {
-        size_t idx{};
-        const u64 hash = std::stoull(material.key(), &idx, 16);
-        if (!idx) {
-            LOG_ERROR(Render, "Key {} is invalid, skipping", material.key());
-            continue;
+    for (const u64 next : usage_history.Next(hash)) {
+        if (stats.resident_bytes >= memory_budget) {
+            return;
         }
-        const auto parse = [&](const std::string& file) {
-            const std::string filename{FileUtil::GetFilename(file)};
-            auto [it, new_hash] = path_to_hash_map.try_emplace(filename);
-            it->second.push_back(hash);
-        };
-        const auto value = material.value();
-        if (value.is_string()) {
-            const auto file = value.get<std::string>();
-            parse(file);
-        } else if (value.is_array()) {
-            const auto files = value.get<std::vector<std::string>>();
-            for (const std::string& file : files) {
-                parse(file);
-            }
-        } else {
-            LOG_ERROR(Render, "Material with key {} is invalid", material.key());
+        const auto it = material_map.find(next);
+        if (it == material_map.end() || !it->second->IsUnloaded()) {
+            continue;
         }
+        Material* const material = it->second.get();
+        // Prefetched textures count as used now, so they are not evicted before they are needed.
+        material->last_used = current_frame;
+        QueueDecode(material);
+        stats.num_prefetched++;
     }
 }
 
+void CustomTexManager::UpdateResidency() {
+    residency.Update(current_frame, [this](const Material* material) {
+        return std::any_of(async_uploads.begin(), async_uploads.end(),
+                           [material](const AsyncUpload& upload) {
+                               return upload.material == material;
+                           });
+    });
+    stats.resident_bytes = residency.ResidentBytes();
+    stats.evicted_bytes = residency.EvictedBytes();
+}
+
 void CustomTexManager::CreateWorkers() {
     const std::size_t num_workers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
     workers = std::make_unique<Common::ThreadWorker>(num_workers, "Custom textures");
@@ -4,22 +4,22 @@
 
 #pragma once
 
+#include <chrono>
 #include <list>
 #include <span>
 #include <unordered_map>
 #include <unordered_set>
 #include "common/thread_worker.h"
 #include "video_core/custom_textures/material.h"
+#include "video_core/custom_textures/material_residency.h"
+#include "video_core/custom_textures/texture_pack.h"
+#include "video_core/custom_textures/usage_history.h"
 #include "video_core/rasterizer_interface.h"
 
 namespace Core {
 class System;
 }
 
-namespace FileUtil {
-struct FSTEntry;
-}
-
 namespace VideoCore {
 
 class SurfaceParams;
@@ -27,6 +27,22 @@ class SurfaceParams;
 struct AsyncUpload {
     const Material* material;
     std::function<bool()> func;
+    std::chrono::steady_clock::time_point requested;
+};
+
+struct CustomTexStats {
+    /// Size of the decoded textures that can be evicted
+    u64 resident_bytes;
+    /// Size of the decoded textures evicted to stay within the memory budget
+    u64 evicted_bytes;
+    /// Textures decoded ahead of time from the usage history
+    u64 num_prefetched;
+    /// Requests of textures that were already decoded
+    u64 num_hits;
+    /// Requests of textures that had to be decoded first
+    u64 num_misses;
+    /// Time requested textures were waited for, either decoding them or before uploading them
+    std::chrono::microseconds stall_time;
 };
 
 class CustomTexManager {
@@ -58,20 +74,32 @@ public:
 
     /// True when mipmap uploads should be skipped (legacy packs only)
     bool SkipMipmaps() const noexcept {
-        return skip_mipmap;
+        return config.skip_mipmap;
     }
 
     /// Returns true if the pack uses the new hashing method.
     bool UseNewHash() const noexcept {
-        return use_new_hash;
+        return config.use_new_hash;
+    }
+
+    /// Returns the custom texture streaming statistics of the session.
+    const CustomTexStats& GetStats() const noexcept {
+        return stats;
     }
 
 private:
-    /// Parses the custom texture filename (hash, material type, etc).
-    bool ParseFilename(const FileUtil::FSTEntry& file, CustomTexture* texture);
+    /// Queues the material for decoding on the thread workers.
+    void QueueDecode(Material* material);
+
+    /// Queues the textures usually requested along with the one with the provided hash.
+    void Prefetch(u64 hash);
+
+    /// Starts accounting materials that finished decoding and evicts the least recently used
+    /// ones when the memory budget is exceeded.
+    void UpdateResidency();
 
-    /// Reads the pack configuration file
-    void ReadConfig(const std::string& load_path);
+    /// Loads the textures of a packed texture file, returns false if there is no valid one.
+    bool LoadPackedTextures(const std::string& path);
 
     /// Creates the thread workers.
     void CreateWorkers();
@@ -81,16 +109,19 @@ private:
     Frontend::ImageInterface& image_interface;
     std::unordered_set<u64> dumped_textures;
     std::unordered_map<u64, std::unique_ptr<Material>> material_map;
-    std::unordered_map<std::string, std::vector<u64>> path_to_hash_map;
     std::vector<std::unique_ptr<CustomTexture>> custom_textures;
+    PackedTextures packed_textures;
+    PackConfig config;
     std::list<AsyncUpload> async_uploads;
+    TextureUsageHistory usage_history;
+    std::string usage_history_path;
+    CustomTexStats stats{};
+    u64 memory_budget{};
+    MaterialResidency residency;
+    u64 current_frame{};
     std::unique_ptr<Common::ThreadWorker> workers;
     bool textures_loaded{false};
     bool async_custom_loading{true};
-    bool skip_mipmap{true};
-    bool flip_png_files{true};
-    bool use_new_hash{false};
-    bool refuse_dds{false};
 };
 
 } // namespace VideoCore
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/texture.h"
@@ -105,7 +106,7 @@ void Material::LoadFromDisk(bool flip_png) noexcept {
             continue;
         }
         texture->LoadFromDisk(flip_png);
-        size += texture->data.size();
+        size += texture->Data().size();
         LOG_DEBUG(Render, "Loading {} map {}", MapTypeName(texture->type), texture->path);
     }
     if (!textures[0]) {
@@ -151,4 +152,24 @@ void Material::AddMapTexture(CustomTexture* texture) noexcept {
     textures[index] = texture;
 }
 
+void Material::Unload() noexcept {
+    for (CustomTexture* const texture : textures) {
+        if (!texture) {
+            continue;
+        }
+        std::scoped_lock lock{texture->decode_mutex};
+        texture->data = {};
+    }
+    size = 0;
+    state = DecodeState::None;
+}
+
+bool Material::IsEvictable() const noexcept {
+    // Packed textures are mapped from disk and textures shared with other materials could be in
+    // use by them, neither can be freed here.
+    return std::all_of(textures.begin(), textures.end(), [](const CustomTexture* texture) {
+        return !texture || (texture->packed_data.empty() && texture->hashes.size() == 1);
+    });
+}
+
 } // namespace VideoCore
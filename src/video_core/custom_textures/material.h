@@ -44,7 +44,12 @@ public:
     }
 
     [[nodiscard]] bool IsLoaded() const noexcept {
-        return !data.empty();
+        return !Data().empty();
+    }
+
+    /// Returns the texture data ready for upload, decoded from its file or stored in a pack file.
+    [[nodiscard]] std::span<const u8> Data() const noexcept {
+        return packed_data.empty() ? std::span<const u8>{data} : packed_data;
     }
 
 private:
@@ -62,6 +67,7 @@ public:
     CustomPixelFormat format;
     CustomFileFormat file_format;
     std::vector<u8> data;
+    std::span<const u8> packed_data;
     MapType type;
 };
 
@@ -70,6 +76,7 @@ struct Material {
     u32 height;
     u64 size;
     u64 hash;
+    u64 last_used;
     CustomPixelFormat format;
     std::array<CustomTexture*, MAX_MAPS> textures;
     std::atomic<DecodeState> state{};
@@ -78,6 +85,12 @@ struct Material {
 
     void AddMapTexture(CustomTexture* texture) noexcept;
 
+    /// Frees the decoded texture data, the material has to be decoded again before its next use.
+    void Unload() noexcept;
+
+    /// Returns true if the decoded data is owned by this material alone and can be freed.
+    [[nodiscard]] bool IsEvictable() const noexcept;
+
     [[nodiscard]] CustomTexture* Map(MapType type) const noexcept {
         return textures.at(static_cast<std::size_t>(type));
     }
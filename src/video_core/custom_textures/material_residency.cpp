@@ -0,0 +1,49 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "video_core/custom_textures/material.h"
+#include "video_core/custom_textures/material_residency.h"
+
+namespace VideoCore {
+
+void MaterialResidency::Track(Material* material) {
+    loading_materials.push_back(material);
+}
+
+void MaterialResidency::Update(u64 current_frame,
+                               const std::function<bool(const Material*)>& is_uploading) {
+    std::erase_if(loading_materials, [this](Material* material) {
+        if (material->IsPending()) {
+            return false;
+        }
+        if (material->IsDecoded() && material->IsEvictable()) {
+            resident_materials.push_back(material);
+            resident_bytes += material->size;
+        }
+        return true;
+    });
+    if (resident_bytes <= budget) {
+        return;
+    }
+
+    // Evict the least recently used materials, skipping the ones used this frame or still
+    // waiting to be uploaded.
+    std::sort(resident_materials.begin(), resident_materials.end(),
+              [](const Material* lhs, const Material* rhs) {
+                  return lhs->last_used < rhs->last_used;
+              });
+    std::erase_if(resident_materials, [&](Material* material) {
+        if (resident_bytes <= budget || material->last_used >= current_frame ||
+            is_uploading(material)) {
+            return false;
+        }
+        resident_bytes -= material->size;
+        evicted_bytes += material->size;
+        material->Unload();
+        return true;
+    });
+}
+
+} // namespace VideoCore
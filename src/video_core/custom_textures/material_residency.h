@@ -0,0 +1,52 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+struct Material;
+
+/**
+ * Keeps the decoded custom textures within a memory budget. Materials are tracked from the moment
+ * they are queued for decoding, and count against the budget once decoded if they own their data.
+ * When the budget is exceeded the least recently used ones are unloaded.
+ */
+class MaterialResidency {
+public:
+    explicit MaterialResidency(u64 budget_) : budget{budget_} {}
+
+    /// Starts tracking a material that is being decoded.
+    void Track(Material* material);
+
+    /**
+     * Accounts the tracked materials that finished decoding and evicts the least recently used
+     * ones until the budget is met. Materials used in current_frame and the ones is_uploading
+     * returns true for are kept.
+     */
+    void Update(u64 current_frame, const std::function<bool(const Material*)>& is_uploading);
+
+    /// Size of the decoded materials that can be evicted
+    [[nodiscard]] u64 ResidentBytes() const noexcept {
+        return resident_bytes;
+    }
+
+    /// Size of the materials evicted so far
+    [[nodiscard]] u64 EvictedBytes() const noexcept {
+        return evicted_bytes;
+    }
+
+private:
+    std::vector<Material*> loading_materials;
+    std::vector<Material*> resident_materials;
+    u64 budget;
+    u64 resident_bytes{};
+    u64 evicted_bytes{};
+};
+
+} // namespace VideoCore
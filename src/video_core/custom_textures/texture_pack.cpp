@@ -0,0 +1,299 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <json.hpp>
+#include "common/alignment.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/thread_worker.h"
+#include "video_core/custom_textures/texture_pack.h"
+
+namespace VideoCore {
+
+namespace {
+
+/// Alignment of the texture data in packed files, enough for any upload path.
+constexpr std::size_t PACKED_DATA_ALIGNMENT = 64;
+
+/// Number of textures decoded at once while packing, bounds the memory used.
+constexpr std::size_t PACK_BATCH_SIZE = 256;
+
+CustomFileFormat MakeFileFormat(std::string_view ext) {
+    if (ext == "png") {
+        return CustomFileFormat::PNG;
+    } else if (ext == "dds") {
+        return CustomFileFormat::DDS;
+    } else if (ext == "ktx") {
+        return CustomFileFormat::KTX;
+    }
+    return CustomFileFormat::None;
+}
+
+MapType MakeMapType(std::string_view ext) {
+    if (ext == "norm") {
+        return MapType::Normal;
+    }
+    LOG_ERROR(Render, "Unknown material extension {}", ext);
+    return MapType::Color;
+}
+
+bool WritePadding(FileUtil::IOFile& file, u64& offset, std::size_t alignment) {
+    static constexpr std::array<u8, PACKED_DATA_ALIGNMENT> zeros{};
+    const u64 padding = Common::AlignUp(offset, alignment) - offset;
+    offset += padding;
+    return file.WriteBytes(zeros.data(), padding) == padding;
+}
+
+} // Anonymous namespace
+
+PackConfig ReadPackConfig(const std::string& load_path) {
+    PackConfig config;
+    const std::string config_path = load_path + "pack.json";
+    FileUtil::IOFile config_file{config_path, "r"};
+    if (!config_file.IsOpen()) {
+        LOG_INFO(Render, "Unable to find pack config file, using legacy defaults");
+        config.refuse_dds = true;
+        return config;
+    }
+    std::string json_data(config_file.GetSize(), '\0');
+    const std::size_t read_size = config_file.ReadBytes(json_data.data(), json_data.size());
+    if (!read_size) {
+        return config;
+    }
+
+    nlohmann::json json = nlohmann::json::parse(json_data, nullptr, false, true);
+
+    const auto& options = json["options"];
+    config.skip_mipmap = options["skip_mipmap"].get<bool>();
+    config.flip_png_files = options["flip_png_files"].get<bool>();
+    config.use_new_hash = options["use_new_hash"].get<bool>();
+    config.refuse_dds = config.skip_mipmap || !config.use_new_hash;
+
+    const auto& textures = json["textures"];
+    for (const auto& material : textures.items()) {
+        size_t idx{};
+        const u64 hash = std::stoull(material.key(), &idx, 16);
+        if (!idx) {
+            LOG_ERROR(Render, "Key {} is invalid, skipping", material.key());
+            continue;
+        }
+        const auto parse = [&](const std::string& file) {
+            const std::string filename{FileUtil::GetFilename(file)};
+            auto [it, new_hash] = config.path_to_hash_map.try_emplace(filename);
+            it->second.push_back(hash);
+        };
+        const auto value = material.value();
+        if (value.is_string()) {
+            const auto file = value.get<std::string>();
+            parse(file);
+        } else if (value.is_array()) {
+            const auto files = value.get<std::vector<std::string>>();
+            for (const std::string& file : files) {
+                parse(file);
+            }
+        } else {
+            LOG_ERROR(Render, "Material with key {} is invalid", material.key());
+        }
+    }
+    return config;
+}
+
+bool ParseTextureFilename(const PackConfig& config, const FileUtil::FSTEntry& file,
+                          CustomTexture* texture) {
+    auto parts = Common::SplitString(file.virtualName, '.');
+    if (parts.size() > 3) {
+        LOG_ERROR(Render, "Invalid filename {}, ignoring", file.virtualName);
+        return false;
+    }
+    // The last string should always be the file extension.
+    const CustomFileFormat file_format = MakeFileFormat(parts.back());
+    if (file_format == CustomFileFormat::None) {
+        return false;
+    }
+    if (file_format == CustomFileFormat::DDS && config.refuse_dds) {
+        LOG_ERROR(Render, "Legacy pack is attempting to use DDS textures, skipping!");
+        return false;
+    }
+    texture->file_format = file_format;
+    parts.pop_back();
+
+    // This means the texture is a material type other than color.
+    texture->type = MapType::Color;
+    if (parts.size() > 1) {
+        texture->type = MakeMapType(parts.back());
+        parts.pop_back();
+    }
+
+    // First look if this file is mapped to any number of hashes.
+    std::vector<u64>& hashes = texture->hashes;
+    const auto it = config.path_to_hash_map.find(file.virtualName);
+    if (it != config.path_to_hash_map.end()) {
+        hashes = it->second;
+    }
+
+    // It's also possible for pack creators to retain the default texture name
+    // still map the texture to another hash. Support that as well.
+    u32 width;
+    u32 height;
+    u32 format;
+    unsigned long long hash{};
+    const bool is_parsed = std::sscanf(parts.back().c_str(), "tex1_%ux%u_%llX_%u", &width, &height,
+                                       &hash, &format) == 4;
+    const bool is_mapped =
+        !hashes.empty() && std::find(hashes.begin(), hashes.end(), hash) != hashes.end();
+    if (is_parsed && !is_mapped) {
+        hashes.push_back(hash);
+    }
+
+    texture->path = file.physicalName;
+    return true;
+}
+
+bool PackedTextures::Open(const std::string& path) {
+    file = FileUtil::MappedFile{path};
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    const std::span<const u8> data = file.Data();
+    if (data.size() < sizeof(PackedHeader)) {
+        LOG_ERROR(Render, "Packed texture file {} is truncated", path);
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(PackedHeader));
+    if (header.magic != PackedHeader::MAGIC || header.version != PackedHeader::VERSION) {
+        LOG_ERROR(Render, "{} is not a supported packed texture file", path);
+        return false;
+    }
+
+    const u64 index_offset = header.index_offset;
+    const u64 index_size = u64{header.num_entries} * sizeof(PackedEntry);
+    if (index_offset % alignof(PackedEntry) != 0 || index_offset > data.size() ||
+        index_size > data.size() - index_offset) {
+        LOG_ERROR(Render, "Packed texture file {} has an invalid index", path);
+        return false;
+    }
+    entries = {reinterpret_cast<const PackedEntry*>(data.data() + index_offset),
+               header.num_entries};
+
+    // The data of each entry is uploaded as a whole texture of its size, it must hold at least the
+    // base level.
+    const bool is_valid = std::all_of(entries.begin(), entries.end(), [&](const PackedEntry& e) {
+        const auto format = static_cast<CustomPixelFormat>(static_cast<u32>(e.format));
+        return e.map_type < MAX_MAPS && e.format <= static_cast<u32>(CustomPixelFormat::ASTC8) &&
+               e.offset <= data.size() && e.size <= data.size() - e.offset && e.size != 0 &&
+               e.size >= GetCustomFormatSize(format, e.width, e.height);
+    });
+    if (!is_valid) {
+        LOG_ERROR(Render, "Packed texture file {} has invalid entries", path);
+        entries = {};
+        return false;
+    }
+    return true;
+}
+
+bool WritePackedTextures(const std::string& load_path, const std::string& pack_path,
+                         Frontend::ImageInterface& image_interface) {
+    const PackConfig config = ReadPackConfig(load_path);
+
+    FileUtil::FSTEntry texture_dir;
+    std::vector<FileUtil::FSTEntry> files;
+    FileUtil::ScanDirectoryTree(load_path, texture_dir, 64);
+    FileUtil::GetAllFilesFromNestedEntries(texture_dir, files);
+
+    std::vector<std::unique_ptr<CustomTexture>> textures;
+    for (const FileUtil::FSTEntry& file : files) {
+        if (file.isDirectory) {
+            continue;
+        }
+        auto texture = std::make_unique<CustomTexture>(image_interface);
+        if (ParseTextureFilename(config, file, texture.get()) && texture->IsParsed()) {
+            textures.push_back(std::move(texture));
+        }
+    }
+    // Directory listings are unordered, sort them so that packing is reproducible.
+    std::sort(textures.begin(), textures.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs->path < rhs->path; });
+
+    FileUtil::IOFile pack_file{pack_path, "wb"};
+    PackedHeader header{};
+    if (!pack_file.IsOpen() || pack_file.WriteObject(header) != 1) {
+        LOG_ERROR(Render, "Unable to create packed texture file {}", pack_path);
+        return false;
+    }
+
+    const std::size_t num_workers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+    Common::ThreadWorker workers{num_workers, "Texture packer"};
+    std::vector<PackedEntry> entries;
+    u64 offset = sizeof(PackedHeader);
+    std::size_t num_packed = 0;
+    for (std::size_t batch = 0; batch < textures.size(); batch += PACK_BATCH_SIZE) {
+        const std::span batch_textures =
+            std::span{textures}.subspan(batch, std::min(PACK_BATCH_SIZE, textures.size() - batch));
+        for (const auto& texture : batch_textures) {
+            workers.QueueWork(
+                [&texture, &config] { texture->LoadFromDisk(config.flip_png_files); });
+        }
+        workers.WaitForRequests();
+
+        for (const auto& texture : batch_textures) {
+            if (!texture->IsLoaded()) {
+                LOG_ERROR(Render, "Unable to load {}, skipping", texture->path);
+                continue;
+            }
+            if (!WritePadding(pack_file, offset, PACKED_DATA_ALIGNMENT) ||
+                pack_file.WriteBytes(texture->data.data(), texture->data.size()) !=
+                    texture->data.size()) {
+                LOG_ERROR(Render, "Failed to write packed texture file {}", pack_path);
+                return false;
+            }
+            for (const u64 hash : texture->hashes) {
+                entries.push_back({
+                    .hash = hash,
+                    .map_type = static_cast<u32>(texture->type),
+                    .format = static_cast<u32>(texture->format),
+                    .width = texture->width,
+                    .height = texture->height,
+                    .offset = offset,
+                    .size = texture->data.size(),
+                });
+            }
+            offset += texture->data.size();
+            num_packed++;
+            texture->data = {};
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PackedEntry& lhs, const PackedEntry& rhs) {
+        return std::tie(lhs.hash, lhs.map_type) < std::tie(rhs.hash, rhs.map_type);
+    });
+    if (!WritePadding(pack_file, offset, alignof(PackedEntry)) ||
+        pack_file.WriteArray(entries.data(), entries.size()) != entries.size()) {
+        LOG_ERROR(Render, "Failed to write packed texture file {}", pack_path);
+        return false;
+    }
+
+    header.magic = PackedHeader::MAGIC;
+    header.version = PackedHeader::VERSION;
+    header.flags = (config.skip_mipmap ? PackedHeader::FLAG_SKIP_MIPMAP : 0) |
+                   (config.use_new_hash ? PackedHeader::FLAG_USE_NEW_HASH : 0);
+    header.num_entries = static_cast<u32>(entries.size());
+    header.index_offset = offset;
+    if (!pack_file.Seek(0, SEEK_SET) || pack_file.WriteObject(header) != 1) {
+        LOG_ERROR(Render, "Failed to write packed texture file {}", pack_path);
+        return false;
+    }
+
+    LOG_INFO(Render, "Packed {} of {} textures from {} into {}", num_packed, textures.size(),
+             load_path, pack_path);
+    return true;
+}
+
+} // namespace VideoCore
@@ -0,0 +1,102 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/file_util.h"
+#include "common/swap.h"
+#include "video_core/custom_textures/material.h"
+
+namespace Frontend {
+class ImageInterface;
+}
+
+namespace VideoCore {
+
+/// Options and hash mappings of a custom texture pack, read from its pack.json
+struct PackConfig {
+    bool skip_mipmap{true};
+    bool flip_png_files{true};
+    bool use_new_hash{false};
+    bool refuse_dds{false};
+    std::unordered_map<std::string, std::vector<u64>> path_to_hash_map;
+};
+
+/// Reads the configuration of the pack in load_path, using legacy defaults if it has none.
+PackConfig ReadPackConfig(const std::string& load_path);
+
+/// Parses the custom texture filename (hash, material type, etc).
+bool ParseTextureFilename(const PackConfig& config, const FileUtil::FSTEntry& file,
+                          CustomTexture* texture);
+
+/// Name of the packed texture file looked up in the load directory of a title.
+constexpr std::string_view PACKED_TEXTURES_FILE = "pack.ctp";
+
+/**
+ * Packed texture files contain the textures of a pack already decoded to the data uploaded to the
+ * GPU, followed by an index sorted by hash. They are memory mapped, so loading them neither scans
+ * the pack directory nor decodes any file.
+ */
+struct PackedHeader {
+    static constexpr u32 MAGIC = 0x4B505443; // CTPK
+    static constexpr u32 VERSION = 1;
+    static constexpr u32 FLAG_SKIP_MIPMAP = 1 << 0;
+    static constexpr u32 FLAG_USE_NEW_HASH = 1 << 1;
+
+    u32_le magic;
+    u32_le version;
+    u32_le flags;
+    u32_le num_entries;
+    u64_le index_offset;
+};
+static_assert(sizeof(PackedHeader) == 24, "PackedHeader has incorrect size");
+
+/// Index entry of a packed texture, one for each hash and map type the texture is assigned to.
+struct PackedEntry {
+    u64_le hash;
+    u32_le map_type;
+    u32_le format;
+    u32_le width;
+    u32_le height;
+    u64_le offset;
+    u64_le size;
+};
+static_assert(sizeof(PackedEntry) == 40, "PackedEntry has incorrect size");
+
+class PackedTextures {
+public:
+    /// Maps the packed texture file at path, returns false if it is missing or invalid.
+    bool Open(const std::string& path);
+
+    [[nodiscard]] bool SkipMipmaps() const noexcept {
+        return (header.flags & PackedHeader::FLAG_SKIP_MIPMAP) != 0;
+    }
+
+    [[nodiscard]] bool UseNewHash() const noexcept {
+        return (header.flags & PackedHeader::FLAG_USE_NEW_HASH) != 0;
+    }
+
+    [[nodiscard]] std::span<const PackedEntry> Entries() const noexcept {
+        return entries;
+    }
+
+    [[nodiscard]] std::span<const u8> Data(const PackedEntry& entry) const noexcept {
+        return file.Data().subspan(entry.offset, entry.size);
+    }
+
+private:
+    FileUtil::MappedFile file;
+    PackedHeader header{};
+    std::span<const PackedEntry> entries;
+};
+
+/// Decodes the textures of the pack in load_path and writes them to a packed texture file.
+bool WritePackedTextures(const std::string& load_path, const std::string& pack_path,
+                         Frontend::ImageInterface& image_interface);
+
+} // namespace VideoCore
@@ -0,0 +1,136 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "video_core/custom_textures/usage_history.h"
+
+namespace VideoCore {
+
+namespace {
+
+struct HistoryHeader {
+    static constexpr u32 MAGIC = 0x48555443; // CTUH
+    static constexpr u32 VERSION = 1;
+
+    u32_le magic;
+    u32_le version;
+    u64_le num_links;
+};
+static_assert(sizeof(HistoryHeader) == 16, "HistoryHeader has incorrect size");
+
+struct HistoryLink {
+    u64_le hash;
+    u64_le next;
+};
+static_assert(sizeof(HistoryLink) == 16, "HistoryLink has incorrect size");
+
+} // Anonymous namespace
+
+void TextureUsageHistory::Record(u64 hash) {
+    if (std::find(current_frame.begin(), current_frame.end(), hash) == current_frame.end()) {
+        current_frame.push_back(hash);
+    }
+}
+
+void TextureUsageHistory::EndFrame() {
+    if (current_frame.empty()) {
+        previous_frame.clear();
+        return;
+    }
+    // Loading screens can request hundreds of textures at once, only the first few of a frame are
+    // linked to keep this cheap, they are the ones worth prefetching anyway.
+    const auto first = [](const std::vector<u64>& frame) {
+        return std::span{frame}.first(std::min(frame.size(), MAX_LINKS));
+    };
+    for (const u64 hash : first(previous_frame)) {
+        for (const u64 next : first(current_frame)) {
+            Link(hash, next);
+        }
+    }
+    for (const u64 hash : current_frame) {
+        for (const u64 next : first(current_frame)) {
+            Link(hash, next);
+        }
+    }
+    previous_frame = std::move(current_frame);
+    current_frame.clear();
+}
+
+std::span<const u64> TextureUsageHistory::Next(u64 hash) const {
+    const auto it = links.find(hash);
+    if (it == links.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+void TextureUsageHistory::Link(u64 hash, u64 next) {
+    if (hash == next) {
+        return;
+    }
+    auto& targets = links[hash];
+    if (targets.size() >= MAX_LINKS ||
+        std::find(targets.begin(), targets.end(), next) != targets.end()) {
+        return;
+    }
+    targets.push_back(next);
+    dirty = true;
+}
+
+bool TextureUsageHistory::Load(const std::string& path) {
+    FileUtil::IOFile file{path, "rb"};
+    if (!file.IsOpen()) {
+        return false;
+    }
+    HistoryHeader header{};
+    if (file.ReadArray(&header, 1) != 1 || header.magic != HistoryHeader::MAGIC ||
+        header.version != HistoryHeader::VERSION ||
+        header.num_links > (file.GetSize() - sizeof(HistoryHeader)) / sizeof(HistoryLink)) {
+        LOG_WARNING(Render, "Ignoring invalid texture usage history {}", path);
+        return false;
+    }
+    std::vector<HistoryLink> saved(header.num_links);
+    if (file.ReadArray(saved.data(), saved.size()) != saved.size()) {
+        LOG_WARNING(Render, "Texture usage history {} is truncated", path);
+        return false;
+    }
+
+    links.clear();
+    for (const HistoryLink& link : saved) {
+        Link(link.hash, link.next);
+    }
+    dirty = false;
+    return true;
+}
+
+bool TextureUsageHistory::Save(const std::string& path) {
+    if (!dirty) {
+        return true;
+    }
+    std::vector<HistoryLink> saved;
+    for (const auto& [hash, targets] : links) {
+        for (const u64 next : targets) {
+            saved.push_back({.hash = hash, .next = next});
+        }
+    }
+
+    const HistoryHeader header{
+        .magic = HistoryHeader::MAGIC,
+        .version = HistoryHeader::VERSION,
+        .num_links = saved.size(),
+    };
+    FileUtil::IOFile file{path, "wb"};
+    if (!file.IsOpen() || file.WriteObject(header) != 1 ||
+        file.WriteArray(saved.data(), saved.size()) != saved.size()) {
+        LOG_ERROR(Render, "Failed to write texture usage history {}", path);
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+} // namespace VideoCore
@@ -0,0 +1,54 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Records which custom textures a title requests together. Textures requested in the same frame,
+ * or in the frame right after, are linked, so the next time one of them is requested the others
+ * can be decoded ahead of time. The history is kept per title across sessions.
+ */
+class TextureUsageHistory {
+public:
+    /// Maximum number of textures linked to a single texture.
+    static constexpr std::size_t MAX_LINKS = 32;
+
+    /// Records that the texture with the provided hash was requested in the current frame.
+    void Record(u64 hash);
+
+    /// Links the textures requested in the current frame with each other and the previous frame.
+    void EndFrame();
+
+    /// Returns the textures usually requested along with the texture with the provided hash.
+    [[nodiscard]] std::span<const u64> Next(u64 hash) const;
+
+    /// Loads a history previously saved to path, returns false if there is no valid one.
+    bool Load(const std::string& path);
+
+    /// Saves the history to path if it has changed since it was loaded.
+    bool Save(const std::string& path);
+
+    [[nodiscard]] std::size_t Size() const noexcept {
+        return links.size();
+    }
+
+private:
+    void Link(u64 hash, u64 next);
+
+private:
+    std::unordered_map<u64, std::vector<u64>> links;
+    std::vector<u64> current_frame;
+    std::vector<u64> previous_frame;
+    bool dirty{false};
+};
+
+} // namespace VideoCore
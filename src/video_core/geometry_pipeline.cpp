@@ -7,6 +7,7 @@
 #include <boost/serialization/unique_ptr.hpp>
 #include "common/archives.h"
 #include "video_core/geometry_pipeline.h"
+#include "video_core/geometry_shader_batch.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs.h"
 #include "video_core/renderer_base.h"
@@ -298,7 +299,8 @@ private:
     friend class boost::serialization::access;
 };
 
-GeometryPipeline::GeometryPipeline(State& state) : state(state) {}
+GeometryPipeline::GeometryPipeline(State& state)
+    : gs_batch(std::make_unique<GeometryShaderBatch>()), state(state) {}
 
 GeometryPipeline::~GeometryPipeline() = default;
 
@@ -315,6 +317,7 @@ void GeometryPipeline::Setup(Shader::ShaderEngine* shader_engine) {
 }
 
 void GeometryPipeline::Reconfigure() {
+    Flush();
     ASSERT(!backend || backend->IsEmpty());
 
     if (state.regs.pipeline.use_gs == PipelineRegs::UseGS::No) {
@@ -367,19 +370,37 @@ void GeometryPipeline::SubmitVertex(const Shader::AttributeBuffer& input) {
         vertex_handler(input);
     } else {
         if (backend->SubmitVertex(input)) {
-            shader_engine->Run(state.gs, state.gs_unit);
+            if (VideoCore::g_parallel_geometry_shader) {
+                gs_batch->Queue(state.gs, state.gs_unit, state.regs.gs.input_to_uniform != 0);
+            } else {
+                // Invocations queued before the setting was disabled have to run first
+                Flush();
+                shader_engine->Run(state.gs, state.gs_unit);
+            }
 
             // The uniform b15 is set to true after every geometry shader invocation. This is useful
             // for the shader to know if this is the first invocation in a batch, if the program set
             // b15 to false first.
             state.gs.uniforms.b[15] = true;
+
+            if (gs_batch->IsFull()) {
+                Flush();
+            }
         }
     }
 }
 
+void GeometryPipeline::Flush() {
+    if (!gs_batch->IsEmpty()) {
+        gs_batch->Run(*shader_engine, state.gs, state.gs_unit,
+                      VideoCore::g_parallel_geometry_shader);
+    }
+}
+
 template <class Archive>
 void GeometryPipeline::serialize(Archive& ar, const unsigned int version) {
-    // vertex_handler and shader_engine are always set to the same value
+    // vertex_handler and shader_engine are always set to the same value. Queued geometry shader
+    // invocations are always run by the end of a draw, before a savestate can be made.
     ar& backend;
 }
 
@@ -13,6 +13,7 @@ namespace Pica {
 struct State;
 
 class GeometryPipelineBackend;
+class GeometryShaderBatch;
 class GeometryPipeline_Point;
 class GeometryPipeline_VariablePrimitive;
 class GeometryPipeline_FixedPrimitive;
@@ -44,10 +45,17 @@ public:
     /// Submits vertex attributes output from vertex shader
     void SubmitVertex(const Shader::AttributeBuffer& input);
 
+    /**
+     * Runs the geometry shader invocations queued by SubmitVertex and sends the vertices they
+     * emit to the primitive assembler. Call this before drawing the submitted primitives.
+     */
+    void Flush();
+
 private:
     Shader::VertexHandler vertex_handler;
     Shader::ShaderEngine* shader_engine;
     std::unique_ptr<GeometryPipelineBackend> backend;
+    std::unique_ptr<GeometryShaderBatch> gs_batch;
     State& state;
 
     template <class Archive>
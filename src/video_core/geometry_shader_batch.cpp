@@ -0,0 +1,172 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include "video_core/geometry_shader_batch.h"
+
+namespace Pica {
+
+namespace {
+
+std::size_t GetNumThreads() {
+    return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+void CopyUnitState(const Shader::GSUnitState& from, Shader::GSUnitState& to) {
+    to.registers = from.registers;
+    std::copy_n(from.conditional_code, std::size(from.conditional_code), to.conditional_code);
+    std::copy_n(from.address_registers, std::size(from.address_registers), to.address_registers);
+    to.emitter.buffer = from.emitter.buffer;
+    to.emitter.vertex_id = from.emitter.vertex_id;
+    to.emitter.prim_emit = from.emitter.prim_emit;
+    to.emitter.winding = from.emitter.winding;
+    to.emitter.output_mask = from.emitter.output_mask;
+}
+
+} // Anonymous namespace
+
+/// Shader unit and setup used by one thread, and the vertices it emitted
+struct GeometryShaderBatch::Context {
+    struct EmittedVertex {
+        Shader::AttributeBuffer vertex;
+        bool set_winding;
+    };
+
+    Context() {
+        unit.SetVertexHandler(
+            [this](const Shader::AttributeBuffer& vertex) {
+                output.push_back({vertex, std::exchange(set_winding, false)});
+            },
+            [this] { set_winding = true; });
+    }
+
+    Shader::ShaderSetup setup;
+    Shader::GSUnitState unit;
+    u64 program_hash = 0;
+    u64 swizzle_hash = 0;
+    std::vector<EmittedVertex> output;
+    bool set_winding = false;
+};
+
+GeometryShaderBatch::GeometryShaderBatch() {
+    invocations.reserve(MAX_INVOCATIONS);
+}
+
+GeometryShaderBatch::~GeometryShaderBatch() = default;
+
+void GeometryShaderBatch::Queue(const Shader::ShaderSetup& setup, const Shader::GSUnitState& unit,
+                                bool input_to_uniform_) {
+    input_to_uniform = input_to_uniform_;
+    Store(invocations.emplace_back(), setup, unit);
+}
+
+void GeometryShaderBatch::Run(const Shader::ShaderEngine& engine, Shader::ShaderSetup& setup,
+                              Shader::GSUnitState& unit, bool parallel) {
+    if (invocations.empty()) {
+        return;
+    }
+
+    // The backend may already have written part of the inputs of the next invocation, keep them
+    // for when it is queued.
+    Invocation next;
+    Store(next, setup, unit);
+
+    const std::size_t num_threads =
+        parallel ? std::min(GetNumThreads(), invocations.size() / MIN_INVOCATIONS_PER_THREAD) : 1;
+    if (num_threads < 2) {
+        // Run them in order on the shared unit, as if each ran when it was queued
+        for (const Invocation& invocation : invocations) {
+            Load(invocation, setup, unit);
+            engine.Run(setup, unit);
+        }
+    } else {
+        RunParallel(engine, setup, unit, num_threads);
+    }
+    Load(next, setup, unit);
+    setup.uniforms.b[15] = true;
+    invocations.clear();
+}
+
+void GeometryShaderBatch::Store(Invocation& invocation, const Shader::ShaderSetup& setup,
+                                const Shader::GSUnitState& unit) const {
+    if (input_to_uniform) {
+        invocation.inputs = setup.uniforms.f;
+    } else {
+        std::copy(unit.registers.input.begin(), unit.registers.input.end(),
+                  invocation.inputs.begin());
+    }
+    invocation.b15 = setup.uniforms.b[15];
+}
+
+void GeometryShaderBatch::Load(const Invocation& invocation, Shader::ShaderSetup& setup,
+                               Shader::GSUnitState& unit) const {
+    if (input_to_uniform) {
+        setup.uniforms.f = invocation.inputs;
+    } else {
+        std::copy_n(invocation.inputs.begin(), unit.registers.input.size(),
+                    unit.registers.input.begin());
+    }
+    setup.uniforms.b[15] = invocation.b15;
+}
+
+void GeometryShaderBatch::RunParallel(const Shader::ShaderEngine& engine,
+                                      Shader::ShaderSetup& setup, Shader::GSUnitState& unit,
+                                      std::size_t num_threads) {
+    if (!workers) {
+        workers = std::make_unique<Common::ThreadWorker>(GetNumThreads() - 1, "GeometryShader");
+        contexts.resize(GetNumThreads());
+        for (auto& context : contexts) {
+            context = std::make_unique<Context>();
+        }
+    }
+
+    // Every thread starts from the state of the shared unit at the start of the batch, so state
+    // carried from one invocation to the next is only seen within the range of each thread.
+    const u64 program_hash = setup.GetProgramCodeHash();
+    const u64 swizzle_hash = setup.GetSwizzleDataHash();
+    for (std::size_t i = 0; i < num_threads; i++) {
+        Context& context = *contexts[i];
+        if (context.program_hash != program_hash || context.swizzle_hash != swizzle_hash) {
+            context.setup = setup;
+            context.program_hash = program_hash;
+            context.swizzle_hash = swizzle_hash;
+        } else {
+            context.setup.uniforms = setup.uniforms;
+            context.setup.engine_data = setup.engine_data;
+        }
+        CopyUnitState(unit, context.unit);
+        context.output.clear();
+        context.set_winding = false;
+    }
+
+    const auto run_range = [&](std::size_t thread) {
+        Context& context = *contexts[thread];
+        const std::size_t begin = invocations.size() * thread / num_threads;
+        const std::size_t end = invocations.size() * (thread + 1) / num_threads;
+        for (std::size_t i = begin; i < end; i++) {
+            Load(invocations[i], context.setup, context.unit);
+            engine.Run(context.setup, context.unit);
+        }
+    };
+    for (std::size_t i = 1; i < num_threads; i++) {
+        workers->QueueWork([&run_range, i] { run_range(i); });
+    }
+    run_range(0);
+    workers->WaitForRequests();
+
+    // Merge the emitted vertices in submission order
+    for (std::size_t i = 0; i < num_threads; i++) {
+        for (const Context::EmittedVertex& emitted : contexts[i]->output) {
+            if (emitted.set_winding) {
+                unit.emitter.handlers->winding_setter();
+            }
+            unit.emitter.handlers->vertex_handler(emitted.vertex);
+        }
+    }
+    CopyUnitState(contexts[num_threads - 1]->unit, unit);
+}
+
+} // namespace Pica
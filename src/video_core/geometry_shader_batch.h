@@ -0,0 +1,78 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "common/thread_worker.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/**
+ * Queues geometry shader invocations along with the inputs they would have started with, and runs
+ * them in batches. Large batches can be split across threads, each with its own shader unit and
+ * copy of the shader setup, and the vertices emitted by each thread are sent to the primitive
+ * assembler in submission order once all of them are done.
+ */
+class GeometryShaderBatch {
+public:
+    /// Number of invocations after which the batch is run anyway, which bounds its memory use
+    static constexpr std::size_t MAX_INVOCATIONS = 512;
+    /// Smallest number of invocations worth handing to another thread
+    static constexpr std::size_t MIN_INVOCATIONS_PER_THREAD = 32;
+
+    GeometryShaderBatch();
+    ~GeometryShaderBatch();
+
+    [[nodiscard]] bool IsEmpty() const {
+        return invocations.empty();
+    }
+
+    [[nodiscard]] bool IsFull() const {
+        return invocations.size() >= MAX_INVOCATIONS;
+    }
+
+    /// Queues an invocation with the inputs currently loaded in setup and unit.
+    void Queue(const Shader::ShaderSetup& setup, const Shader::GSUnitState& unit,
+               bool input_to_uniform_);
+
+    /**
+     * Runs the queued invocations, sending the vertices they emit to the handlers of unit. The
+     * inputs loaded in setup and unit when called, such as those of an unfinished primitive, are
+     * restored afterwards.
+     * @param parallel Whether large batches are split across threads. Every thread starts from the
+     *                 state of unit at the start of the batch, so the results only match running
+     *                 the invocations in order if none of them reads registers or emitter state
+     *                 left by a previous one.
+     */
+    void Run(const Shader::ShaderEngine& engine, Shader::ShaderSetup& setup,
+             Shader::GSUnitState& unit, bool parallel);
+
+private:
+    struct Invocation {
+        /// Float uniforms, or input registers in Point mode, the invocation starts with
+        decltype(Shader::Uniforms::f) inputs;
+        bool b15;
+    };
+
+    struct Context;
+
+    void Store(Invocation& invocation, const Shader::ShaderSetup& setup,
+               const Shader::GSUnitState& unit) const;
+
+    void Load(const Invocation& invocation, Shader::ShaderSetup& setup,
+              Shader::GSUnitState& unit) const;
+
+    void RunParallel(const Shader::ShaderEngine& engine, Shader::ShaderSetup& setup,
+                     Shader::GSUnitState& unit, std::size_t num_threads);
+
+    std::vector<Invocation> invocations;
+    bool input_to_uniform = false;
+    std::unique_ptr<Common::ThreadWorker> workers;
+    std::vector<std::unique_ptr<Context>> contexts;
+};
+
+} // namespace Pica
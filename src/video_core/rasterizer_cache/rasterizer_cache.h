@@ -1011,7 +1011,8 @@ void RasterizerCache<T>::UploadSurface(Surface& surface, SurfaceInterval interva
                   runtime.NeedsConversion(surface.pixel_format));
 
     if (dump_textures && False(surface.flags & SurfaceFlagBits::Custom)) {
-        const u64 hash = Common::ComputeHash64(upload_data.data(), upload_data.size());
+        const u64 hash =
+            ComputeTextureHash(load_info, upload_data, false, surface.GetInternalBytesPerPixel());
         const u32 level = surface.LevelOf(load_info.addr);
         custom_tex_manager.DumpTexture(load_info, level, upload_data, hash);
     }
@@ -1039,18 +1040,8 @@ bool RasterizerCache<T>::UploadCustomSurface(SurfaceId surface_id, SurfaceInterv
     }
 
     const auto upload_data = source_ptr.GetWriteBytes(load_info.end - load_info.addr);
-    const u64 hash = [&] {
-        if (!custom_tex_manager.UseNewHash()) {
-            const u32 width = load_info.width;
-            const u32 height = load_info.height;
-            const u32 bpp = surface.GetInternalBytesPerPixel();
-            auto decoded = std::vector<u8>(width * height * bpp);
-            DecodeTexture(load_info, load_info.addr, load_info.end, upload_data, decoded, false);
-            return Common::ComputeHash64(decoded.data(), decoded.size());
-        } else {
-            return Common::ComputeHash64(upload_data.data(), upload_data.size());
-        }
-    }();
+    const u64 hash = ComputeTextureHash(load_info, upload_data, !custom_tex_manager.UseNewHash(),
+                                        surface.GetInternalBytesPerPixel());
 
     const u32 level = surface.LevelOf(load_info.addr);
     Material* material = custom_tex_manager.GetMaterial(hash);
@@ -1084,6 +1075,79 @@ bool RasterizerCache<T>::UploadCustomSurface(SurfaceId surface_id, SurfaceInterv
     return custom_tex_manager.Decode(material, std::move(upload));
 }
 
+template <class T>
+u64 RasterizerCache<T>::ComputeTextureHash(const SurfaceParams& load_info,
+                                           std::span<u8> upload_data, bool decoded,
+                                           u32 bytes_per_pixel) {
+    const TextureHashKey key = {
+        .addr = load_info.addr,
+        .end = load_info.end,
+        .width = load_info.width,
+        .height = load_info.height,
+        .stride = load_info.stride,
+        .pixel_format = load_info.pixel_format,
+        .is_tiled = load_info.is_tiled,
+        .decoded = decoded,
+    };
+    if (const auto it = texture_hashes.find(key); it != texture_hashes.end()) {
+        return it->second;
+    }
+
+    u64 hash;
+    if (decoded) {
+        decoded_texture.resize(load_info.width * load_info.height * bytes_per_pixel);
+        DecodeTexture(load_info, load_info.addr, load_info.end, upload_data, decoded_texture,
+                      false);
+        hash = Common::ComputeHash64(decoded_texture.data(), decoded_texture.size());
+    } else {
+        hash = Common::ComputeHash64(upload_data.data(), upload_data.size());
+    }
+
+    // Keep the pages tracked while the hash is cached, so that any write to the data reaches
+    // InvalidateRegion even when no surface covers it anymore.
+    const u32 size = key.end - key.addr;
+    texture_hashes.emplace(key, hash);
+    UpdatePagesCachedCount(key.addr, size, 1);
+    ForEachPage(key.addr, size,
+                [this, &key](u64 page) { texture_hash_pages[page].push_back(key); });
+    return hash;
+}
+
+template <class T>
+void RasterizerCache<T>::InvalidateTextureHashes(PAddr addr, u32 size) {
+    if (texture_hashes.empty()) {
+        return;
+    }
+
+    const PAddr end = addr + size;
+    boost::container::small_vector<TextureHashKey, 4> stale_keys;
+    ForEachPage(addr, size, [&](u64 page) {
+        const auto page_it = texture_hash_pages.find(page);
+        if (page_it == texture_hash_pages.end()) {
+            return;
+        }
+        for (const TextureHashKey& key : page_it->second) {
+            // Keys spanning several of the pages are only erased once.
+            if (key.addr < end && addr < key.end && texture_hashes.erase(key) != 0) {
+                stale_keys.push_back(key);
+            }
+        }
+    });
+
+    for (const TextureHashKey& key : stale_keys) {
+        const u32 key_size = key.end - key.addr;
+        UpdatePagesCachedCount(key.addr, key_size, -1);
+        ForEachPage(key.addr, key_size, [this, &key](u64 page) {
+            const auto page_it = texture_hash_pages.find(page);
+            std::vector<TextureHashKey>& keys = page_it.value();
+            keys.erase(std::find(keys.begin(), keys.end(), key));
+            if (keys.empty()) {
+                texture_hash_pages.erase(page_it);
+            }
+        });
+    }
+}
+
 template <class T>
 void RasterizerCache<T>::DownloadSurface(Surface& surface, SurfaceInterval interval) {
     MICROPROFILE_SCOPE(RasterizerCache_DownloadSurface);
@@ -1214,6 +1278,8 @@ void RasterizerCache<T>::ClearAll(bool flush) {
     cached_pages -= flush_interval;
     dirty_regions -= SurfaceInterval(0x0, 0xFFFFFFFF);
     page_table.clear();
+    texture_hashes.clear();
+    texture_hash_pages.clear();
     remove_surfaces.clear();
 }
 
@@ -1279,6 +1345,7 @@ void RasterizerCache<T>::InvalidateRegion(PAddr addr, u32 size, SurfaceId region
     }
 
     const SurfaceInterval invalid_interval(addr, addr + size);
+    InvalidateTextureHashes(addr, size);
 
     if (region_owner_id) {
         Surface& region_owner = slot_surfaces[region_owner_id];
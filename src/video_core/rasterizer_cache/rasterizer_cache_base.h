@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <optional>
+#include <span>
 #include <unordered_map>
 #include <vector>
 #include <boost/icl/interval_map.hpp>
@@ -76,6 +77,26 @@ class RasterizerCache {
         std::array<u64, 6> ticks;
     };
 
+    /// Identifies the guest data hashed for texture dumping or replacement.
+    struct TextureHashKey {
+        PAddr addr;
+        PAddr end;
+        u32 width;
+        u32 height;
+        u32 stride;
+        PixelFormat pixel_format;
+        u32 is_tiled;
+        u32 decoded; ///< Whether the decoded texture was hashed instead of the guest data
+
+        bool operator==(const TextureHashKey&) const = default;
+    };
+
+    struct TextureHashKeyHash {
+        std::size_t operator()(const TextureHashKey& key) const noexcept {
+            return Common::ComputeStructHash64(key);
+        }
+    };
+
 public:
     explicit RasterizerCache(Memory::MemorySystem& memory, CustomTexManager& custom_tex_manager,
                              Runtime& runtime, Pica::Regs& regs, RendererBase& renderer);
@@ -178,6 +199,14 @@ private:
     /// Uploads a custom texture identified with hash to the target surface
     bool UploadCustomSurface(SurfaceId surface_id, SurfaceInterval interval);
 
+    /// Returns the hash of the texture data of load_info, reusing it if the data was not written
+    /// since it was last computed. Legacy packs hash the decoded texture instead of the guest data.
+    u64 ComputeTextureHash(const SurfaceParams& load_info, std::span<u8> upload_data,
+                           bool decoded, u32 bytes_per_pixel);
+
+    /// Forgets the cached texture hashes overlapping the region
+    void InvalidateTextureHashes(PAddr addr, u32 size);
+
     /// Copies pixel data in interval from the host GPU surface to the guest VRAM
     void DownloadSurface(Surface& surface, SurfaceInterval interval);
 
@@ -213,6 +242,10 @@ private:
     Pica::Regs& regs;
     RendererBase& renderer;
     std::unordered_map<TextureCubeConfig, TextureCube> texture_cube_cache;
+    std::unordered_map<TextureHashKey, u64, TextureHashKeyHash> texture_hashes;
+    tsl::robin_pg_map<u64, std::vector<TextureHashKey>, Common::IdentityHash<u64>>
+        texture_hash_pages;
+    std::vector<u8> decoded_texture;
     tsl::robin_pg_map<u64, std::vector<SurfaceId>, Common::IdentityHash<u64>> page_table;
     std::unordered_map<SamplerParams, SamplerId> samplers;
     Common::SlotVector<Surface> slot_surfaces;
@@ -4,6 +4,7 @@
 
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
@@ -106,6 +107,8 @@ RasterizerOpenGL::RasterizerOpenGL(Memory::MemorySystem& memory,
         Common::AlignUp<std::size_t>(sizeof(Pica::Shader::VSUniformData), uniform_buffer_alignment);
     uniform_size_aligned_fs =
         Common::AlignUp<std::size_t>(sizeof(Pica::Shader::UniformData), uniform_buffer_alignment);
+    uniform_size_aligned_uber =
+        Common::AlignUp<std::size_t>(sizeof(UberFSConfigData), uniform_buffer_alignment);
 
     // Set vertex attributes for software shader path
     state.draw.vertex_array = sw_vao.handle;
@@ -177,6 +180,7 @@ RasterizerOpenGL::~RasterizerOpenGL() = default;
 
 void RasterizerOpenGL::TickFrame() {
     res_cache.TickFrame();
+    shader_program_manager->TickFrame();
 }
 
 void RasterizerOpenGL::LoadDiskResources(const std::atomic_bool& stop_loading,
@@ -198,8 +202,9 @@ void RasterizerOpenGL::SyncFixedState() {
     SyncDepthWriteMask();
 }
 
-void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
-                                        GLuint vs_input_index_min, GLuint vs_input_index_max) {
+GLsizeiptr RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
+                                              GLuint vs_input_index_min,
+                                              GLuint vs_input_index_max) {
     MICROPROFILE_SCOPE(OpenGL_VAO);
     const auto& vertex_attributes = regs.pipeline.vertex_attributes;
     PAddr base_address = vertex_attributes.GetPhysicalBaseAddress();
@@ -209,12 +214,39 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
     state.Apply();
 
     std::array<bool, 16> enable_attributes{};
+    GLsizeiptr uploaded_size = 0;
+    GLsizeiptr cached_size = 0;
 
     for (const auto& loader : vertex_attributes.attribute_loaders) {
         if (loader.component_count == 0 || loader.byte_count == 0) {
             continue;
         }
 
+        const PAddr data_addr =
+            base_address + loader.data_offset + (vs_input_index_min * loader.byte_count);
+
+        const u32 vertex_num = vs_input_index_max - vs_input_index_min + 1;
+        const u32 data_size = loader.byte_count * vertex_num;
+
+        // Static meshes are drawn from the same unmodified memory for many frames, reuse the copy
+        // uploaded by an earlier draw when there is one.
+        res_cache.FlushRegion(data_addr, data_size);
+        const u8* data = memory.GetPhysicalPointer(data_addr);
+        const u64 data_hash = Common::ComputeHash64(data, data_size);
+        GLintptr data_offset;
+        if (const auto cached = vertex_uploads.Find(data_addr, data_size, data_hash)) {
+            data_offset = *cached;
+            cached_size += data_size;
+        } else {
+            std::memcpy(array_ptr, data, data_size);
+            vertex_uploads.Insert(data_addr, data_size, data_hash, buffer_offset);
+            data_offset = buffer_offset;
+
+            array_ptr += data_size;
+            buffer_offset += data_size;
+            uploaded_size += data_size;
+        }
+
         u32 offset = 0;
         for (u32 comp = 0; comp < loader.component_count && comp < 12; ++comp) {
             u32 attribute_index = loader.GetComponent(comp);
@@ -228,7 +260,7 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
                     GLenum type = MakeAttributeType(vertex_attributes.GetFormat(attribute_index));
                     GLsizei stride = loader.byte_count;
                     glVertexAttribPointer(input_reg, size, type, GL_FALSE, stride,
-                                          reinterpret_cast<GLvoid*>(buffer_offset + offset));
+                                          reinterpret_cast<GLvoid*>(data_offset + offset));
                     enable_attributes[input_reg] = true;
 
                     offset += vertex_attributes.GetStride(attribute_index);
@@ -240,20 +272,11 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
                 offset += (attribute_index - 11) * 4;
             }
         }
-
-        const PAddr data_addr =
-            base_address + loader.data_offset + (vs_input_index_min * loader.byte_count);
-
-        const u32 vertex_num = vs_input_index_max - vs_input_index_min + 1;
-        const u32 data_size = loader.byte_count * vertex_num;
-
-        res_cache.FlushRegion(data_addr, data_size);
-        std::memcpy(array_ptr, memory.GetPhysicalPointer(data_addr), data_size);
-
-        array_ptr += data_size;
-        buffer_offset += data_size;
     }
 
+    MICROPROFILE_META_CPU("Vertex Bytes Uploaded", static_cast<int>(uploaded_size));
+    MICROPROFILE_META_CPU("Vertex Bytes Reused", static_cast<int>(cached_size));
+
     for (std::size_t i = 0; i < enable_attributes.size(); ++i) {
         if (enable_attributes[i] != hw_vao_enabled_attributes[i]) {
             if (enable_attributes[i]) {
@@ -273,6 +296,8 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
             }
         }
     }
+
+    return uploaded_size;
 }
 
 bool RasterizerOpenGL::SetupVertexShader() {
@@ -325,11 +350,19 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
 
     u8* buffer_ptr;
     GLintptr buffer_offset;
-    std::tie(buffer_ptr, buffer_offset, std::ignore) = vertex_buffer.Map(vs_input_size, 4);
-    SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
-    vertex_buffer.Unmap(vs_input_size);
+    bool invalidated;
+    std::tie(buffer_ptr, buffer_offset, invalidated) = vertex_buffer.Map(vs_input_size, 4);
+    if (invalidated) {
+        vertex_uploads.Clear();
+    }
+    const GLsizeiptr uploaded_size =
+        SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
+    vertex_buffer.Unmap(uploaded_size);
 
-    shader_program_manager->ApplyTo(state);
+    if (!shader_program_manager->ApplyTo(state)) {
+        // The shaders of this draw are still being compiled
+        return true;
+    }
     state.Apply();
 
     if (is_indexed) {
@@ -341,12 +374,24 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
             return false;
         }
 
-        const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(
-            regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() +
-            regs.pipeline.index_array.offset);
-        std::tie(buffer_ptr, buffer_offset, std::ignore) = index_buffer.Map(index_buffer_size, 4);
-        std::memcpy(buffer_ptr, index_data, index_buffer_size);
-        index_buffer.Unmap(index_buffer_size);
+        const PAddr index_addr = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() +
+                                 regs.pipeline.index_array.offset;
+        const u32 index_size = static_cast<u32>(index_buffer_size);
+        const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(index_addr);
+        const u64 index_hash = Common::ComputeHash64(index_data, index_size);
+        if (const auto cached = index_uploads.Find(index_addr, index_size, index_hash)) {
+            buffer_offset = *cached;
+        } else {
+            std::tie(buffer_ptr, buffer_offset, invalidated) =
+                index_buffer.Map(index_buffer_size, 4);
+            if (invalidated) {
+                index_uploads.Clear();
+            }
+            std::memcpy(buffer_ptr, index_data, index_buffer_size);
+            index_buffer.Unmap(index_buffer_size);
+            index_uploads.Insert(index_addr, index_size, index_hash, buffer_offset);
+            MICROPROFILE_META_CPU("Index Bytes Uploaded", static_cast<int>(index_size));
+        }
 
         glDrawRangeElementsBaseVertex(
             primitive_mode, vs_input_index_min, vs_input_index_max, regs.pipeline.num_vertices,
@@ -443,6 +488,7 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     if (shader_dirty) {
         shader_program_manager->UseFragmentShader(regs, use_custom_normal);
         shader_dirty = false;
+        uber_config_dirty = true;
     }
 
     // Sync the LUTs within the texture buffer
@@ -461,16 +507,21 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         state.draw.vertex_buffer = vertex_buffer.GetHandle();
         shader_program_manager->UseTrivialVertexShader();
         shader_program_manager->UseTrivialGeometryShader();
-        shader_program_manager->ApplyTo(state);
+        const bool shaders_ready = shader_program_manager->ApplyTo(state);
         state.Apply();
 
+        // Skip the draw while its fragment shader is still being compiled
         std::size_t max_vertices = 3 * (VERTEX_BUFFER_SIZE / (3 * sizeof(HardwareVertex)));
-        for (std::size_t base_vertex = 0; base_vertex < vertex_batch.size();
+        for (std::size_t base_vertex = 0; shaders_ready && base_vertex < vertex_batch.size();
              base_vertex += max_vertices) {
             const std::size_t vertices = std::min(max_vertices, vertex_batch.size() - base_vertex);
             const std::size_t vertex_size = vertices * sizeof(HardwareVertex);
 
-            const auto [vbo, offset, _] = vertex_buffer.Map(vertex_size, sizeof(HardwareVertex));
+            const auto [vbo, offset, invalidated] =
+                vertex_buffer.Map(vertex_size, sizeof(HardwareVertex));
+            if (invalidated) {
+                vertex_uploads.Clear();
+            }
             std::memcpy(vbo, vertex_batch.data() + base_vertex, vertex_size);
             vertex_buffer.Unmap(vertex_size);
 
@@ -1101,11 +1152,14 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
 
     bool sync_vs = accelerate_draw;
     bool sync_fs = uniform_block_data.dirty;
+    const UberFSConfigData* uber_config = shader_program_manager->GetUberShaderConfig();
+    bool sync_uber = uber_config && uber_config_dirty;
 
-    if (!sync_vs && !sync_fs)
+    if (!sync_vs && !sync_fs && !sync_uber)
         return;
 
-    std::size_t uniform_size = uniform_size_aligned_vs + uniform_size_aligned_fs;
+    std::size_t uniform_size =
+        uniform_size_aligned_vs + uniform_size_aligned_fs + uniform_size_aligned_uber;
     std::size_t used_bytes = 0;
     u8* uniforms;
     GLintptr offset;
@@ -1133,6 +1187,15 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
         used_bytes += uniform_size_aligned_fs;
     }
 
+    if (uber_config && (sync_uber || invalidate)) {
+        std::memcpy(uniforms + used_bytes, uber_config, sizeof(UberFSConfigData));
+        glBindBufferRange(
+            GL_UNIFORM_BUFFER, static_cast<GLuint>(Pica::Shader::UniformBindings::FSConfig),
+            uniform_buffer.GetHandle(), offset + used_bytes, sizeof(UberFSConfigData));
+        uber_config_dirty = false;
+        used_bytes += uniform_size_aligned_uber;
+    }
+
     uniform_buffer.Unmap(used_bytes);
 }
 
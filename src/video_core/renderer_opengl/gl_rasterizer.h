@@ -119,9 +119,13 @@ private:
     /// Internal implementation for AccelerateDrawBatch
     bool AccelerateDrawBatchInternal(bool is_indexed);
 
-    /// Setup vertex array for AccelerateDrawBatch
-    void SetupVertexArray(u8* array_ptr, GLintptr buffer_offset, GLuint vs_input_index_min,
-                          GLuint vs_input_index_max);
+    /**
+     * Setup vertex array for AccelerateDrawBatch. Vertex data that is already resident in the
+     * vertex buffer is reused, the rest is copied to array_ptr.
+     * @returns The number of bytes written to array_ptr
+     */
+    GLsizeiptr SetupVertexArray(u8* array_ptr, GLintptr buffer_offset, GLuint vs_input_index_min,
+                                GLuint vs_input_index_max);
 
     /// Setup vertex shader for AccelerateDrawBatch
     bool SetupVertexShader();
@@ -147,15 +151,19 @@ private:
     OGLStreamBuffer index_buffer;
     OGLStreamBuffer texture_buffer;
     OGLStreamBuffer texture_lf_buffer;
+    StreamUploadCache vertex_uploads;
+    StreamUploadCache index_uploads;
     OGLFramebuffer framebuffer;
     GLint uniform_buffer_alignment;
     std::size_t uniform_size_aligned_vs;
     std::size_t uniform_size_aligned_fs;
+    std::size_t uniform_size_aligned_uber;
 
     OGLTexture texture_buffer_lut_lf;
     OGLTexture texture_buffer_lut_rg;
     OGLTexture texture_buffer_lut_rgba;
     bool use_custom_normal{};
+    bool uber_config_dirty = true;
 };
 
 } // namespace OpenGL
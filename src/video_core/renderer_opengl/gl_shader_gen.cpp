@@ -2,9 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <mutex>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <fmt/format.h>
 #include "common/bit_set.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "video_core/pica_state.h"
@@ -307,238 +312,260 @@ static std::string SampleTexture(const PicaFSConfig& config, unsigned texture_un
     }
 }
 
+/// Names of the TEV stage sources, indexed by TevStageConfig::Source. Textures are sampled once
+/// before the stages, see AppendTextureColors.
+constexpr std::array<std::string_view, 16> tev_source_names{
+    "rounded_primary_color",
+    "primary_fragment_color",
+    "secondary_fragment_color",
+    "texcolor0",
+    "texcolor1",
+    "texcolor2",
+    "texcolor3",
+    {},
+    {},
+    {},
+    {},
+    {},
+    {},
+    "combiner_buffer",
+    "const_color[tev_stage]",
+    "last_tex_env_out",
+};
+
+/// Prefix and swizzle applied to a source by a TEV color modifier, indexed by
+/// TevStageConfig::ColorModifier. Entries without a swizzle are invalid modifiers.
+constexpr std::array<std::pair<std::string_view, std::string_view>, 16> tev_color_modifiers{{
+    {"", ".rgb"},
+    {"vec3(1.0) - ", ".rgb"},
+    {"", ".aaa"},
+    {"vec3(1.0) - ", ".aaa"},
+    {"", ".rrr"},
+    {"vec3(1.0) - ", ".rrr"},
+    {},
+    {},
+    {"", ".ggg"},
+    {"vec3(1.0) - ", ".ggg"},
+    {},
+    {},
+    {"", ".bbb"},
+    {"vec3(1.0) - ", ".bbb"},
+    {},
+    {},
+}};
+
+/// Prefix and swizzle applied to a source by a TEV alpha modifier, indexed by
+/// TevStageConfig::AlphaModifier
+constexpr std::array<std::pair<std::string_view, std::string_view>, 8> tev_alpha_modifiers{{
+    {"", ".a"},
+    {"1.0 - ", ".a"},
+    {"", ".r"},
+    {"1.0 - ", ".r"},
+    {"", ".g"},
+    {"1.0 - ", ".g"},
+    {"", ".b"},
+    {"1.0 - ", ".b"},
+}};
+
+/// Combiner functions for the color components, indexed by TevStageConfig::Operation
+constexpr std::array<std::string_view, 16> tev_color_combiners{
+    "color_results[0]",
+    "color_results[0] * color_results[1]",
+    "color_results[0] + color_results[1]",
+    "color_results[0] + color_results[1] - vec3(0.5)",
+    "color_results[0] * color_results[2] + color_results[1] * (vec3(1.0) - color_results[2])",
+    "color_results[0] - color_results[1]",
+    "vec3(dot(color_results[0] - vec3(0.5), color_results[1] - vec3(0.5)) * 4.0)",
+    "vec3(dot(color_results[0] - vec3(0.5), color_results[1] - vec3(0.5)) * 4.0)",
+    "color_results[0] * color_results[1] + color_results[2]",
+    "min(color_results[0] + color_results[1], vec3(1.0)) * color_results[2]",
+};
+
+/// Combiner functions for the alpha component, indexed by TevStageConfig::Operation
+constexpr std::array<std::string_view, 16> tev_alpha_combiners{
+    "alpha_results[0]",
+    "alpha_results[0] * alpha_results[1]",
+    "alpha_results[0] + alpha_results[1]",
+    "alpha_results[0] + alpha_results[1] - 0.5",
+    "alpha_results[0] * alpha_results[2] + alpha_results[1] * (1.0 - alpha_results[2])",
+    "alpha_results[0] - alpha_results[1]",
+    {},
+    {},
+    "alpha_results[0] * alpha_results[1] + alpha_results[2]",
+    "min(alpha_results[0] + alpha_results[1], 1.0) * alpha_results[2]",
+};
+
 /// Writes the specified TEV stage source component(s)
-static void AppendSource(std::string& out, const PicaFSConfig& config,
-                         TevStageConfig::Source source, std::string_view index_name) {
-    using Source = TevStageConfig::Source;
-    switch (source) {
-    case Source::PrimaryColor:
-        out += "rounded_primary_color";
-        break;
-    case Source::PrimaryFragmentColor:
-        out += "primary_fragment_color";
-        break;
-    case Source::SecondaryFragmentColor:
-        out += "secondary_fragment_color";
-        break;
-    case Source::Texture0:
-        out += SampleTexture(config, 0);
-        break;
-    case Source::Texture1:
-        out += SampleTexture(config, 1);
-        break;
-    case Source::Texture2:
-        out += SampleTexture(config, 2);
-        break;
-    case Source::Texture3:
-        out += SampleTexture(config, 3);
-        break;
-    case Source::PreviousBuffer:
-        out += "combiner_buffer";
-        break;
-    case Source::Constant:
-        out += "const_color[";
-        out += index_name;
-        out += ']';
-        break;
-    case Source::Previous:
-        out += "last_tex_env_out";
-        break;
-    default:
+static void AppendSource(std::string& out, TevStageConfig::Source source) {
+    const std::string_view name = tev_source_names[static_cast<u32>(source) & 0xF];
+    if (name.empty()) {
         out += "vec4(0.0)";
         LOG_CRITICAL(Render_OpenGL, "Unknown source op {}", source);
-        break;
+        return;
     }
+    out += name;
 }
 
 /// Writes the color components to use for the specified TEV stage color modifier
-static void AppendColorModifier(std::string& out, const PicaFSConfig& config,
-                                TevStageConfig::ColorModifier modifier,
-                                TevStageConfig::Source source, std::string_view index_name) {
-    using ColorModifier = TevStageConfig::ColorModifier;
-    switch (modifier) {
-    case ColorModifier::SourceColor:
-        AppendSource(out, config, source, index_name);
-        out += ".rgb";
-        break;
-    case ColorModifier::OneMinusSourceColor:
-        out += "vec3(1.0) - ";
-        AppendSource(out, config, source, index_name);
-        out += ".rgb";
-        break;
-    case ColorModifier::SourceAlpha:
-        AppendSource(out, config, source, index_name);
-        out += ".aaa";
-        break;
-    case ColorModifier::OneMinusSourceAlpha:
-        out += "vec3(1.0) - ";
-        AppendSource(out, config, source, index_name);
-        out += ".aaa";
-        break;
-    case ColorModifier::SourceRed:
-        AppendSource(out, config, source, index_name);
-        out += ".rrr";
-        break;
-    case ColorModifier::OneMinusSourceRed:
-        out += "vec3(1.0) - ";
-        AppendSource(out, config, source, index_name);
-        out += ".rrr";
-        break;
-    case ColorModifier::SourceGreen:
-        AppendSource(out, config, source, index_name);
-        out += ".ggg";
-        break;
-    case ColorModifier::OneMinusSourceGreen:
-        out += "vec3(1.0) - ";
-        AppendSource(out, config, source, index_name);
-        out += ".ggg";
-        break;
-    case ColorModifier::SourceBlue:
-        AppendSource(out, config, source, index_name);
-        out += ".bbb";
-        break;
-    case ColorModifier::OneMinusSourceBlue:
-        out += "vec3(1.0) - ";
-        AppendSource(out, config, source, index_name);
-        out += ".bbb";
-        break;
-    default:
+static void AppendColorModifier(std::string& out, TevStageConfig::ColorModifier modifier,
+                                TevStageConfig::Source source) {
+    const auto& [prefix, swizzle] = tev_color_modifiers[static_cast<u32>(modifier) & 0xF];
+    if (swizzle.empty()) {
         out += "vec3(0.0)";
         LOG_CRITICAL(Render_OpenGL, "Unknown color modifier op {}", modifier);
-        break;
+        return;
     }
+    out += prefix;
+    AppendSource(out, source);
+    out += swizzle;
 }
 
 /// Writes the alpha component to use for the specified TEV stage alpha modifier
-static void AppendAlphaModifier(std::string& out, const PicaFSConfig& config,
-                                TevStageConfig::AlphaModifier modifier,
-                                TevStageConfig::Source source, const std::string& index_name) {
-    using AlphaModifier = TevStageConfig::AlphaModifier;
-    switch (modifier) {
-    case AlphaModifier::SourceAlpha:
-        AppendSource(out, config, source, index_name);
-        out += ".a";
-        break;
-    case AlphaModifier::OneMinusSourceAlpha:
-        out += "1.0 - ";
-        AppendSource(out, config, source, index_name);
-        out += ".a";
-        break;
-    case AlphaModifier::SourceRed:
-        AppendSource(out, config, source, index_name);
-        out += ".r";
-        break;
-    case AlphaModifier::OneMinusSourceRed:
-        out += "1.0 - ";
-        AppendSource(out, config, source, index_name);
-        out += ".r";
-        break;
-    case AlphaModifier::SourceGreen:
-        AppendSource(out, config, source, index_name);
-        out += ".g";
-        break;
-    case AlphaModifier::OneMinusSourceGreen:
-        out += "1.0 - ";
-        AppendSource(out, config, source, index_name);
-        out += ".g";
-        break;
-    case AlphaModifier::SourceBlue:
-        AppendSource(out, config, source, index_name);
-        out += ".b";
-        break;
-    case AlphaModifier::OneMinusSourceBlue:
-        out += "1.0 - ";
-        AppendSource(out, config, source, index_name);
-        out += ".b";
-        break;
-    default:
-        out += "0.0";
-        LOG_CRITICAL(Render_OpenGL, "Unknown alpha modifier op {}", modifier);
-        break;
-    }
+static void AppendAlphaModifier(std::string& out, TevStageConfig::AlphaModifier modifier,
+                                TevStageConfig::Source source) {
+    const auto& [prefix, swizzle] = tev_alpha_modifiers[static_cast<u32>(modifier) & 0x7];
+    out += prefix;
+    AppendSource(out, source);
+    out += swizzle;
 }
 
 /// Writes the combiner function for the color components for the specified TEV stage operation
-static void AppendColorCombiner(std::string& out, TevStageConfig::Operation operation,
-                                std::string_view variable_name) {
+static void AppendColorCombiner(std::string& out, TevStageConfig::Operation operation) {
+    const std::string_view combiner = tev_color_combiners[static_cast<u32>(operation) & 0xF];
     out += "clamp(";
-    using Operation = TevStageConfig::Operation;
-    switch (operation) {
-    case Operation::Replace:
-        out += fmt::format("{}[0]", variable_name);
-        break;
-    case Operation::Modulate:
-        out += fmt::format("{0}[0] * {0}[1]", variable_name);
-        break;
-    case Operation::Add:
-        out += fmt::format("{0}[0] + {0}[1]", variable_name);
-        break;
-    case Operation::AddSigned:
-        out += fmt::format("{0}[0] + {0}[1] - vec3(0.5)", variable_name);
-        break;
-    case Operation::Lerp:
-        out += fmt::format("{0}[0] * {0}[2] + {0}[1] * (vec3(1.0) - {0}[2])", variable_name);
-        break;
-    case Operation::Subtract:
-        out += fmt::format("{0}[0] - {0}[1]", variable_name);
-        break;
-    case Operation::MultiplyThenAdd:
-        out += fmt::format("{0}[0] * {0}[1] + {0}[2]", variable_name);
-        break;
-    case Operation::AddThenMultiply:
-        out += fmt::format("min({0}[0] + {0}[1], vec3(1.0)) * {0}[2]", variable_name);
-        break;
-    case Operation::Dot3_RGB:
-    case Operation::Dot3_RGBA:
-        out +=
-            fmt::format("vec3(dot({0}[0] - vec3(0.5), {0}[1] - vec3(0.5)) * 4.0)", variable_name);
-        break;
-    default:
+    if (combiner.empty()) {
         out += "vec3(0.0)";
         LOG_CRITICAL(Render_OpenGL, "Unknown color combiner operation: {}", operation);
-        break;
+    } else {
+        out += combiner;
     }
     out += ", vec3(0.0), vec3(1.0))"; // Clamp result to 0.0, 1.0
 }
 
 /// Writes the combiner function for the alpha component for the specified TEV stage operation
-static void AppendAlphaCombiner(std::string& out, TevStageConfig::Operation operation,
-                                std::string_view variable_name) {
+static void AppendAlphaCombiner(std::string& out, TevStageConfig::Operation operation) {
+    const std::string_view combiner = tev_alpha_combiners[static_cast<u32>(operation) & 0xF];
     out += "clamp(";
-    using Operation = TevStageConfig::Operation;
-    switch (operation) {
-    case Operation::Replace:
-        out += fmt::format("{}[0]", variable_name);
-        break;
-    case Operation::Modulate:
-        out += fmt::format("{0}[0] * {0}[1]", variable_name);
-        break;
-    case Operation::Add:
-        out += fmt::format("{0}[0] + {0}[1]", variable_name);
-        break;
-    case Operation::AddSigned:
-        out += fmt::format("{0}[0] + {0}[1] - 0.5", variable_name);
-        break;
-    case Operation::Lerp:
-        out += fmt::format("{0}[0] * {0}[2] + {0}[1] * (1.0 - {0}[2])", variable_name);
-        break;
-    case Operation::Subtract:
-        out += fmt::format("{0}[0] - {0}[1]", variable_name);
-        break;
-    case Operation::MultiplyThenAdd:
-        out += fmt::format("{0}[0] * {0}[1] + {0}[2]", variable_name);
-        break;
-    case Operation::AddThenMultiply:
-        out += fmt::format("min({0}[0] + {0}[1], 1.0) * {0}[2]", variable_name);
-        break;
-    default:
+    if (combiner.empty()) {
         out += "0.0";
         LOG_CRITICAL(Render_OpenGL, "Unknown alpha combiner operation: {}", operation);
-        break;
+    } else {
+        out += combiner;
     }
     out += ", 0.0, 1.0)";
 }
 
+/// Returns a mask of the texture units read by the TEV stages
+static u32 GetTevTextureUsage(const PicaFSConfig& config) {
+    u32 usage = 0;
+    for (const auto& raw : config.state.tev_stages) {
+        const auto stage = static_cast<const TevStageConfig>(raw);
+        if (IsPassThroughTevStage(stage)) {
+            continue;
+        }
+        for (const auto source : {stage.color_source1.Value(), stage.color_source2.Value(),
+                                  stage.color_source3.Value(), stage.alpha_source1.Value(),
+                                  stage.alpha_source2.Value(), stage.alpha_source3.Value()}) {
+            if (source >= TevStageConfig::Source::Texture0 &&
+                source <= TevStageConfig::Source::Texture3) {
+                usage |= 1 << (static_cast<u32>(source) -
+                               static_cast<u32>(TevStageConfig::Source::Texture0));
+            }
+        }
+    }
+    return usage;
+}
+
+/// Writes the colors sampled from the texture units used by the TEV stages
+static void AppendTextureColors(std::string& out, const PicaFSConfig& config) {
+    const u32 usage = GetTevTextureUsage(config);
+    for (unsigned unit = 0; unit < 4; ++unit) {
+        if (usage & (1 << unit)) {
+            out += "vec4 texcolor";
+            out += static_cast<char>('0' + unit);
+            out += " = ";
+            out += SampleTexture(config, unit);
+            out += ";\n";
+        }
+    }
+}
+
+/// Generates the code of a TEV stage that isn't a pass-through. The code only depends on the raw
+/// stage configuration: it reads the textures from the texcolor variables and the constant color
+/// through the tev_stage constant declared by the caller.
+static std::string GenerateTevStage(const TevStageConfig& stage) {
+    std::string out;
+    out.reserve(1024);
+
+    out += "vec3 color_results[3] = vec3[3](";
+    AppendColorModifier(out, stage.color_modifier1, stage.color_source1);
+    out += ", ";
+    AppendColorModifier(out, stage.color_modifier2, stage.color_source2);
+    out += ", ";
+    AppendColorModifier(out, stage.color_modifier3, stage.color_source3);
+    out += ");\n";
+
+    // Round the output of each TEV stage to maintain the PICA's 8 bits of precision
+    out += "vec3 color_output = byteround(";
+    AppendColorCombiner(out, stage.color_op);
+    out += ");\n";
+
+    if (stage.color_op == TevStageConfig::Operation::Dot3_RGBA) {
+        // result of Dot3_RGBA operation is also placed to the alpha component
+        out += "float alpha_output = color_output[0];\n";
+    } else {
+        out += "float alpha_results[3] = float[3](";
+        AppendAlphaModifier(out, stage.alpha_modifier1, stage.alpha_source1);
+        out += ", ";
+        AppendAlphaModifier(out, stage.alpha_modifier2, stage.alpha_source2);
+        out += ", ";
+        AppendAlphaModifier(out, stage.alpha_modifier3, stage.alpha_source3);
+        out += ");\n";
+
+        out += "float alpha_output = byteround(";
+        AppendAlphaCombiner(out, stage.alpha_op);
+        out += ");\n";
+    }
+
+    out += fmt::format("last_tex_env_out = vec4("
+                       "clamp(color_output * {}.0, vec3(0.0), vec3(1.0)), "
+                       "clamp(alpha_output * {}.0, 0.0, 1.0));\n",
+                       stage.GetColorMultiplier(), stage.GetAlphaMultiplier());
+    return out;
+}
+
+/// Code of the TEV stages generated so far. Games only use a few hundred distinct stages, so most
+/// new fragment configurations are built from stages that were already seen.
+class TevStageCache {
+public:
+    void Append(std::string& out, const TevStageConfigRaw& raw) {
+        std::scoped_lock lock{mutex};
+        auto iter = stages.find(raw);
+        if (iter == stages.end()) {
+            if (stages.size() >= MaxStages) {
+                stages.clear();
+            }
+            const auto stage = static_cast<const TevStageConfig>(raw);
+            iter = stages.emplace(raw, GenerateTevStage(stage)).first;
+        }
+        out += iter->second;
+    }
+
+private:
+    static constexpr std::size_t MaxStages = 4096;
+
+    struct Hash {
+        std::size_t operator()(const TevStageConfigRaw& raw) const noexcept {
+            return static_cast<std::size_t>(Common::ComputeHash64(&raw, sizeof(raw)));
+        }
+    };
+
+    std::mutex mutex;
+    std::unordered_map<TevStageConfigRaw, std::string, Hash> stages;
+};
+
+static TevStageCache tev_stage_cache;
+
 /// Writes the if-statement condition used to evaluate alpha testing
 static void AppendAlphaTestCondition(std::string& out, FramebufferRegs::CompareFunc func) {
     using CompareFunc = FramebufferRegs::CompareFunc;
@@ -570,51 +597,13 @@ static void AppendAlphaTestCondition(std::string& out, FramebufferRegs::CompareF
 
 /// Writes the code to emulate the specified TEV stage
 static void WriteTevStage(std::string& out, const PicaFSConfig& config, unsigned index) {
-    const auto stage =
-        static_cast<const TexturingRegs::TevStageConfig>(config.state.tev_stages[index]);
-    if (!IsPassThroughTevStage(stage)) {
-        const std::string index_name = std::to_string(index);
-
-        out += fmt::format("vec3 color_results_{}_1 = ", index_name);
-        AppendColorModifier(out, config, stage.color_modifier1, stage.color_source1, index_name);
-        out += fmt::format(";\nvec3 color_results_{}_2 = ", index_name);
-        AppendColorModifier(out, config, stage.color_modifier2, stage.color_source2, index_name);
-        out += fmt::format(";\nvec3 color_results_{}_3 = ", index_name);
-        AppendColorModifier(out, config, stage.color_modifier3, stage.color_source3, index_name);
-        out += fmt::format(";\nvec3 color_results_{}[3] = vec3[3](color_results_{}_1, "
-                           "color_results_{}_2, color_results_{}_3);\n",
-                           index_name, index_name, index_name, index_name);
-
-        // Round the output of each TEV stage to maintain the PICA's 8 bits of precision
-        out += fmt::format("vec3 color_output_{} = byteround(", index_name);
-        AppendColorCombiner(out, stage.color_op, "color_results_" + index_name);
-        out += ");\n";
-
-        if (stage.color_op == TevStageConfig::Operation::Dot3_RGBA) {
-            // result of Dot3_RGBA operation is also placed to the alpha component
-            out += fmt::format("float alpha_output_{0} = color_output_{0}[0];\n", index_name);
-        } else {
-            out += fmt::format("float alpha_results_{}[3] = float[3](", index_name);
-            AppendAlphaModifier(out, config, stage.alpha_modifier1, stage.alpha_source1,
-                                index_name);
-            out += ", ";
-            AppendAlphaModifier(out, config, stage.alpha_modifier2, stage.alpha_source2,
-                                index_name);
-            out += ", ";
-            AppendAlphaModifier(out, config, stage.alpha_modifier3, stage.alpha_source3,
-                                index_name);
-            out += ");\n";
-
-            out += fmt::format("float alpha_output_{} = byteround(", index_name);
-            AppendAlphaCombiner(out, stage.alpha_op, "alpha_results_" + index_name);
-            out += ");\n";
-        }
-
-        out += fmt::format("last_tex_env_out = vec4("
-                           "clamp(color_output_{} * {}.0, vec3(0.0), vec3(1.0)), "
-                           "clamp(alpha_output_{} * {}.0, 0.0, 1.0));\n",
-                           index_name, stage.GetColorMultiplier(), index_name,
-                           stage.GetAlphaMultiplier());
+    const auto& raw = config.state.tev_stages[index];
+    if (!IsPassThroughTevStage(static_cast<const TevStageConfig>(raw))) {
+        out += "{\nconst int tev_stage = ";
+        out += static_cast<char>('0' + index);
+        out += ";\n";
+        tev_stage_cache.Append(out, raw);
+        out += "}\n";
     }
 
     out += "combiner_buffer = next_combiner_buffer;\n";
@@ -1191,11 +1180,8 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 }
 
-ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
-                                                       bool separable_shader) {
-    const auto& state = config.state;
-    std::string out;
-
+/// Writes the declarations and helper functions shared by the specialized and uber fragment shaders
+static void AppendFragmentShaderPrelude(std::string& out, bool separable_shader) {
     if (separable_shader && !GLES) {
         out += "#extension GL_ARB_separate_shader_objects : enable\n";
     }
@@ -1300,7 +1286,15 @@ float SampleShadow2D(ivec2 uv, uint z) {
         return 1.0;
     return CompareShadow(imageLoad(shadow_texture_px, uv).x, z);
 }
+)";
+}
 
+/**
+ * Writes the functions used to sample shadow textures
+ * @param shadow_projection statement that projects the 2D shadow texture coordinate, if needed
+ */
+static void AppendShadowTextureSamplers(std::string& out, std::string_view shadow_projection) {
+    out += R"(
 float mix2(vec4 s, vec2 a) {
     vec2 t = mix(s.xy, s.zw, a.yy);
     return mix(t.x, t.y, a.x);
@@ -1308,9 +1302,7 @@ float mix2(vec4 s, vec2 a) {
 
 vec4 shadowTexture(vec2 uv, float w) {
 )";
-    if (!config.state.shadow_texture_orthographic) {
-        out += "uv /= w;";
-    }
+    out += shadow_projection;
     out += "uint z = uint(max(0, int(min(abs(w), 1.0) * float(0xFFFFFF)) - shadow_texture_bias));";
     out += R"(
     vec2 coord = vec2(imageSize(shadow_texture_px)) * uv - vec2(0.5);
@@ -1408,6 +1400,30 @@ vec4 shadowTextureCube(vec2 uv, float w) {
     return vec4(mix2(s, f));
 }
 )";
+}
+
+/// Returns the prelude of the fragment shaders, which only depends on the context type
+static std::string_view GetFragmentShaderPrelude(bool separable_shader) {
+    static std::mutex mutex;
+    static std::array<std::string, 4> preludes;
+
+    std::scoped_lock lock{mutex};
+    std::string& prelude = preludes[(GLES ? 2 : 0) + (separable_shader ? 1 : 0)];
+    if (prelude.empty()) {
+        AppendFragmentShaderPrelude(prelude, separable_shader);
+    }
+    return prelude;
+}
+
+ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
+                                                       bool separable_shader) {
+    const auto& state = config.state;
+    const std::string_view prelude = GetFragmentShaderPrelude(separable_shader);
+    std::string out;
+    out.reserve(prelude.size() + 16 * 1024);
+
+    out += prelude;
+    AppendShadowTextureSamplers(out, state.shadow_texture_orthographic ? "" : "uv /= w;");
 
     if (config.state.proctex.enable)
         AppendProcTexSampler(out, config);
@@ -1456,6 +1472,7 @@ vec4 secondary_fragment_color = vec4(0.0);
            "vec4 next_combiner_buffer = tev_combiner_buffer_color;\n"
            "vec4 last_tex_env_out = vec4(0.0);\n";
 
+    AppendTextureColors(out, config);
     for (std::size_t index = 0; index < state.tev_stages.size(); ++index) {
         WriteTevStage(out, config, static_cast<u32>(index));
     }
@@ -1555,6 +1572,794 @@ do {
     return {std::move(out)};
 }
 
+void UberFSConfigData::SetFromConfig(const PicaFSConfig& config) {
+    const auto& state = config.state;
+    const auto& lighting = state.lighting;
+    const auto& proctex = state.proctex;
+
+    alpha_test_func = static_cast<int>(state.alpha_test_func);
+    scissor_test_mode = static_cast<int>(state.scissor_test_mode);
+    texture0_type = static_cast<int>(state.texture0_type);
+    texture2_use_coord1 = state.texture2_use_coord1;
+    depthmap_enable = static_cast<int>(state.depthmap_enable);
+    fog_mode = static_cast<int>(state.fog_mode);
+    fog_flip = state.fog_flip;
+    shadow_rendering = state.shadow_rendering;
+    shadow_texture_orthographic = state.shadow_texture_orthographic;
+    use_custom_normal_map = state.use_custom_normal_map;
+    combiner_buffer_input = state.combiner_buffer_input;
+
+    for (std::size_t i = 0; i < state.tev_stages.size(); i++) {
+        const auto& raw = state.tev_stages[i];
+        tev_stages[i] = {raw.sources_raw, raw.modifiers_raw, raw.ops_raw, raw.scales_raw};
+    }
+    // Only sample the textures that are actually combined, like the specialized shader does
+    texture_usage = static_cast<int>(GetTevTextureUsage(config));
+
+    const auto is_supported = [&lighting](LightingRegs::LightingSampler sampler) {
+        return LightingRegs::IsLightingSamplerSupported(lighting.config, sampler);
+    };
+    const bool spot_supported = is_supported(LightingRegs::LightingSampler::SpotlightAttenuation);
+
+    lighting_enable = lighting.enable;
+    lighting_src_num = static_cast<int>(lighting.src_num);
+    lighting_config = static_cast<int>(lighting.config);
+    bump_mode = static_cast<int>(lighting.bump_mode);
+    bump_selector = static_cast<int>(lighting.bump_selector);
+    bump_renorm = lighting.bump_renorm;
+    clamp_highlights = lighting.clamp_highlights;
+    enable_primary_alpha = lighting.enable_primary_alpha;
+    enable_secondary_alpha = lighting.enable_secondary_alpha;
+    enable_shadow = lighting.enable_shadow;
+    shadow_primary = lighting.shadow_primary;
+    shadow_secondary = lighting.shadow_secondary;
+    shadow_invert = lighting.shadow_invert;
+    shadow_alpha = lighting.shadow_alpha;
+    shadow_selector = static_cast<int>(lighting.shadow_selector);
+
+    for (std::size_t i = 0; i < lights.size(); i++) {
+        const auto& light = lighting.light[i];
+        lights[i] = {
+            .num = static_cast<int>(light.num),
+            .directional = light.directional,
+            .two_sided_diffuse = light.two_sided_diffuse,
+            .dist_atten_enable = light.dist_atten_enable,
+            .spot_atten_enable = light.spot_atten_enable && spot_supported,
+            .geometric_factor_0 = light.geometric_factor_0,
+            .geometric_factor_1 = light.geometric_factor_1,
+            .shadow_enable = light.shadow_enable,
+        };
+    }
+
+    const auto set_lut = [&](std::size_t index, const auto& lut, bool supported) {
+        luts[index] = {
+            .enable = lut.enable && supported,
+            .abs_input = lut.abs_input,
+            .type = static_cast<int>(lut.type),
+            .scale = lut.scale,
+        };
+    };
+    set_lut(0, lighting.lut_d0, is_supported(LightingRegs::LightingSampler::Distribution0));
+    set_lut(1, lighting.lut_d1, is_supported(LightingRegs::LightingSampler::Distribution1));
+    set_lut(2, lighting.lut_sp, spot_supported);
+    set_lut(3, lighting.lut_fr, is_supported(LightingRegs::LightingSampler::Fresnel));
+    set_lut(4, lighting.lut_rr, is_supported(LightingRegs::LightingSampler::ReflectRed));
+    set_lut(5, lighting.lut_rg, is_supported(LightingRegs::LightingSampler::ReflectGreen));
+    set_lut(6, lighting.lut_rb, is_supported(LightingRegs::LightingSampler::ReflectBlue));
+
+    proctex_enable = proctex.enable;
+    proctex_coord = static_cast<int>(proctex.coord);
+    proctex_u_clamp = static_cast<int>(proctex.u_clamp);
+    proctex_v_clamp = static_cast<int>(proctex.v_clamp);
+    proctex_color_combiner = static_cast<int>(proctex.color_combiner);
+    proctex_alpha_combiner = static_cast<int>(proctex.alpha_combiner);
+    proctex_separate_alpha = proctex.separate_alpha;
+    proctex_noise_enable = proctex.noise_enable;
+    proctex_u_shift = static_cast<int>(proctex.u_shift);
+    proctex_v_shift = static_cast<int>(proctex.v_shift);
+    proctex_lut_width = static_cast<int>(proctex.lut_width);
+    proctex_lut_filter = static_cast<int>(proctex.lut_filter);
+    proctex_lod_min = std::max(0.0f, static_cast<float>(proctex.lod_min));
+    proctex_lod_max = std::min(7.0f, static_cast<float>(proctex.lod_max));
+    proctex_lut_offsets = {static_cast<int>(proctex.lut_offset0),
+                           static_cast<int>(proctex.lut_offset1),
+                           static_cast<int>(proctex.lut_offset2),
+                           static_cast<int>(proctex.lut_offset3)};
+}
+
+// The uber shader switches on raw Pica register values, the names of the enum values are noted
+// next to each case.
+constexpr std::string_view UberFragmentShaderConfig = R"(
+struct UberLightConfig {
+    int num;
+    int directional;
+    int two_sided_diffuse;
+    int dist_atten_enable;
+    int spot_atten_enable;
+    int geometric_factor_0;
+    int geometric_factor_1;
+    int shadow_enable;
+};
+
+struct UberLutConfig {
+    int enable;
+    int abs_input;
+    int type;
+    float scale;
+};
+
+layout (std140) uniform fs_config {
+    int alpha_test_func;
+    int scissor_test_mode;
+    int texture0_type;
+    int texture2_use_coord1;
+    int texture_usage;
+    int depthmap_enable;
+    int fog_mode;
+    int fog_flip;
+    int shadow_rendering;
+    int shadow_texture_orthographic;
+    int use_custom_normal_map;
+    int combiner_buffer_input;
+    int lighting_enable;
+    int lighting_src_num;
+    int lighting_config;
+    int bump_mode;
+    int bump_selector;
+    int bump_renorm;
+    int clamp_highlights;
+    int enable_primary_alpha;
+    int enable_secondary_alpha;
+    int enable_shadow;
+    int shadow_primary;
+    int shadow_secondary;
+    int shadow_invert;
+    int shadow_alpha;
+    int shadow_selector;
+    int proctex_enable;
+    int proctex_coord;
+    int proctex_u_clamp;
+    int proctex_v_clamp;
+    int proctex_color_combiner;
+    int proctex_alpha_combiner;
+    int proctex_separate_alpha;
+    int proctex_noise_enable;
+    int proctex_u_shift;
+    int proctex_v_shift;
+    int proctex_lut_width;
+    int proctex_lut_filter;
+    float proctex_lod_min;
+    float proctex_lod_max;
+    ivec4 proctex_lut_offsets;
+    UberLightConfig lights[NUM_LIGHTS];
+    UberLutConfig luts[7];
+    uvec4 tev_stages[NUM_TEV_STAGES];
+} fs;
+
+const int LUT_D0 = 0;
+const int LUT_D1 = 1;
+const int LUT_SP = 2;
+const int LUT_FR = 3;
+const int LUT_RR = 4;
+const int LUT_RG = 5;
+const int LUT_RB = 6;
+)";
+
+constexpr std::string_view UberFragmentShaderBody = R"(
+float ProcTexLookupLUT(int offset, float coord) {
+    coord *= 128.0;
+    float index_i = clamp(floor(coord), 0.0, 127.0);
+    float index_f = coord - index_i;
+    vec2 entry = texelFetch(texture_buffer_lut_rg, int(index_i) + offset).rg;
+    return clamp(entry.r + entry.g * index_f, 0.0, 1.0);
+}
+
+int ProcTexNoiseRand1D(int v) {
+    const int table[] = int[](0,4,10,8,4,9,7,12,5,15,13,14,11,15,2,11);
+    return ((v % 9 + 2) * 3 & 0xF) ^ table[(v / 9) & 0xF];
+}
+
+float ProcTexNoiseRand2D(vec2 point) {
+    const int table[] = int[](10,2,15,8,0,7,4,5,5,13,2,6,13,9,3,14);
+    int u2 = ProcTexNoiseRand1D(int(point.x));
+    int v2 = ProcTexNoiseRand1D(int(point.y));
+    v2 += ((u2 & 3) == 1) ? 4 : 0;
+    v2 ^= (u2 & 1) * 6;
+    v2 += 10 + u2;
+    v2 &= 0xF;
+    v2 ^= table[u2];
+    return -1.0 + float(v2) * 2.0/ 15.0;
+}
+
+float ProcTexNoiseCoef(vec2 x) {
+    vec2 grid  = 9.0 * proctex_noise_f * abs(x + proctex_noise_p);
+    vec2 point = floor(grid);
+    vec2 frac  = grid - point;
+
+    float g0 = ProcTexNoiseRand2D(point) * (frac.x + frac.y);
+    float g1 = ProcTexNoiseRand2D(point + vec2(1.0, 0.0)) * (frac.x + frac.y - 1.0);
+    float g2 = ProcTexNoiseRand2D(point + vec2(0.0, 1.0)) * (frac.x + frac.y - 1.0);
+    float g3 = ProcTexNoiseRand2D(point + vec2(1.0, 1.0)) * (frac.x + frac.y - 2.0);
+
+    float x_noise = ProcTexLookupLUT(proctex_noise_lut_offset, frac.x);
+    float y_noise = ProcTexLookupLUT(proctex_noise_lut_offset, frac.y);
+    float x0 = mix(g0, g1, x_noise);
+    float x1 = mix(g2, g3, x_noise);
+    return mix(x0, x1, y_noise);
+}
+
+float ProcTexShiftOffset(float v, int mode, int clamp_mode) {
+    float offset = clamp_mode == 3 ? 1.0 : 0.5; // MirroredRepeat
+    switch (mode) {
+    case 1: // Odd
+        return offset * float((int(v) / 2) % 2);
+    case 2: // Even
+        return offset * float(((int(v) + 1) / 2) % 2);
+    }
+    return 0.0;
+}
+
+float ProcTexClamp(float v, int mode) {
+    switch (mode) {
+    case 0: // ToZero
+        return v > 1.0 ? 0.0 : v;
+    case 2: // SymmetricalRepeat
+        return fract(v);
+    case 3: // MirroredRepeat
+        return int(v) % 2 == 0 ? fract(v) : 1.0 - fract(v);
+    case 4: // Pulse
+        return v > 0.5 ? 1.0 : 0.0;
+    }
+    return min(v, 1.0); // ToEdge
+}
+
+float ProcTexCombineAndMap(int combiner, float u, float v, int offset) {
+    float combined;
+    switch (combiner) {
+    case 0: combined = u; break;
+    case 1: combined = u * u; break;
+    case 2: combined = v; break;
+    case 3: combined = v * v; break;
+    case 4: combined = (u + v) * 0.5; break;
+    case 5: combined = (u * u + v * v) * 0.5; break;
+    case 6: combined = min(sqrt(u * u + v * v), 1.0); break;
+    case 7: combined = min(u, v); break;
+    case 8: combined = max(u, v); break;
+    case 9: combined = min(((u + v) * 0.5 + sqrt(u * u + v * v)) * 0.5, 1.0); break;
+    default: combined = 0.0; break;
+    }
+    return ProcTexLookupLUT(offset, combined);
+}
+
+vec4 SampleProcTexColor(float lut_coord, int level) {
+    int lut_width = fs.proctex_lut_width >> level;
+    // Offsets for level 4-7 seem to be hardcoded
+    int lut_offsets[8] = int[](fs.proctex_lut_offsets.x, fs.proctex_lut_offsets.y,
+                               fs.proctex_lut_offsets.z, fs.proctex_lut_offsets.w,
+                               0xF0, 0xF8, 0xFC, 0xFE);
+    int lut_offset = lut_offsets[level];
+    // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
+    lut_coord *= float(lut_width - 1);
+
+    // Linear, LinearMipmapNearest and LinearMipmapLinear
+    if (fs.proctex_lut_filter == 1 || fs.proctex_lut_filter == 3 || fs.proctex_lut_filter == 5) {
+        int lut_index_i = int(lut_coord) + lut_offset;
+        float lut_index_f = fract(lut_coord);
+        return texelFetch(texture_buffer_lut_rgba, lut_index_i + proctex_lut_offset) +
+               lut_index_f *
+                   texelFetch(texture_buffer_lut_rgba, lut_index_i + proctex_diff_lut_offset);
+    }
+    lut_coord += float(lut_offset);
+    return texelFetch(texture_buffer_lut_rgba, int(round(lut_coord)) + proctex_lut_offset);
+}
+
+vec4 ProcTex() {
+    vec2 uv = abs(texcoord0);
+    if (fs.proctex_coord == 1) {
+        uv = abs(texcoord1);
+    } else if (fs.proctex_coord == 2) {
+        uv = abs(texcoord2);
+    }
+
+    vec2 duv = max(abs(dFdx(uv)), abs(dFdy(uv)));
+    float lod = log2(abs(float(fs.proctex_lut_width) * proctex_bias) * (duv.x + duv.y));
+    if (proctex_bias == 0.0) lod = 0.0;
+    lod = clamp(lod, fs.proctex_lod_min, fs.proctex_lod_max);
+
+    float u_shift = ProcTexShiftOffset(uv.y, fs.proctex_u_shift, fs.proctex_u_clamp);
+    float v_shift = ProcTexShiftOffset(uv.x, fs.proctex_v_shift, fs.proctex_v_clamp);
+    if (fs.proctex_noise_enable != 0) {
+        uv += proctex_noise_a * ProcTexNoiseCoef(uv);
+        uv = abs(uv);
+    }
+    float u = ProcTexClamp(uv.x + u_shift, fs.proctex_u_clamp);
+    float v = ProcTexClamp(uv.y + v_shift, fs.proctex_v_clamp);
+
+    float lut_coord = ProcTexCombineAndMap(fs.proctex_color_combiner, u, v,
+                                           proctex_color_map_offset);
+    vec4 final_color;
+    switch (fs.proctex_lut_filter) {
+    case 2: // NearestMipmapNearest
+    case 3: // LinearMipmapNearest
+        final_color = SampleProcTexColor(lut_coord, int(round(lod)));
+        break;
+    case 4: // NearestMipmapLinear
+    case 5: { // LinearMipmapLinear
+        int lod_i = int(lod);
+        float lod_f = fract(lod);
+        final_color = mix(SampleProcTexColor(lut_coord, lod_i),
+                          SampleProcTexColor(lut_coord, lod_i + 1), lod_f);
+        break;
+    }
+    default:
+        final_color = SampleProcTexColor(lut_coord, 0);
+        break;
+    }
+
+    if (fs.proctex_separate_alpha != 0) {
+        // In separate alpha mode, the alpha channel skips the color LUT look up stage
+        final_color.a = ProcTexCombineAndMap(fs.proctex_alpha_combiner, u, v,
+                                             proctex_alpha_map_offset);
+    }
+    return final_color;
+}
+
+vec4 SampleTexture(int unit) {
+    switch (unit) {
+    case 0:
+        // Only unit 0 respects the texturing type
+        switch (fs.texture0_type) {
+        case 0: // Texture2D
+            return textureLod(tex0, texcoord0,
+                              getLod(texcoord0 * vec2(textureSize(tex0, 0))) + tex_lod_bias[0]);
+        case 1: // TextureCube
+            return texture(tex_cube, vec3(texcoord0, texcoord0_w));
+        case 2: // Shadow2D
+            return shadowTexture(texcoord0, texcoord0_w);
+        case 3: // Projection2D
+            return textureProj(tex0, vec3(texcoord0, texcoord0_w));
+        case 4: // ShadowCube
+            return shadowTextureCube(texcoord0, texcoord0_w);
+        }
+        return vec4(0.0);
+    case 1:
+        return textureLod(tex1, texcoord1,
+                          getLod(texcoord1 * vec2(textureSize(tex1, 0))) + tex_lod_bias[1]);
+    case 2: {
+        vec2 coord = fs.texture2_use_coord1 != 0 ? texcoord1 : texcoord2;
+        return textureLod(tex2, coord,
+                          getLod(coord * vec2(textureSize(tex2, 0))) + tex_lod_bias[2]);
+    }
+    case 3:
+        return fs.proctex_enable != 0 ? ProcTex() : vec4(0.0);
+    case 4:
+        return texture(tex_normal, texcoord0);
+    }
+    return vec4(0.0);
+}
+
+vec4 rounded_primary_color;
+vec4 primary_fragment_color = vec4(0.0);
+vec4 secondary_fragment_color = vec4(0.0);
+vec4 texture_color[4];
+vec4 combiner_buffer = vec4(0.0);
+vec4 next_combiner_buffer;
+vec4 last_tex_env_out = vec4(0.0);
+
+struct LightingLutInputs {
+    vec3 normal;
+    vec3 tangent;
+    vec3 light_vector;
+    vec3 half_vector;
+    vec3 spot_dir;
+    bool two_sided;
+};
+
+float LightingLutInput(int type, LightingLutInputs inputs) {
+    switch (type) {
+    case 0: // NH
+        return dot(inputs.normal, normalize(inputs.half_vector));
+    case 1: // VH
+        return dot(normalize(view), normalize(inputs.half_vector));
+    case 2: // NV
+        return dot(inputs.normal, normalize(view));
+    case 3: // LN
+        return dot(inputs.light_vector, inputs.normal);
+    case 4: // SP
+        return dot(inputs.light_vector, inputs.spot_dir);
+    case 5: // CP, only available with configuration 7
+        if (fs.lighting_config == 8) {
+            vec3 half_angle = normalize(inputs.half_vector);
+            vec3 half_angle_proj = half_angle - inputs.normal * dot(inputs.normal, half_angle);
+            return dot(half_angle_proj, inputs.tangent);
+        }
+        return 0.0;
+    }
+    return 0.0;
+}
+
+float LightingLutValue(int lut, int sampler, LightingLutInputs inputs) {
+    float pos = LightingLutInput(fs.luts[lut].type, inputs);
+    float value;
+    if (fs.luts[lut].abs_input != 0) {
+        value = LookupLightingLUTUnsigned(sampler, inputs.two_sided ? abs(pos) : max(pos, 0.0));
+    } else {
+        value = LookupLightingLUTSigned(sampler, pos);
+    }
+    return fs.luts[lut].scale * value;
+}
+
+void WriteLighting() {
+    vec4 diffuse_sum = vec4(0.0, 0.0, 0.0, 1.0);
+    vec4 specular_sum = vec4(0.0, 0.0, 0.0, 1.0);
+    float clamp_highlights = 1.0;
+    float geo_factor = 1.0;
+
+    // Compute fragment normals and tangents
+    vec3 surface_normal = vec3(0.0, 0.0, 1.0);
+    vec3 surface_tangent = vec3(1.0, 0.0, 0.0);
+    if (fs.use_custom_normal_map != 0) {
+        surface_normal = 2.0 * SampleTexture(4).rgb - 1.0;
+    } else if (fs.bump_mode == 1) { // NormalMap
+        surface_normal = 2.0 * SampleTexture(fs.bump_selector).rgb - 1.0;
+        if (fs.bump_renorm != 0) {
+            float xy = surface_normal.x * surface_normal.x + surface_normal.y * surface_normal.y;
+            surface_normal.z = sqrt(max(1.0 - xy, 0.0));
+        }
+    } else if (fs.bump_mode == 2) { // TangentMap
+        surface_tangent = 2.0 * SampleTexture(fs.bump_selector).rgb - 1.0;
+    }
+
+    vec4 normalized_normquat = normalize(normquat);
+    vec3 normal = quaternion_rotate(normalized_normquat, surface_normal);
+    vec3 tangent = quaternion_rotate(normalized_normquat, surface_tangent);
+
+    vec4 shadow = vec4(1.0);
+    if (fs.enable_shadow != 0) {
+        shadow = SampleTexture(fs.shadow_selector);
+        if (fs.shadow_invert != 0) {
+            shadow = vec4(1.0) - shadow;
+        }
+    }
+
+    for (int i = 0; i < fs.lighting_src_num; ++i) {
+        UberLightConfig light = fs.lights[i];
+        vec3 light_vector = light_src[light.num].position;
+        if (light.directional == 0) {
+            light_vector += view;
+        }
+        float light_distance = length(light_vector);
+        light_vector = normalize(light_vector);
+        vec3 spot_dir = light_src[light.num].spot_direction;
+        vec3 half_vector = normalize(view) + light_vector;
+
+        float dot_product = light.two_sided_diffuse != 0 ? abs(dot(light_vector, normal))
+                                                          : max(dot(light_vector, normal), 0.0);
+        if (fs.clamp_highlights != 0) {
+            clamp_highlights = sign(dot_product);
+        }
+
+        // The specialized shader picks the LUT input mode by the light number rather than its slot
+        LightingLutInputs inputs = LightingLutInputs(normal, tangent, light_vector, half_vector,
+                                                     spot_dir,
+                                                     fs.lights[light.num].two_sided_diffuse != 0);
+
+        float spot_atten = 1.0;
+        if (light.spot_atten_enable != 0) {
+            spot_atten = LightingLutValue(LUT_SP, 8 + light.num, inputs);
+        }
+
+        float dist_atten = 1.0;
+        if (light.dist_atten_enable != 0) {
+            float index = clamp(light_src[light.num].dist_atten_scale * light_distance +
+                                light_src[light.num].dist_atten_bias, 0.0, 1.0);
+            dist_atten = LookupLightingLUTUnsigned(16 + light.num, index);
+        }
+
+        if (light.geometric_factor_0 != 0 || light.geometric_factor_1 != 0) {
+            geo_factor = dot(half_vector, half_vector);
+            geo_factor = geo_factor == 0.0 ? 0.0 : min(dot_product / geo_factor, 1.0);
+        }
+
+        float d0_lut_value = fs.luts[LUT_D0].enable != 0
+            ? LightingLutValue(LUT_D0, 0, inputs) : 1.0;
+        vec3 specular_0 = d0_lut_value * light_src[light.num].specular_0;
+        if (light.geometric_factor_0 != 0) {
+            specular_0 *= geo_factor;
+        }
+
+        vec3 refl_value;
+        refl_value.r = fs.luts[LUT_RR].enable != 0 ? LightingLutValue(LUT_RR, 6, inputs) : 1.0;
+        refl_value.g = fs.luts[LUT_RG].enable != 0
+            ? LightingLutValue(LUT_RG, 5, inputs) : refl_value.r;
+        refl_value.b = fs.luts[LUT_RB].enable != 0
+            ? LightingLutValue(LUT_RB, 4, inputs) : refl_value.r;
+
+        float d1_lut_value = fs.luts[LUT_D1].enable != 0
+            ? LightingLutValue(LUT_D1, 1, inputs) : 1.0;
+        vec3 specular_1 = d1_lut_value * refl_value * light_src[light.num].specular_1;
+        if (light.geometric_factor_1 != 0) {
+            specular_1 *= geo_factor;
+        }
+
+        // Only the last entry in the light slots applies the Fresnel factor
+        if (i == fs.lighting_src_num - 1 && fs.luts[LUT_FR].enable != 0) {
+            float fresnel = LightingLutValue(LUT_FR, 3, inputs);
+            if (fs.enable_primary_alpha != 0) {
+                diffuse_sum.a = fresnel;
+            }
+            if (fs.enable_secondary_alpha != 0) {
+                specular_sum.a = fresnel;
+            }
+        }
+
+        vec3 shadow_primary = vec3(1.0);
+        vec3 shadow_secondary = vec3(1.0);
+        if (light.shadow_enable != 0) {
+            if (fs.shadow_primary != 0) {
+                shadow_primary = shadow.rgb;
+            }
+            if (fs.shadow_secondary != 0) {
+                shadow_secondary = shadow.rgb;
+            }
+        }
+
+        diffuse_sum.rgb += ((light_src[light.num].diffuse * dot_product) +
+                            light_src[light.num].ambient) *
+                           dist_atten * spot_atten * shadow_primary;
+        specular_sum.rgb += (specular_0 + specular_1) * clamp_highlights * dist_atten *
+                            spot_atten * shadow_secondary;
+    }
+
+    // Apply shadow attenuation to alpha components if enabled
+    if (fs.shadow_alpha != 0) {
+        if (fs.enable_primary_alpha != 0) {
+            diffuse_sum.a *= shadow.a;
+        }
+        if (fs.enable_secondary_alpha != 0) {
+            specular_sum.a *= shadow.a;
+        }
+    }
+
+    diffuse_sum.rgb += lighting_global_ambient;
+    primary_fragment_color = clamp(diffuse_sum, vec4(0.0), vec4(1.0));
+    secondary_fragment_color = clamp(specular_sum, vec4(0.0), vec4(1.0));
+}
+
+int Field(uint value, int offset, int bits) {
+    return int((value >> uint(offset)) & ((1u << uint(bits)) - 1u));
+}
+
+vec4 GetSource(int source, int stage) {
+    switch (source) {
+    case 0: // PrimaryColor
+        return rounded_primary_color;
+    case 1: // PrimaryFragmentColor
+        return primary_fragment_color;
+    case 2: // SecondaryFragmentColor
+        return secondary_fragment_color;
+    case 3: // Texture0
+    case 4: // Texture1
+    case 5: // Texture2
+    case 6: // Texture3
+        return texture_color[source - 3];
+    case 13: // PreviousBuffer
+        return combiner_buffer;
+    case 14: // Constant
+        return const_color[stage];
+    case 15: // Previous
+        return last_tex_env_out;
+    }
+    return vec4(0.0);
+}
+
+vec3 ColorModifier(int modifier, vec4 value) {
+    vec3 result;
+    switch (modifier & ~1) {
+    case 0: result = value.rgb; break; // SourceColor
+    case 2: result = value.aaa; break; // SourceAlpha
+    case 4: result = value.rrr; break; // SourceRed
+    case 8: result = value.ggg; break; // SourceGreen
+    case 12: result = value.bbb; break; // SourceBlue
+    default: return vec3(0.0);
+    }
+    // Odd modifiers are the OneMinus variants
+    return (modifier & 1) != 0 ? vec3(1.0) - result : result;
+}
+
+float AlphaModifier(int modifier, vec4 value) {
+    float result;
+    switch (modifier >> 1) {
+    case 0: result = value.a; break; // SourceAlpha
+    case 1: result = value.r; break; // SourceRed
+    case 2: result = value.g; break; // SourceGreen
+    default: result = value.b; break; // SourceBlue
+    }
+    return (modifier & 1) != 0 ? 1.0 - result : result;
+}
+
+vec3 ColorCombiner(int operation, vec3 s[3]) {
+    vec3 result;
+    switch (operation) {
+    case 0: result = s[0]; break; // Replace
+    case 1: result = s[0] * s[1]; break; // Modulate
+    case 2: result = s[0] + s[1]; break; // Add
+    case 3: result = s[0] + s[1] - vec3(0.5); break; // AddSigned
+    case 4: result = s[0] * s[2] + s[1] * (vec3(1.0) - s[2]); break; // Lerp
+    case 5: result = s[0] - s[1]; break; // Subtract
+    case 6: // Dot3_RGB
+    case 7: result = vec3(dot(s[0] - vec3(0.5), s[1] - vec3(0.5)) * 4.0); break; // Dot3_RGBA
+    case 8: result = s[0] * s[1] + s[2]; break; // MultiplyThenAdd
+    case 9: result = min(s[0] + s[1], vec3(1.0)) * s[2]; break; // AddThenMultiply
+    default: result = vec3(0.0); break;
+    }
+    return clamp(result, vec3(0.0), vec3(1.0));
+}
+
+float AlphaCombiner(int operation, float s[3]) {
+    float result;
+    switch (operation) {
+    case 0: result = s[0]; break; // Replace
+    case 1: result = s[0] * s[1]; break; // Modulate
+    case 2: result = s[0] + s[1]; break; // Add
+    case 3: result = s[0] + s[1] - 0.5; break; // AddSigned
+    case 4: result = s[0] * s[2] + s[1] * (1.0 - s[2]); break; // Lerp
+    case 5: result = s[0] - s[1]; break; // Subtract
+    case 8: result = s[0] * s[1] + s[2]; break; // MultiplyThenAdd
+    case 9: result = min(s[0] + s[1], 1.0) * s[2]; break; // AddThenMultiply
+    default: result = 0.0; break;
+    }
+    return clamp(result, 0.0, 1.0);
+}
+
+float TevMultiplier(int scale) {
+    return scale < 3 ? float(1 << scale) : 1.0;
+}
+
+void WriteTevStage(int index) {
+    uvec4 stage = fs.tev_stages[index];
+    vec3 color_results[3];
+    float alpha_results[3];
+    for (int i = 0; i < 3; ++i) {
+        color_results[i] = ColorModifier(Field(stage.y, 4 * i, 4),
+                                         GetSource(Field(stage.x, 4 * i, 4), index));
+        alpha_results[i] = AlphaModifier(Field(stage.y, 12 + 4 * i, 3),
+                                         GetSource(Field(stage.x, 16 + 4 * i, 4), index));
+    }
+
+    // Round the output of each TEV stage to maintain the PICA's 8 bits of precision
+    int color_op = Field(stage.z, 0, 4);
+    vec3 color_output = byteround(ColorCombiner(color_op, color_results));
+    float alpha_output;
+    if (color_op == 7) {
+        // Result of Dot3_RGBA operation is also placed to the alpha component
+        alpha_output = color_output[0];
+    } else {
+        alpha_output = byteround(AlphaCombiner(Field(stage.z, 16, 4), alpha_results));
+    }
+
+    last_tex_env_out = vec4(
+        clamp(color_output * TevMultiplier(Field(stage.w, 0, 2)), vec3(0.0), vec3(1.0)),
+        clamp(alpha_output * TevMultiplier(Field(stage.w, 16, 2)), 0.0, 1.0));
+
+    combiner_buffer = next_combiner_buffer;
+    if (index < 4) {
+        if ((fs.combiner_buffer_input & (1 << index)) != 0) {
+            next_combiner_buffer.rgb = last_tex_env_out.rgb;
+        }
+        if ((fs.combiner_buffer_input & (16 << index)) != 0) {
+            next_combiner_buffer.a = last_tex_env_out.a;
+        }
+    }
+}
+
+bool AlphaTestPasses(int alpha) {
+    switch (fs.alpha_test_func) {
+    case 0: return false; // Never
+    case 2: return alpha == alphatest_ref; // Equal
+    case 3: return alpha != alphatest_ref; // NotEqual
+    case 4: return alpha < alphatest_ref; // LessThan
+    case 5: return alpha <= alphatest_ref; // LessThanOrEqual
+    case 6: return alpha > alphatest_ref; // GreaterThan
+    case 7: return alpha >= alphatest_ref; // GreaterThanOrEqual
+    }
+    return true; // Always
+}
+
+void main() {
+    // Do not do any sort of processing if it's obvious we're not going to pass the alpha test
+    if (fs.alpha_test_func == 0) {
+        discard;
+    }
+
+    if (fs.scissor_test_mode != 0) {
+        bool inside = gl_FragCoord.x >= float(scissor_x1) && gl_FragCoord.y >= float(scissor_y1) &&
+                      gl_FragCoord.x < float(scissor_x2) && gl_FragCoord.y < float(scissor_y2);
+        // Include mode keeps only the pixels inside the scissor box, Exclude the ones outside
+        if (inside != (fs.scissor_test_mode == 3)) {
+            discard;
+        }
+    }
+
+    float z_over_w = 2.0 * gl_FragCoord.z - 1.0;
+    float depth = z_over_w * depth_scale + depth_offset;
+    if (fs.depthmap_enable == 0) { // WBuffering
+        depth /= gl_FragCoord.w;
+    }
+
+    rounded_primary_color = byteround(primary_color);
+    if (fs.lighting_enable != 0) {
+        WriteLighting();
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        texture_color[i] = (fs.texture_usage & (1 << i)) != 0 ? SampleTexture(i) : vec4(0.0);
+    }
+
+    next_combiner_buffer = tev_combiner_buffer_color;
+    for (int i = 0; i < NUM_TEV_STAGES; ++i) {
+        WriteTevStage(i);
+    }
+
+    if (!AlphaTestPasses(int(last_tex_env_out.a * 255.0))) {
+        discard;
+    }
+
+    if (fs.fog_mode == 5) { // Fog
+        float fog_index = fs.fog_flip != 0 ? (1.0 - depth) * 128.0 : depth * 128.0;
+        float fog_i = clamp(floor(fog_index), 0.0, 127.0);
+        float fog_f = fog_index - fog_i;
+        vec2 fog_lut_entry = texelFetch(texture_buffer_lut_lf, int(fog_i) + fog_lut_offset).rg;
+        float fog_factor = clamp(fog_lut_entry.r + fog_lut_entry.g * fog_f, 0.0, 1.0);
+        last_tex_env_out.rgb = mix(fog_color.rgb, last_tex_env_out.rgb, fog_factor);
+    } else if (fs.fog_mode == 7) { // Gas, unimplemented
+        discard;
+    }
+
+    if (fs.shadow_rendering != 0) {
+        uint d = uint(clamp(depth, 0.0, 1.0) * float(0xFFFFFF));
+        uint s = uint(last_tex_env_out.g * float(0xFF));
+        ivec2 image_coord = ivec2(gl_FragCoord.xy);
+
+        uint old = imageLoad(shadow_buffer, image_coord).x;
+        uint new;
+        uint old2;
+        do {
+            old2 = old;
+
+            uvec2 ref = DecodeShadow(old);
+            if (d < ref.x) {
+                if (s == 0u) {
+                    ref.x = d;
+                } else {
+                    s = uint(float(s) / (shadow_bias_constant + shadow_bias_linear * float(d) / float(ref.x)));
+                    ref.y = min(s, ref.y);
+                }
+            }
+            new = EncodeShadow(ref);
+
+        } while ((old = imageAtomicCompSwap(shadow_buffer, image_coord, old, new)) != old2);
+    } else {
+        gl_FragDepth = depth;
+        // Round the final fragment color to maintain the PICA's 8 bits of precision
+        color = byteround(last_tex_env_out);
+    }
+}
+)";
+
+ShaderDecompiler::ProgramResult GenerateUberFragmentShader(bool separable_shader) {
+    std::string out;
+
+    out += GetFragmentShaderPrelude(separable_shader);
+    out += UberFragmentShaderConfig;
+    AppendShadowTextureSamplers(out, "if (fs.shadow_texture_orthographic == 0) uv /= w;");
+    out += UberFragmentShaderBody;
+
+    // Logic operations are only emulated in the shader on GLES, which never uses the uber shader
+    // as it has no separable programs.
+    return {std::move(out)};
+}
+
 ShaderDecompiler::ProgramResult GenerateTrivialVertexShader(bool separable_shader) {
     std::string out;
     if (separable_shader && !GLES) {
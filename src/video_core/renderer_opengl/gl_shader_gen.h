@@ -6,6 +6,7 @@
 #include <functional>
 #include <optional>
 #include "common/hash.h"
+#include "common/vector_math.h"
 #include "video_core/regs.h"
 #include "video_core/shader/shader.h"
 
@@ -43,6 +44,8 @@ struct TevStageConfigRaw {
         stage.scales_raw = scales_raw;
         return stage;
     }
+
+    bool operator==(const TevStageConfigRaw&) const noexcept = default;
 };
 
 struct PicaFSConfigState {
@@ -142,6 +145,83 @@ struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
     }
 };
 
+/**
+ * Uniform block read by the uber fragment shader in place of the constants a specialized fragment
+ * shader has baked in. Most fields mirror PicaFSConfigState, LUT and spotlight enables are already
+ * masked by whether the lighting configuration supports them.
+ * NOTE: the same layout rules as Pica::Shader::UniformData apply here.
+ */
+struct UberFSConfigData {
+    void SetFromConfig(const PicaFSConfig& config);
+
+    struct alignas(16) LightConfig {
+        int num;
+        int directional;
+        int two_sided_diffuse;
+        int dist_atten_enable;
+        int spot_atten_enable;
+        int geometric_factor_0;
+        int geometric_factor_1;
+        int shadow_enable;
+    };
+
+    struct alignas(16) LutConfig {
+        int enable;
+        int abs_input;
+        int type;
+        float scale;
+    };
+
+    int alpha_test_func;
+    int scissor_test_mode;
+    int texture0_type;
+    int texture2_use_coord1;
+    int texture_usage; ///< Bitmask of the texture units read by any TEV stage
+    int depthmap_enable;
+    int fog_mode;
+    int fog_flip;
+    int shadow_rendering;
+    int shadow_texture_orthographic;
+    int use_custom_normal_map;
+    int combiner_buffer_input;
+    int lighting_enable;
+    int lighting_src_num;
+    int lighting_config;
+    int bump_mode;
+    int bump_selector;
+    int bump_renorm;
+    int clamp_highlights;
+    int enable_primary_alpha;
+    int enable_secondary_alpha;
+    int enable_shadow;
+    int shadow_primary;
+    int shadow_secondary;
+    int shadow_invert;
+    int shadow_alpha;
+    int shadow_selector;
+    int proctex_enable;
+    int proctex_coord;
+    int proctex_u_clamp;
+    int proctex_v_clamp;
+    int proctex_color_combiner;
+    int proctex_alpha_combiner;
+    int proctex_separate_alpha;
+    int proctex_noise_enable;
+    int proctex_u_shift;
+    int proctex_v_shift;
+    int proctex_lut_width;
+    int proctex_lut_filter;
+    float proctex_lod_min;
+    float proctex_lod_max;
+    alignas(16) Common::Vec4i proctex_lut_offsets;
+    std::array<LightConfig, 8> lights;
+    std::array<LutConfig, 7> luts; ///< D0, D1, SP, FR, RR, RG, RB
+    alignas(16) std::array<Common::Vec4u, 6> tev_stages;
+};
+
+static_assert(sizeof(UberFSConfigData) == 0x290,
+              "The size of the UberFSConfigData does not match the structure in the shader");
+
 /**
  * This struct contains common information to identify a GL vertex/geometry shader generated from
  * PICA vertex/geometry shader.
@@ -230,6 +310,15 @@ ShaderDecompiler::ProgramResult GenerateFixedGeometryShader(const PicaFixedGSCon
 ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
                                                        bool separable_shader);
 
+/**
+ * Generates the GLSL uber fragment shader, which emulates any Pica fragment configuration by
+ * reading it from the UberFSConfigData uniform block at runtime. It is much slower than a
+ * specialized shader, and is only used while the specialized one is compiled in the background.
+ * @param separable_shader generates shader that can be used for separate shader object
+ * @returns String of the shader source code
+ */
+ShaderDecompiler::ProgramResult GenerateUberFragmentShader(bool separable_shader);
+
 } // namespace OpenGL
 
 namespace std {
@@ -3,11 +3,17 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <set>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include "common/scope_exit.h"
+#include "common/settings.h"
+#include "common/thread_worker.h"
+#include "common/threadsafe_queue.h"
+#include "common/unique_function.h"
 #include "core/frontend/emu_window.h"
 #include "video_core/renderer_opengl/gl_driver.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
@@ -107,6 +113,8 @@ static void SetShaderUniformBlockBindings(GLuint shader) {
                                  sizeof(Pica::Shader::UniformData));
     SetShaderUniformBlockBinding(shader, "vs_config", Pica::Shader::UniformBindings::VS,
                                  sizeof(Pica::Shader::VSUniformData));
+    SetShaderUniformBlockBinding(shader, "fs_config", Pica::Shader::UniformBindings::FSConfig,
+                                 sizeof(UberFSConfigData));
 }
 
 static void SetShaderSamplerBinding(GLuint shader, const char* name,
@@ -232,6 +240,12 @@ public:
         return {cached_shader.GetHandle(), std::move(result)};
     }
 
+    /// Returns the handle of an already built shader, or 0 if there is none for the config.
+    GLuint Find(const KeyConfigType& config) const {
+        const auto iter = shaders.find(config);
+        return iter != shaders.end() ? iter->second.GetHandle() : 0;
+    }
+
     void Inject(const KeyConfigType& key, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -289,6 +303,20 @@ public:
         return {map_it->second->GetHandle(), std::nullopt};
     }
 
+    /// Returns the handle of an already built shader, 0 if the config is known to be unsupported,
+    /// or std::nullopt if it hasn't been seen yet.
+    std::optional<GLuint> Find(const KeyConfigType& key) const {
+        const auto map_it = shader_map.find(key);
+        if (map_it == shader_map.end()) {
+            return std::nullopt;
+        }
+        return map_it->second ? map_it->second->GetHandle() : 0;
+    }
+
+    void MarkUnsupported(const KeyConfigType& key) {
+        shader_map.insert_or_assign(key, nullptr);
+    }
+
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -319,12 +347,127 @@ using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FR
 
 class ShaderProgramManager::Impl {
 public:
-    explicit Impl(bool separable)
+    explicit Impl(Frontend::EmuWindow& emu_window, bool separable, bool async_compile)
         : separable(separable), programmable_vertex_shaders(separable),
           trivial_vertex_shader(separable), fixed_geometry_shaders(separable),
-          fragment_shaders(separable), disk_cache(separable) {
+          fragment_shaders(separable), uber_fragment_shader(separable), disk_cache(separable) {
         if (separable)
             pipeline.Create();
+        if (async_compile) {
+            uber_fragment_shader.Create(GenerateUberFragmentShader(separable).code.c_str(),
+                                        GL_FRAGMENT_SHADER);
+            CreateCompileWorkers(emu_window);
+        }
+    }
+
+    void CreateCompileWorkers(Frontend::EmuWindow& emu_window) {
+        // Leave most of the cores to the emulated CPU and the rest of the host
+        const std::size_t num_workers =
+            std::clamp<std::size_t>(std::thread::hardware_concurrency() / 4, 1, 4);
+
+        emu_window.SaveContext();
+        compile_contexts.resize(num_workers);
+        for (auto& context : compile_contexts) {
+            // On some platforms the shared context has to be created from the GUI thread
+            context = emu_window.CreateSharedContext();
+            // Release the context, so it can be immediately used by the worker thread
+            context->DoneCurrent();
+        }
+        emu_window.RestoreContext();
+
+        compile_workers =
+            std::make_unique<Common::StatefulThreadWorker<Frontend::GraphicsContext::Scoped>>(
+                num_workers, "GLShaderCompiler",
+                [this](std::size_t index) { return compile_contexts[index]->Acquire(); });
+    }
+
+    /// Links a separable program from GLSL on a compile worker and waits for the driver to finish
+    /// it, as it is going to be used from the render context.
+    OGLProgram BuildProgram(const std::string& code, GLenum type) {
+        const auto start = std::chrono::steady_clock::now();
+        OGLShader shader;
+        shader.Create(code, type);
+        OGLProgram program;
+        program.Create(true, {shader.handle});
+        glFinish();
+
+        async_compile_time += static_cast<u64>((std::chrono::steady_clock::now() - start).count());
+        ++async_programs_built;
+        return program;
+    }
+
+    /// Builds the fragment shader for the config on a compile worker unless already queued.
+    void QueueFragmentShader(const PicaFSConfig& config, ShaderDiskCacheRaw raw) {
+        if (!pending_fragment_shaders.insert(config).second) {
+            return;
+        }
+        compile_workers->QueueWork([this, config, raw = std::move(raw)](
+                                       Frontend::GraphicsContext::Scoped*) mutable {
+            auto result = GenerateFragmentShader(config, true);
+            auto program = BuildProgram(result.code, GL_FRAGMENT_SHADER);
+            finished_work.Push([this, config, raw = std::move(raw), result = std::move(result),
+                                program = std::move(program)]() mutable {
+                pending_fragment_shaders.erase(config);
+                fragment_shaders.Inject(config, std::move(program));
+                disk_cache.SaveRaw(raw);
+                disk_cache.SaveDecompiled(raw.GetUniqueIdentifier(), result, false);
+
+                if (awaiting_fragment_shader && config == awaited_fragment_shader) {
+                    current.fs = fragment_shaders.Find(config);
+                    awaiting_fragment_shader = false;
+                    uber_shader_active = false;
+                }
+            });
+        });
+    }
+
+    /// Builds the vertex shader for the config on a compile worker unless already queued.
+    void QueueVertexShader(const PicaVSConfig& config, ShaderDiskCacheRaw raw) {
+        if (!pending_vertex_shaders.insert(config).second) {
+            return;
+        }
+        const bool sanitize_mul = VideoCore::g_hw_shader_accurate_mul;
+        compile_workers->QueueWork([this, config, sanitize_mul, raw = std::move(raw)](
+                                       Frontend::GraphicsContext::Scoped*) mutable {
+            const auto setup = std::get<Pica::Shader::ShaderSetup>(BuildVSConfigFromRaw(raw));
+            auto result = GenerateVertexShader(setup, config, true);
+            OGLProgram program;
+            if (result) {
+                program = BuildProgram(result->code, GL_VERTEX_SHADER);
+            }
+            finished_work.Push([this, config, sanitize_mul, raw = std::move(raw),
+                                result = std::move(result),
+                                program = std::move(program)]() mutable {
+                pending_vertex_shaders.erase(config);
+                if (!result) {
+                    // Not supported by the decompiler, keep using the software vertex pipeline
+                    programmable_vertex_shaders.MarkUnsupported(config);
+                    return;
+                }
+                disk_cache.SaveRaw(raw);
+                disk_cache.SaveDecompiled(raw.GetUniqueIdentifier(), *result, sanitize_mul);
+                programmable_vertex_shaders.Inject(config, std::move(result->code),
+                                                   std::move(program));
+            });
+        });
+    }
+
+    /// Runs the work handed back by the compile workers. This moves the finished programs into the
+    /// caches and applies their uniform and sampler bindings, which go through the state of the
+    /// render thread.
+    void RunFinishedWork() {
+        Common::UniqueFunction<void> work;
+        while (finished_work.Pop(work)) {
+            work();
+        }
+    }
+
+    /// Counts a program that was compiled on the render thread.
+    void CountBlockingCompile(std::chrono::steady_clock::time_point start) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        frame_stats.programs_built++;
+        frame_stats.compile_time += elapsed;
+        frame_stats.blocking_time += elapsed;
     }
 
     struct ShaderTuple {
@@ -366,20 +509,77 @@ public:
     std::unordered_map<u64, OGLProgram> program_cache;
     OGLPipeline pipeline;
     ShaderDiskCache disk_cache;
+
+    OGLShaderStage uber_fragment_shader;
+    UberFSConfigData uber_shader_config{};
+    bool uber_shader_active = false;
+
+    PicaFSConfig awaited_fragment_shader{};
+    bool awaiting_fragment_shader = false;
+    bool skip_for_fragment_shader = false;
+    bool skip_for_vertex_shader = false;
+
+    ShaderCompileStats frame_stats{};
+    ShaderCompileStats last_frame_stats{};
+    std::atomic<u64> async_compile_time{};
+    std::atomic<u32> async_programs_built{};
+
+    std::unordered_set<PicaFSConfig> pending_fragment_shaders;
+    std::unordered_set<PicaVSConfig> pending_vertex_shaders;
+    Common::MPSCQueue<Common::UniqueFunction<void>> finished_work;
+    std::vector<std::unique_ptr<Frontend::GraphicsContext>> compile_contexts;
+    // Declared last so that the workers are stopped before anything they use is destroyed
+    std::unique_ptr<Common::StatefulThreadWorker<Frontend::GraphicsContext::Scoped>>
+        compile_workers;
 };
 
 ShaderProgramManager::ShaderProgramManager(Frontend::EmuWindow& emu_window_, const Driver& driver_,
                                            bool separable)
     : emu_window{emu_window_}, driver{driver_},
-      strict_context_required{emu_window.StrictContextRequired()}, impl{std::make_unique<Impl>(
-                                                                       separable)} {}
+      strict_context_required{emu_window.StrictContextRequired()},
+      impl{std::make_unique<Impl>(
+          emu_window, separable,
+          Settings::values.async_shader_compilation.GetValue() && separable &&
+              !strict_context_required)} {}
 
 ShaderProgramManager::~ShaderProgramManager() = default;
 
 bool ShaderProgramManager::UseProgrammableVertexShader(const Pica::Regs& regs,
                                                        Pica::Shader::ShaderSetup& setup) {
     PicaVSConfig config{regs.vs, setup};
+    if (impl->compile_workers) {
+        impl->skip_for_vertex_shader = false;
+        if (const auto handle = impl->programmable_vertex_shaders.Find(config)) {
+            if (*handle == 0)
+                return false;
+            impl->current.vs = *handle;
+            impl->current.vs_hash = config.Hash();
+            return true;
+        }
+
+        if (!impl->pending_vertex_shaders.contains(config)) {
+            ProgramCode program_code{setup.program_code.begin(), setup.program_code.end()};
+            program_code.insert(program_code.end(), setup.swizzle_data.begin(),
+                                setup.swizzle_data.end());
+            const u64 unique_identifier = GetUniqueIdentifier(regs, program_code);
+            impl->QueueVertexShader(config, ShaderDiskCacheRaw{unique_identifier, ProgramType::VS,
+                                                               regs, std::move(program_code)});
+        }
+        if (Settings::values.async_shader_fallback.GetValue() ==
+            Settings::AsyncShaderFallback::Skip) {
+            impl->skip_for_vertex_shader = true;
+            return true;
+        }
+        // Geometry can't be drawn with another vertex program, process the vertices with the
+        // software shader in the meantime instead
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
     auto [handle, result] = impl->programmable_vertex_shaders.Get(config, setup);
+    if (result) {
+        impl->CountBlockingCompile(start);
+    }
     if (handle == 0)
         return false;
     impl->current.vs = handle;
@@ -403,6 +603,7 @@ bool ShaderProgramManager::UseProgrammableVertexShader(const Pica::Regs& regs,
 void ShaderProgramManager::UseTrivialVertexShader() {
     impl->current.vs = impl->trivial_vertex_shader.Get();
     impl->current.vs_hash = 0;
+    impl->skip_for_vertex_shader = false;
 }
 
 void ShaderProgramManager::UseFixedGeometryShader(const Pica::Regs& regs) {
@@ -419,11 +620,50 @@ void ShaderProgramManager::UseTrivialGeometryShader() {
 
 void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs, bool use_normal) {
     PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs, use_normal);
+    if (impl->compile_workers) {
+        impl->current.fs_hash = config.Hash();
+        impl->awaiting_fragment_shader = false;
+        impl->skip_for_fragment_shader = false;
+        if (const GLuint handle = impl->fragment_shaders.Find(config); handle != 0) {
+            impl->current.fs = handle;
+            impl->uber_shader_active = false;
+            return;
+        }
+
+        if (!impl->pending_fragment_shaders.contains(config)) {
+            const u64 unique_identifier = GetUniqueIdentifier(regs, {});
+            impl->QueueFragmentShader(
+                config, ShaderDiskCacheRaw{unique_identifier, ProgramType::FS, regs, {}});
+        }
+        impl->awaited_fragment_shader = config;
+        impl->awaiting_fragment_shader = true;
+
+        switch (Settings::values.async_shader_fallback.GetValue()) {
+        case Settings::AsyncShaderFallback::Skip:
+            impl->skip_for_fragment_shader = true;
+            return;
+        case Settings::AsyncShaderFallback::Previous:
+            // Every fragment program reads the same vertex outputs, so any of them can stand in
+            if (impl->current.fs != 0) {
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+        impl->current.fs = impl->uber_fragment_shader.GetHandle();
+        impl->uber_shader_config.SetFromConfig(config);
+        impl->uber_shader_active = true;
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
     auto [handle, result] = impl->fragment_shaders.Get(config);
     impl->current.fs = handle;
     impl->current.fs_hash = config.Hash();
     // Save FS to the disk cache if its a new shader
     if (result) {
+        impl->CountBlockingCompile(start);
         auto& disk_cache = impl->disk_cache;
         u64 unique_identifier = GetUniqueIdentifier(regs, {});
         ShaderDiskCacheRaw raw{unique_identifier, ProgramType::FS, regs, {}};
@@ -432,7 +672,20 @@ void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs, bool use_no
     }
 }
 
-void ShaderProgramManager::ApplyTo(OpenGLState& state) {
+const UberFSConfigData* ShaderProgramManager::GetUberShaderConfig() const {
+    return impl->uber_shader_active ? &impl->uber_shader_config : nullptr;
+}
+
+bool ShaderProgramManager::ApplyTo(OpenGLState& state) {
+    if (impl->compile_workers) {
+        impl->RunFinishedWork();
+        if (impl->skip_for_vertex_shader ||
+            (impl->skip_for_fragment_shader && impl->awaiting_fragment_shader)) {
+            impl->frame_stats.draws_skipped++;
+            return false;
+        }
+    }
+
     if (impl->separable) {
         if (driver.HasBug(DriverBug::ShaderStageChangeFreeze)) {
             glUseProgramStages(
@@ -449,7 +702,9 @@ void ShaderProgramManager::ApplyTo(OpenGLState& state) {
         const u64 unique_identifier = impl->current.GetConfigHash();
         OGLProgram& cached_program = impl->program_cache[unique_identifier];
         if (cached_program.handle == 0) {
+            const auto start = std::chrono::steady_clock::now();
             cached_program.Create(false, {impl->current.vs, impl->current.gs, impl->current.fs});
+            impl->CountBlockingCompile(start);
             auto& disk_cache = impl->disk_cache;
             disk_cache.SaveDumpToFile(unique_identifier, cached_program.handle,
                                       VideoCore::g_hw_shader_accurate_mul);
@@ -459,6 +714,29 @@ void ShaderProgramManager::ApplyTo(OpenGLState& state) {
         }
         state.draw.shader_program = cached_program.handle;
     }
+    return true;
+}
+
+void ShaderProgramManager::TickFrame() {
+    auto& stats = impl->frame_stats;
+    stats.programs_built += impl->async_programs_built.exchange(0);
+    stats.compile_time += std::chrono::nanoseconds{impl->async_compile_time.exchange(0)};
+    stats.programs_pending = static_cast<u32>(impl->pending_fragment_shaders.size() +
+                                              impl->pending_vertex_shaders.size());
+    if (stats.programs_built != 0 || stats.draws_skipped != 0) {
+        using std::chrono::duration_cast, std::chrono::microseconds;
+        LOG_DEBUG(Render_OpenGL,
+                  "Built {} shader programs in {} us ({} us on the render thread), {} pending, {} "
+                  "draws skipped",
+                  stats.programs_built, duration_cast<microseconds>(stats.compile_time).count(),
+                  duration_cast<microseconds>(stats.blocking_time).count(), stats.programs_pending,
+                  stats.draws_skipped);
+    }
+    impl->last_frame_stats = std::exchange(stats, {});
+}
+
+ShaderCompileStats ShaderProgramManager::GetLastFrameStats() const {
+    return impl->last_frame_stats;
 }
 
 void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
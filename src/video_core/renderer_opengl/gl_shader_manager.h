@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
 
 namespace Frontend {
@@ -23,6 +25,16 @@ namespace OpenGL {
 
 class Driver;
 class OpenGLState;
+struct UberFSConfigData;
+
+/// Shader compilation work done during one frame.
+struct ShaderCompileStats {
+    u32 programs_built = 0;                   ///< Programs compiled and linked on any thread
+    u32 programs_pending = 0;                 ///< Programs still queued when the frame ended
+    u32 draws_skipped = 0;                    ///< Draws skipped as their shaders were not ready
+    std::chrono::nanoseconds compile_time{};  ///< Compile time summed over all threads
+    std::chrono::nanoseconds blocking_time{}; ///< Time the render thread spent compiling
+};
 
 /// A class that manage different shader stages and configures them with given config data.
 class ShaderProgramManager {
@@ -43,7 +55,21 @@ public:
 
     void UseFragmentShader(const Pica::Regs& config, bool use_normal);
 
-    void ApplyTo(OpenGLState& state);
+    /// Returns the configuration to upload for the uber fragment shader, or nullptr if a
+    /// specialized fragment shader is in use.
+    const UberFSConfigData* GetUberShaderConfig() const;
+
+    /**
+     * Binds the current shader stages to the state.
+     * @returns false if the draw should be skipped because its shaders are still being compiled.
+     */
+    bool ApplyTo(OpenGLState& state);
+
+    /// Collects the compile statistics of the frame that just ended.
+    void TickFrame();
+
+    /// Returns the compile statistics of the last completed frame.
+    ShaderCompileStats GetLastFrameStats() const;
 
 private:
     Frontend::EmuWindow& emu_window;
@@ -99,4 +99,24 @@ void OGLStreamBuffer::Unmap(GLsizeiptr size) {
     buffer_pos += size;
 }
 
+static u64 MakeUploadKey(PAddr addr, u32 size) {
+    return static_cast<u64>(addr) << 32 | size;
+}
+
+std::optional<GLintptr> StreamUploadCache::Find(PAddr addr, u32 size, u64 hash) const {
+    const auto it = uploads.find(MakeUploadKey(addr, size));
+    if (it == uploads.end() || it->second.hash != hash) {
+        return std::nullopt;
+    }
+    return it->second.offset;
+}
+
+void StreamUploadCache::Insert(PAddr addr, u32 size, u64 hash, GLintptr offset) {
+    uploads.insert_or_assign(MakeUploadKey(addr, size), Upload{hash, offset});
+}
+
+void StreamUploadCache::Clear() {
+    uploads.clear();
+}
+
 } // namespace OpenGL
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <optional>
 #include <tuple>
+#include <unordered_map>
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 
 namespace OpenGL {
@@ -46,4 +48,30 @@ private:
     u8* mapped_ptr = nullptr;
 };
 
+/**
+ * Remembers where guest data was copied to in a stream buffer, so that draws sourcing the same
+ * unmodified data can use the earlier copy instead of uploading it again. Entries are validated
+ * with a hash of the guest data and must be cleared whenever Map reports that the previous chunks
+ * of the stream buffer were invalidated.
+ */
+class StreamUploadCache {
+public:
+    /// Returns the offset of the data uploaded from the given range with the given hash, if any
+    std::optional<GLintptr> Find(PAddr addr, u32 size, u64 hash) const;
+
+    /// Records that the data of the given range was uploaded to the given offset
+    void Insert(PAddr addr, u32 size, u64 hash, GLintptr offset);
+
+    /// Forgets all uploads, must be called when the stream buffer is invalidated
+    void Clear();
+
+private:
+    struct Upload {
+        u64 hash;
+        GLintptr offset;
+    };
+
+    std::unordered_map<u64, Upload> uploads;
+};
+
 } // namespace OpenGL
@@ -412,12 +412,12 @@ void Surface::UploadCustom(const VideoCore::Material* material, u32 level) {
     const auto upload = [&](u32 index, VideoCore::CustomTexture* texture) {
         glBindTexture(GL_TEXTURE_2D, Handle(index));
         if (VideoCore::IsCustomFormatCompressed(custom_format)) {
-            const GLsizei image_size = static_cast<GLsizei>(texture->data.size());
+            const GLsizei image_size = static_cast<GLsizei>(texture->Data().size());
             glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, tuple.format,
-                                      image_size, texture->data.data());
+                                      image_size, texture->Data().data());
         } else {
             glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, tuple.format, tuple.type,
-                            texture->data.data());
+                            texture->Data().data());
         }
     };
 
@@ -15,7 +15,7 @@ namespace Pica::Shader {
 
 struct ShaderSetup;
 
-enum class UniformBindings : u32 { Common, VS, GS };
+enum class UniformBindings : u32 { Common, VS, GS, FSConfig };
 
 struct LightSrc {
     alignas(16) Common::Vec3f specular_0;
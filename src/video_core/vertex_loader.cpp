@@ -1,9 +1,11 @@
+#include <cstring>
 #include <memory>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_ref.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -16,6 +18,46 @@
 
 namespace Pica {
 
+namespace {
+
+/**
+ * Loads an attribute of NumElements elements of type T. Both are known at compile time so this
+ * compiles down to straight-line conversion code, with the elements copied out with memcpy as
+ * attribute arrays are only aligned to their element size.
+ */
+template <typename T, u32 NumElements>
+void LoadAttribute(const u8* source, Common::Vec4<float24>& attribute) {
+    std::array<T, NumElements> data;
+    std::memcpy(data.data(), source, sizeof(data));
+    for (u32 comp = 0; comp < NumElements; ++comp) {
+        attribute[comp] = float24::FromFloat32(static_cast<float>(data[comp]));
+    }
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (u32 comp = NumElements; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+template <typename T>
+constexpr std::array<VertexLoader::AttributeLoadFn, 4> AttributeLoaders = {
+    &LoadAttribute<T, 1>,
+    &LoadAttribute<T, 2>,
+    &LoadAttribute<T, 3>,
+    &LoadAttribute<T, 4>,
+};
+
+/// Attribute loaders indexed by VertexAttributeFormat and number of elements minus one.
+constexpr std::array<std::array<VertexLoader::AttributeLoadFn, 4>, 4> LOADERS = {
+    AttributeLoaders<s8>,
+    AttributeLoaders<u8>,
+    AttributeLoaders<s16>,
+    AttributeLoaders<float>,
+};
+
+} // Anonymous namespace
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -67,95 +109,81 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
+    // Select the loading routine of each attribute once, so that loading a vertex doesn't need to
+    // dispatch on the format and number of elements of every attribute.
+    for (int i = 0; i < num_total_attributes; ++i) {
+        const u32 elements = vertex_attribute_elements[i];
+        if (elements != 0) {
+            const auto format = static_cast<std::size_t>(vertex_attribute_formats[i]);
+            attribute_loaders[i] = LOADERS[format][elements - 1];
+            attribute_sizes[i] = elements * attribute_config.GetElementSizeInBytes(i);
+            loaded_attributes[num_loaded_attributes++] = i;
+        } else if (vertex_attribute_is_default[i]) {
+            default_attributes[num_default_attributes++] = i;
+        } else {
+            // TODO(yuriks): In this case, no data gets loaded and the vertex
+            // remains with the last value it had. This isn't currently maintained
+            // as global state, however, and so won't work in Citra yet.
+        }
+    }
+
     is_setup = true;
 }
 
+void VertexLoader::ResolveSources(u32 base_address) {
+    for (int j = 0; j < num_loaded_attributes; ++j) {
+        const u32 i = loaded_attributes[j];
+        const MemoryRef source =
+            VideoCore::g_memory->GetPhysicalRef(base_address + vertex_attribute_sources[i]);
+        source_pointers[i] = source.GetPtr();
+        source_sizes[i] = source ? source.GetSize() : 0;
+    }
+    resolved_base_address = base_address;
+    is_resolved = true;
+}
+
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
                               DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
-    for (int i = 0; i < num_total_attributes; ++i) {
-        if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                         : (vertex_attribute_formats[i] ==
-                            PipelineRegs::VertexAttributeFormat::SHORT)
-                             ? 2
-                             : 1));
-            }
-
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
+    if (!is_resolved || base_address != resolved_base_address) {
+        ResolveSources(base_address);
+    }
 
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
+    for (int j = 0; j < num_loaded_attributes; ++j) {
+        const u32 i = loaded_attributes[j];
+        // Load per-vertex data from the loader arrays
+        const u32 offset = vertex_attribute_strides[i] * vertex;
+        const u32 source_addr = base_address + vertex_attribute_sources[i] + offset;
 
-            LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else {
-            // TODO(yuriks): In this case, no data gets loaded and the vertex
-            // remains with the last value it had. This isn't currently maintained
-            // as global state, however, and so won't work in Citra yet.
+        if (g_debug_context && Pica::g_debug_context->recorder) {
+            memory_accesses.AddAccess(source_addr, attribute_sizes[i]);
         }
+
+        // Vertices outside of the memory region the array starts in are looked up on their own.
+        const u8* source = static_cast<std::size_t>(offset) + attribute_sizes[i] <= source_sizes[i]
+                               ? source_pointers[i] + offset
+                               : VideoCore::g_memory->GetPhysicalPointer(source_addr);
+        attribute_loaders[i](source, input.attr[i]);
+
+        LOG_TRACE(HW_GPU,
+                  "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
+                  "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
+                  vertex_attribute_elements[i], i, vertex, index, base_address,
+                  vertex_attribute_sources[i], offset, input.attr[i][0].ToFloat32(),
+                  input.attr[i][1].ToFloat32(), input.attr[i][2].ToFloat32(),
+                  input.attr[i][3].ToFloat32());
+    }
+
+    for (int j = 0; j < num_default_attributes; ++j) {
+        const u32 i = default_attributes[j];
+        // Load the default attribute if we're configured to do so
+        input.attr[i] = g_state.input_default_attributes.attr[i];
+        LOG_TRACE(HW_GPU,
+                  "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})",
+                  i, vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
+                  input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
     }
 }
 
@@ -2,6 +2,8 @@
 
 #include <array>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -16,6 +18,9 @@ struct AttributeBuffer;
 
 class VertexLoader {
 public:
+    /// Converts the elements of one attribute and fills the missing components with defaults.
+    using AttributeLoadFn = void (*)(const u8* source, Common::Vec4<float24>& attribute);
+
     VertexLoader() = default;
     explicit VertexLoader(const PipelineRegs& regs) {
         Setup(regs);
@@ -30,6 +35,9 @@ public:
     }
 
 private:
+    /// Looks up the host pointers of the attribute arrays starting at the given base address.
+    void ResolveSources(u32 base_address);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -37,6 +45,22 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    // Layout resolved by Setup, the attributes loaded from memory and the ones taken from the
+    // default attribute registers, each with the routine specialized for their format and size.
+    std::array<u32, 16> loaded_attributes;
+    std::array<u32, 16> default_attributes;
+    std::array<AttributeLoadFn, 16> attribute_loaders{};
+    std::array<u32, 16> attribute_sizes{};
+    int num_loaded_attributes = 0;
+    int num_default_attributes = 0;
+
+    // Host pointers of the attribute arrays and how many bytes can be read through them, as the
+    // base address is the same for all vertices of a draw.
+    std::array<const u8*, 16> source_pointers{};
+    std::array<std::size_t, 16> source_sizes{};
+    u32 resolved_base_address = 0;
+    bool is_resolved = false;
 };
 
 } // namespace Pica
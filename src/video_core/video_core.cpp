@@ -24,6 +24,7 @@ namespace VideoCore {
 std::unique_ptr<RendererBase> g_renderer{}; ///< Renderer plugin
 
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_parallel_geometry_shader;
 std::atomic<bool> g_hw_shader_enabled;
 std::atomic<bool> g_hw_shader_accurate_mul;
 
@@ -32,6 +32,7 @@ extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
 extern std::atomic<bool> g_shader_jit_enabled;
+extern std::atomic<bool> g_parallel_geometry_shader;
 extern std::atomic<bool> g_hw_shader_enabled;
 extern std::atomic<bool> g_hw_shader_accurate_mul;
 